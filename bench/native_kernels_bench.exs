@@ -0,0 +1,136 @@
+# Native Kernel Micro-Benchmark
+#
+# Measures the NIF decode and encode kernels on synthetic data, without a
+# ClickHouse server, so the numbers carry no network or server noise:
+#
+# - decode/terms: select.cpp's column decoder, the kernel behind
+#   select_rows, select_cols and streams
+# - decode/packed: packed.cpp's buffer packing (select_packed, select_arrow)
+# - encode: Natch.Block.build_block/2, the column.cpp appenders behind
+#   every INSERT
+#
+# Each row reports ns per value and native allocations (operator new calls
+# and bytes) per value. Decode columns are built natively from the
+# ClickHouse type name; encode values are built in Elixir first and not
+# timed.
+#
+# Usage:
+#   NATCH_BUILD_BENCH=1 mix compile --force
+#   mix run bench/native_kernels_bench.exs [rows] [iterations]
+#
+# The bench NIFs replace the global operator new to count allocations, so
+# rebuild without NATCH_BUILD_BENCH before using the library for anything
+# else.
+
+defmodule NativeKernelsBench do
+  alias Natch.Native
+
+  # {natch type, ClickHouse type, value for row i}
+  @types [
+    {:uint8, "UInt8", &rem(&1, 251)},
+    {:uint64, "UInt64", & &1},
+    {:int32, "Int32", &(&1 - 1000)},
+    {:float64, "Float64", &(&1 * 0.25)},
+    {:string, "String", &"value_#{rem(&1, 4096)}"},
+    {:date, "Date", &Date.add(~D[2022-01-01], rem(&1, 1000))},
+    {:datetime, "DateTime", &(1_700_000_000 + &1)},
+    {:datetime64, "DateTime64(6)", &(1_700_000_000_000_000 + &1)},
+    {:uuid, "UUID", &<<&1::64, -&1::64>>},
+    {:decimal, "Decimal64(9)", &Decimal.new(&1)},
+    {{:nullable, :uint64}, "Nullable(UInt64)", &if(rem(&1, 5) == 0, do: nil, else: &1)},
+    {{:nullable, :string}, "Nullable(String)", &if(rem(&1, 5) == 0, do: nil, else: "s#{&1}")},
+    {{:array, :uint64}, "Array(UInt64)", &[&1, &1 + 1]},
+    {{:map, :string, :uint64}, "Map(String, UInt64)", &%{"k#{rem(&1, 16)}" => &1}},
+    {{:tuple, [:string, :uint64]}, "Tuple(String, UInt64)", &{"t#{rem(&1, 16)}", &1}},
+    {{:low_cardinality, :string}, "LowCardinality(String)", &"lc#{rem(&1, 16)}"},
+    {{:enum8, [{"a", 1}, {"b", 2}]}, "Enum8('a' = 1, 'b' = 2)", &Enum.at(["a", "b"], rem(&1, 2))}
+  ]
+
+  def run(args) do
+    {rows, iterations} =
+      case args do
+        [rows, iterations] -> {String.to_integer(rows), String.to_integer(iterations)}
+        [rows] -> {String.to_integer(rows), 20}
+        [] -> {100_000, 20}
+      end
+
+    ensure_bench_build!()
+
+    IO.puts("\n=== Native Kernel Benchmark (#{rows} rows x #{iterations} runs) ===\n")
+    print_header()
+
+    for {type, clickhouse_type, value} <- @types do
+      for kernel <- [:terms, :packed] do
+        result = decode(clickhouse_type, rows, iterations, kernel)
+        print_row(clickhouse_type, "decode/#{kernel}", result)
+      end
+
+      print_row(clickhouse_type, "encode", encode(type, value, rows, iterations))
+    end
+
+    IO.puts("\n✓ Benchmark complete!")
+  end
+
+  defp ensure_bench_build! do
+    Native.bench_allocations()
+  rescue
+    ErlangError ->
+      IO.puts("The bench NIFs are not built. Run: NATCH_BUILD_BENCH=1 mix compile --force")
+      System.halt(1)
+  end
+
+  defp decode(clickhouse_type, rows, iterations, kernel) do
+    %{"ns" => ns, "allocations" => allocs, "allocated_bytes" => bytes, "values" => values} =
+      Native.bench_decode(clickhouse_type, rows, iterations, kernel, false, false)
+
+    {ns / values, allocs / values, bytes / values}
+  rescue
+    # Types without a packed layout
+    _ -> nil
+  end
+
+  defp encode(type, value, rows, iterations) do
+    columns = %{value: Enum.map(0..(rows - 1), value)}
+    schema = [value: type]
+    Natch.Block.build_block(columns, schema)
+
+    {allocs_before, bytes_before} = Native.bench_allocations()
+
+    {micros, _} =
+      :timer.tc(fn ->
+        for _ <- 1..iterations, do: Natch.Block.build_block(columns, schema)
+      end)
+
+    {allocs_after, bytes_after} = Native.bench_allocations()
+    values = rows * iterations
+
+    {micros * 1000 / values, (allocs_after - allocs_before) / values,
+     (bytes_after - bytes_before) / values}
+  end
+
+  defp print_header do
+    IO.puts(
+      String.pad_trailing("type", 26) <>
+        String.pad_trailing("kernel", 15) <>
+        String.pad_leading("ns/value", 10) <>
+        String.pad_leading("allocs/value", 14) <>
+        String.pad_leading("bytes/value", 13)
+    )
+  end
+
+  defp print_row(type, kernel, nil) do
+    IO.puts(String.pad_trailing(type, 26) <> String.pad_trailing(kernel, 15) <> "  n/a")
+  end
+
+  defp print_row(type, kernel, {ns, allocs, bytes}) do
+    IO.puts(
+      String.pad_trailing(type, 26) <>
+        String.pad_trailing(kernel, 15) <>
+        String.pad_leading(:erlang.float_to_binary(ns, decimals: 1), 10) <>
+        String.pad_leading(:erlang.float_to_binary(allocs, decimals: 3), 14) <>
+        String.pad_leading(:erlang.float_to_binary(bytes, decimals: 1), 13)
+    )
+  end
+end
+
+NativeKernelsBench.run(System.argv())
@@ -0,0 +1,114 @@
+# Scheduler Latency Benchmark
+#
+# Measures how responsive the BEAM schedulers stay while Natch runs a large
+# SELECT. One probe process per online scheduler repeatedly asks for a 1ms
+# timer and records how late it actually wakes up. A NIF that blocks a normal
+# scheduler shows up as multi-millisecond (or multi-second) lateness.
+#
+# Usage:
+#   mix run bench/scheduler_latency_bench.exs
+#
+# Requires ClickHouse running:
+#   docker-compose up -d
+
+defmodule SchedulerLatencyBench do
+  @probe_interval_ms 1
+  @rows 5_000_000
+
+  def run do
+    IO.puts("\n=== Scheduler Latency Benchmark ===\n")
+
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000, database: "default")
+
+    schedulers = :erlang.system_info(:schedulers_online)
+    IO.puts("Schedulers online: #{schedulers}")
+    IO.puts("Dirty I/O schedulers: #{:erlang.system_info(:dirty_io_schedulers)}")
+    IO.puts("Dirty CPU schedulers: #{:erlang.system_info(:dirty_cpu_schedulers_online)}\n")
+
+    query = "SELECT number, toString(number) AS s, number * 1.5 AS f FROM numbers(#{@rows})"
+
+    IO.puts("Baseline (idle) for 2s...")
+    idle = measure(schedulers, fn -> Process.sleep(2_000) end)
+
+    IO.puts("During select_cols of #{@rows} rows...")
+    cols = measure(schedulers, fn -> {:ok, _} = Natch.select_cols(conn, query) end)
+
+    row_count = div(@rows, 5)
+    row_query = "SELECT number, toString(number) AS s FROM numbers(#{row_count})"
+
+    IO.puts("During select_rows of #{row_count} rows...")
+    rows = measure(schedulers, fn -> {:ok, _} = Natch.select_rows(conn, row_query) end)
+
+    IO.puts("")
+    print_header()
+    print_row("idle", idle)
+    print_row("select_cols", cols)
+    print_row("select_rows", rows)
+
+    GenServer.stop(conn)
+    IO.puts("\n✓ Benchmark complete!")
+  end
+
+  # Runs `workload` while one probe per scheduler samples timer lateness.
+  # Returns all lateness samples in microseconds.
+  defp measure(schedulers, workload) do
+    parent = self()
+
+    probes =
+      for id <- 1..schedulers do
+        spawn_opt(fn -> probe_loop(parent, []) end, scheduler: id)
+      end
+
+    workload.()
+
+    Enum.flat_map(probes, fn pid ->
+      send(pid, :stop)
+
+      receive do
+        {:samples, ^pid, samples} -> samples
+      end
+    end)
+  end
+
+  defp probe_loop(parent, samples) do
+    started = System.monotonic_time(:microsecond)
+
+    receive do
+      :stop -> send(parent, {:samples, self(), samples})
+    after
+      @probe_interval_ms ->
+        late = System.monotonic_time(:microsecond) - started - @probe_interval_ms * 1000
+        probe_loop(parent, [max(late, 0) | samples])
+    end
+  end
+
+  defp print_header do
+    IO.puts(
+      String.pad_trailing("scenario", 14) <>
+        String.pad_leading("samples", 10) <>
+        String.pad_leading("p50 µs", 10) <>
+        String.pad_leading("p99 µs", 10) <>
+        String.pad_leading("max µs", 12)
+    )
+  end
+
+  defp print_row(name, samples) do
+    sorted = Enum.sort(samples)
+
+    IO.puts(
+      String.pad_trailing(name, 14) <>
+        String.pad_leading(Integer.to_string(length(sorted)), 10) <>
+        String.pad_leading(Integer.to_string(percentile(sorted, 0.50)), 10) <>
+        String.pad_leading(Integer.to_string(percentile(sorted, 0.99)), 10) <>
+        String.pad_leading(Integer.to_string(List.last(sorted) || 0), 12)
+    )
+  end
+
+  defp percentile([], _p), do: 0
+
+  defp percentile(sorted, p) do
+    Enum.at(sorted, min(round(p * length(sorted)), length(sorted) - 1))
+  end
+end
+
+SchedulerLatencyBench.run()
@@ -42,7 +42,25 @@ defmodule Natch do
   - `:database` - Database name (default: "default")
   - `:user` - Username (default: "default")
   - `:password` - Password (default: "")
-  - `:compression` - Enable LZ4 compression (default: true)
+  - `:compression` - Network compression: `:lz4` (or `true`), `:none` (or
+    `false`), `:zstd` / `{:zstd, level}` (level 1-22, default 1) or
+    `:adaptive` / `{:adaptive, zstd_level}`, which runs each query with LZ4
+    or ZSTD, whichever has been receiving results faster (default: `:lz4`)
+  - `:strings` - How String columns are returned: `:copy` allocates one binary
+    per value, `:sub_binary` copies each column block into one binary and
+    returns sub-binaries of it (default: `:copy`). `:sub_binary` is much
+    cheaper for many short strings, but any value kept alive keeps its whole
+    block alive; `:binary.copy/1` values you retain long-term.
+  - `:enums` - Return Enum8/Enum16 values as `:string` binaries or as `:atom`s
+    (default: `:string`)
+  - `:decode_threads` - Decode the columns of large result blocks on up to
+    this many native threads (default: 1). Only pays off for wide blocks of
+    thousands of rows; values repeated by LowCardinality and Enum columns
+    are no longer shared between rows when decoded in parallel.
+  - `:query_timeout` - Deadline in milliseconds for each query, counted from
+    when it is queued (default: `:infinity`). A query past its deadline is
+    cancelled on the server and returns `{:error, :timeout}`; the connection
+    stays usable. Queries whose caller exits are cancelled the same way.
   - `:name` - Process name for registration (optional)
 
   ## Supported Types
@@ -55,6 +73,33 @@ defmodule Natch do
   - `:datetime` - DateTime (Unix timestamp)
 
   More types coming in Phase 5 (Nullable, Array, Date, Bool, Decimal, etc.)
+
+  ## Telemetry
+
+  Every query and execute run by a connection emits one of two
+  `:telemetry` events when it finishes:
+
+  - `[:natch, :query, :stop]` - measurements are `:duration` (native time
+    units, from queueing to reply) and the query's native counters:
+    `:blocks`, `:rows`, `:result_bytes` (uncompressed size of the result
+    blocks), `:read_rows`, `:read_bytes`, `:written_rows` and
+    `:written_bytes` (from the server's progress packets),
+    `:progress_packets`, `:profile_packets`, `:rows_before_limit`,
+    `:term_bytes` (estimated heap size of the result terms) and, in
+    nanoseconds, `:receive_ns` (server work, network and decompression),
+    `:first_block_ns` (until the first data block) and `:decode_ns` (building
+    the result). Metadata holds `:kind`, `:query`, `:compression` and
+    `:compression_level` (the codec the result was sent with) and
+    `:decode_ns_by_type`, a map of column type names to their share of
+    `:decode_ns`.
+  - `[:natch, :query, :exception]` - measurements are `:duration`;
+    metadata holds `:kind`, `:query`, `:compression`, `:compression_level`
+    and `:reason`.
+
+  `:kind` is `:execute`, `:select_rows`, `:select_cols`, `:select_tuples`,
+  `:select_packed`, `:select_arrow`, `:select_lazy` or `:stream_cols` (whose
+  `:duration` runs until the last block is sent). `Natch.Pool` queries emit
+  them too; inserts don't.
   """
 
   alias Natch.Connection
@@ -138,7 +183,25 @@ defmodule Natch do
   - `:database` - Database name (default: "default")
   - `:user` - Username (default: "default")
   - `:password` - Password (default: "")
-  - `:compression` - Enable LZ4 compression (default: true)
+  - `:compression` - Network compression: `:lz4` (or `true`), `:none` (or
+    `false`), `:zstd` / `{:zstd, level}` (level 1-22, default 1) or
+    `:adaptive` / `{:adaptive, zstd_level}`, which runs each query with LZ4
+    or ZSTD, whichever has been receiving results faster (default: `:lz4`)
+  - `:strings` - How String columns are returned: `:copy` allocates one binary
+    per value, `:sub_binary` copies each column block into one binary and
+    returns sub-binaries of it (default: `:copy`). `:sub_binary` is much
+    cheaper for many short strings, but any value kept alive keeps its whole
+    block alive; `:binary.copy/1` values you retain long-term.
+  - `:enums` - Return Enum8/Enum16 values as `:string` binaries or as `:atom`s
+    (default: `:string`)
+  - `:decode_threads` - Decode the columns of large result blocks on up to
+    this many native threads (default: 1). Only pays off for wide blocks of
+    thousands of rows; values repeated by LowCardinality and Enum columns
+    are no longer shared between rows when decoded in parallel.
+  - `:query_timeout` - Deadline in milliseconds for each query, counted from
+    when it is queued (default: `:infinity`). A query past its deadline is
+    cancelled on the server and returns `{:error, :timeout}`; the connection
+    stays usable. Queries whose caller exits are cancelled the same way.
   - `:name` - Process name for registration (optional)
 
   ## Examples
@@ -375,6 +438,341 @@ defmodule Natch do
     end
   end
 
+  @doc """
+  Executes a SELECT query and returns the column names once and each row as
+  a tuple of its values, in column order.
+
+  A row map carries its own copy of the column names, so a result of many
+  narrow rows takes several times the heap of `select_cols/2`. Row tuples
+  hold only the values, like records; use them when you want rows but not
+  the per-row keys.
+
+  ## Examples
+
+      {:ok, {[:id, :name], rows}} = Natch.select_tuples(conn, "SELECT id, name FROM users")
+      # rows => [{1, "Alice"}, {2, "Bob"}]
+
+      for {id, name} <- rows, do: IO.puts("\#{id}: \#{name}")
+  """
+  @spec select_tuples(conn(), String.t() | Natch.Query.t()) ::
+          {:ok, {[atom()], [tuple()]}} | {:error, term()}
+  def select_tuples(conn, query_or_sql) do
+    Connection.select_tuples(conn, query_or_sql)
+  end
+
+  @doc """
+  Executes a SELECT query and returns every column as packed binaries.
+
+  Instead of one term per value, each column's values from all result blocks
+  are copied into contiguous native-endian buffers, ready for Nx tensors or
+  Explorer/Arrow arrays. Each column maps to a map with:
+
+  - `:type` - `:uint8`..`:uint64`, `:int8`..`:int64`, `:float32`, `:float64`,
+    `:bool`, `:date`, `:datetime`, `:datetime64` or `:string`
+  - `:data` - the values, one fixed-width element per row. Dates are int32
+    days since the epoch, datetimes int64 seconds and datetime64 int64 ticks
+    of `:precision` sub-second digits (also in the map). For strings it holds
+    the concatenated bytes of all values.
+  - `:offsets` - strings only: `rows + 1` int64 offsets into `:data`, so value
+    `i` is `binary_part(data, offsets[i], offsets[i + 1] - offsets[i])`
+  - `:validity` - Nullable and nullable LowCardinality columns only: a bitmap
+    with one bit per row, least significant bit first, set for non-null rows.
+    Null rows hold a zero value (or an empty string) in `:data`.
+
+  LowCardinality(String) columns are returned as plain strings. Other column
+  types (Array, Map, Tuple, UUID, Decimal, Enum) return an error.
+
+  ## Examples
+
+      {:ok, %{id: %{type: :uint64, data: ids}}} =
+        Natch.select_packed(conn, "SELECT id FROM events")
+
+      Nx.from_binary(ids, :u64)
+  """
+  @spec select_packed(conn(), String.t() | Natch.Query.t()) :: {:ok, map()} | {:error, term()}
+  def select_packed(conn, query_or_sql) do
+    Connection.select_packed(conn, query_or_sql)
+  end
+
+  @doc """
+  Executes a SELECT query and returns the result as an Arrow IPC stream.
+
+  The stream is built from the result blocks in C++ without per-value terms
+  (see `select_packed/2`) and holds a schema, one dictionary batch per
+  LowCardinality column and a single record batch with every row. Load it
+  with Explorer, Polars or pyarrow:
+
+  - UInt/Int/Float columns map to Arrow integers and floats, Bool to
+    bit-packed booleans
+  - String maps to `large_utf8`, Array(T) to `large_list<T>`
+  - LowCardinality(String) maps to a dictionary array with int32 indices
+  - Date maps to `date32`, DateTime and DateTime64 to UTC timestamps (in the
+    coarsest of s/ms/us/ns that holds the precision)
+  - Nullable(T) maps to a nullable T
+
+  Other column types (Map, Tuple, UUID, Decimal, Enum) return an error.
+
+  ## Examples
+
+      {:ok, ipc} = Natch.select_arrow(conn, "SELECT id, name FROM users")
+      df = Explorer.DataFrame.load_ipc_stream!(ipc)
+  """
+  @spec select_arrow(conn(), String.t() | Natch.Query.t()) :: {:ok, binary()} | {:error, term()}
+  def select_arrow(conn, query_or_sql) do
+    Connection.select_arrow(conn, query_or_sql)
+  end
+
+  @doc """
+  Executes a SELECT query and returns the result blocks without decoding them.
+
+  The blocks are kept in native memory as a `Natch.LazyResult`, and only the
+  columns and row ranges read from it are turned into terms. For wide
+  results of which a code path reads a few columns this skips most of the
+  decoding work and heap.
+
+  ## Examples
+
+      {:ok, result} = Natch.select_lazy(conn, "SELECT * FROM events")
+      %{id: ids, ts: timestamps} = Natch.LazyResult.columns(result, [:id, :ts])
+      [first | _] = Natch.LazyResult.rows(result, columns: [:id, :payload], limit: 10)
+  """
+  @spec select_lazy(conn(), String.t() | Natch.Query.t()) ::
+          {:ok, Natch.LazyResult.t()} | {:error, term()}
+  def select_lazy(conn, query_or_sql) do
+    with {:ok, blocks} <- Connection.select_lazy(conn, query_or_sql) do
+      {:ok, Natch.LazyResult.new(blocks)}
+    end
+  end
+
+  @doc """
+  Starts a SELECT in row-major format without waiting for the result.
+
+  The query runs on the connection's native worker thread. Returns
+  `{:ok, ref}` as soon as it is queued; the calling process later receives
+  `{ref, {:ok, rows}}` or `{ref, {:error, reason}}`. Use `await/2` to wait for
+  it, or `cancel/2` to stop it.
+
+  ## Options
+
+  - `:timeout` - Deadline in milliseconds, overriding the connection's
+    `:query_timeout`. Past it the query is cancelled and the result is
+    `{:error, :timeout}`. Anything but a positive integer or `:infinity`
+    raises `ArgumentError`.
+
+  ## Examples
+
+      {:ok, ref} = Natch.select_rows_async(conn, "SELECT id, name FROM users")
+      # ... do other work ...
+      {:ok, rows} = Natch.await(ref)
+  """
+  @spec select_rows_async(conn(), String.t() | Natch.Query.t(), keyword()) ::
+          {:ok, reference()} | {:error, term()}
+  def select_rows_async(conn, query_or_sql, opts \\ []) do
+    Connection.select_async(conn, :select_rows, query_or_sql, opts)
+  end
+
+  @doc """
+  Starts a SELECT in columnar format without waiting for the result.
+
+  Like `select_rows_async/3`, but the result is a map of column lists. Queries
+  on different connections run concurrently, so their latencies overlap.
+
+  ## Examples
+
+      refs =
+        for conn <- conns do
+          {:ok, ref} = Natch.select_cols_async(conn, "SELECT count() AS n FROM events")
+          ref
+        end
+
+      results = Enum.map(refs, &Natch.await/1)
+  """
+  @spec select_cols_async(conn(), String.t() | Natch.Query.t(), keyword()) ::
+          {:ok, reference()} | {:error, term()}
+  def select_cols_async(conn, query_or_sql, opts \\ []) do
+    Connection.select_async(conn, :select_cols, query_or_sql, opts)
+  end
+
+  @doc """
+  Cancels a query started with `select_rows_async/3` or `select_cols_async/3`.
+
+  The Cancel packet is sent to the server when the query next reports
+  progress or returns a block, and the partial result is discarded. The
+  caller still receives `{ref, {:error, :cancelled}}` (or the result, if the
+  query finished first), and the connection stays usable.
+
+  ## Examples
+
+      {:ok, ref} = Natch.select_cols_async(conn, "SELECT count() FROM huge_table")
+      :ok = Natch.cancel(conn, ref)
+      {:error, :cancelled} = Natch.await(ref)
+  """
+  @spec cancel(conn(), reference()) :: :ok
+  def cancel(conn, ref) when is_reference(ref) do
+    Connection.cancel(conn, ref)
+  end
+
+  @doc """
+  Waits for the result of `select_rows_async/3` or `select_cols_async/3`.
+
+  Returns `{:error, :timeout}` if no result arrives within `timeout`
+  milliseconds (default: `:infinity`). The query itself keeps running and
+  its result still arrives later as `{ref, result}`: use `await/3` to have
+  it cancelled and discarded, or call `cancel/2` and flush the message.
+  """
+  @spec await(reference(), timeout()) :: {:ok, term()} | {:error, term()}
+  def await(ref, timeout \\ :infinity) when is_reference(ref) do
+    receive do
+      {^ref, result} -> result
+    after
+      timeout -> {:error, :timeout}
+    end
+  end
+
+  @doc """
+  Like `await/2`, but a query that times out is cancelled on `conn`.
+
+  Returns `{:error, :timeout}` only once the cancelled query has finished
+  (or `conn` exits meanwhile), and its late result is taken out of the
+  mailbox.
+
+  ## Examples
+
+      {:ok, ref} = Natch.select_rows_async(conn, "SELECT * FROM huge_table")
+
+      case Natch.await(conn, ref, 5_000) do
+        {:ok, rows} -> rows
+        {:error, :timeout} -> []
+      end
+  """
+  @spec await(conn(), reference(), timeout()) :: {:ok, term()} | {:error, term()}
+  def await(conn, ref, timeout) when is_reference(ref) do
+    case await(ref, timeout) do
+      {:error, :timeout} ->
+        monitor = Process.monitor(conn)
+        cancel(conn, ref)
+
+        receive do
+          {^ref, _late} -> :ok
+          {:DOWN, ^monitor, :process, _pid, _reason} -> :ok
+        end
+
+        Process.demonitor(monitor, [:flush])
+        {:error, :timeout}
+
+      result ->
+        result
+    end
+  end
+
+  @doc """
+  Streams a SELECT query one block at a time in columnar format.
+
+  Returns a lazy `Stream` whose elements are column maps
+  (`%{column_name => [values]}`), one per block sent by the server. The query
+  starts when the stream is first consumed. At most `:window` blocks are
+  buffered ahead of the consumer, so memory stays bounded by the block size
+  rather than the size of the whole result.
+
+  Halting the stream early (e.g. with `Enum.take/2`) cancels the query on the
+  server. Other queries on the connection wait until the stream finishes or is
+  halted.
+
+  Raises `RuntimeError` if the query fails.
+
+  ## Options
+
+  - `:window` - Number of blocks that may be in flight before the consumer
+    acknowledges them (default: 2)
+  - `:prefetch` - Number of received blocks that may wait to be converted
+    (default: 2). Blocks are converted and sent on a native thread of their
+    own while the next ones are received, so the server's sending and the
+    conversion overlap. `0` converts each block before receiving the next.
+  - `:timeout` - Time limit for the whole stream, overriding the connection's
+    `:query_timeout`. A stream that runs out of time raises like a failed query.
+
+  ## Examples
+
+      # Export a large table without loading it into memory
+      conn
+      |> Natch.stream_cols("SELECT id, payload FROM events")
+      |> Stream.each(fn %{id: ids, payload: payloads} -> write_chunk(ids, payloads) end)
+      |> Stream.run()
+
+      # Parameterized query
+      query = Natch.Query.new("SELECT * FROM events WHERE id > {min_id:UInt64}")
+      |> Natch.Query.bind(:min_id, 100)
+      Natch.stream_cols(conn, query, window: 4) |> Enum.take(1)
+  """
+  @spec stream_cols(conn(), String.t() | Natch.Query.t(), keyword()) :: Enumerable.t()
+  def stream_cols(conn, query_or_sql, opts \\ []) do
+    window = Keyword.get(opts, :window, 2)
+    prefetch = Keyword.get(opts, :prefetch, 2)
+    query_opts = Keyword.take(opts, [:timeout])
+
+    Stream.resource(
+      fn -> start_stream(conn, query_or_sql, window, prefetch, query_opts) end,
+      &next_stream_block/1,
+      &stop_stream/1
+    )
+  end
+
+  defp start_stream(conn, query_or_sql, window, prefetch, opts) do
+    stream = Natch.Native.stream_create(window, prefetch)
+    tag = make_ref()
+    monitor = Process.monitor(GenServer.whereis(conn) || conn)
+    state = %{stream: stream, tag: tag, monitor: monitor, done: false, error: nil}
+
+    case Connection.select_cols_stream(conn, query_or_sql, stream, self(), tag, opts) do
+      {:ok, ^tag} -> state
+      {:error, reason} -> %{state | done: true, error: reason}
+    end
+  end
+
+  # Errors are raised one step after they are received so that stop_stream/1
+  # sees a finished stream and doesn't wait for messages that won't come
+  defp next_stream_block(%{error: nil, done: true} = state), do: {:halt, state}
+
+  defp next_stream_block(%{error: nil, tag: tag, monitor: monitor} = state) do
+    receive do
+      {^tag, {:block, cols}} ->
+        Natch.Native.stream_ack(state.stream)
+        {[cols], state}
+
+      {^tag, :done} ->
+        {:halt, %{state | done: true}}
+
+      {^tag, {:error, reason}} ->
+        {[], %{state | done: true, error: reason}}
+
+      {:DOWN, ^monitor, :process, _pid, reason} ->
+        {[], %{state | done: true, error: {:connection_down, reason}}}
+    end
+  end
+
+  defp next_stream_block(%{error: reason}) do
+    raise "Query failed: #{inspect(reason)}"
+  end
+
+  defp stop_stream(%{done: true} = state) do
+    Process.demonitor(state.monitor, [:flush])
+  end
+
+  defp stop_stream(state) do
+    Natch.Native.stream_cancel(state.stream)
+    drain_stream(state)
+    Process.demonitor(state.monitor, [:flush])
+  end
+
+  # Wait for the connection to finish so no messages are left in the mailbox
+  defp drain_stream(%{tag: tag, monitor: monitor} = state) do
+    receive do
+      {^tag, {:block, _cols}} -> drain_stream(state)
+      {^tag, _result} -> :ok
+      {:DOWN, ^monitor, :process, _pid, _reason} -> :ok
+    end
+  end
+
   @doc """
   Executes a DDL or DML statement without returning results.
 
@@ -469,13 +867,15 @@ defmodule Natch do
   # Insert Operations
 
   @doc """
-  Inserts data in row format (list of maps).
+  Inserts data in row format (list of maps or tuples).
 
-  Convenience wrapper that converts rows to columnar format before inserting.
+  Rows are maps with atom or string keys, or tuples with one value per schema
+  column in schema order. Scalar columns are appended natively in a single
+  pass over the rows (see `Natch.Block.build_block_from_rows/2`), so no
+  intermediate column lists are built for them.
 
-  **Performance Note:** For bulk operations (1000+ rows), prefer `insert_cols/4`
-  which avoids the O(N*M) conversion overhead. The conversion from rows to columns
-  requires touching every value, making it less efficient for large datasets.
+  **Performance Note:** Columnar data for `insert_cols/4` is still the
+  cheapest input, as it is already laid out the way blocks store it.
 
   ## Examples
 
@@ -493,11 +893,13 @@ defmodule Natch do
         %{"id" => 2, "name" => "Bob"}
       ]
       :ok = Natch.insert_rows(conn, "users", rows, schema)
+
+      # Tuples in schema order
+      :ok = Natch.insert_rows(conn, "users", [{3, "Carol"}], schema)
   """
-  @spec insert_rows(conn(), String.t(), [map()], schema()) :: :ok | {:error, term()}
+  @spec insert_rows(conn(), String.t(), [map() | tuple()], schema()) :: :ok | {:error, term()}
   def insert_rows(conn, table, rows, schema) when is_list(rows) and is_list(schema) do
-    columns = Natch.Conversion.rows_to_columns(rows, schema)
-    insert_cols(conn, table, columns, schema)
+    GenServer.call(conn, {:insert_rows, table, rows, schema}, :infinity)
   end
 
   @doc """
@@ -509,7 +911,7 @@ defmodule Natch do
       schema = [id: :uint64, name: :string]
       Natch.insert_rows!(conn, "users", rows, schema)
   """
-  @spec insert_rows!(conn(), String.t(), [map()], schema()) :: :ok
+  @spec insert_rows!(conn(), String.t(), [map() | tuple()], schema()) :: :ok
   def insert_rows!(conn, table, rows, schema) do
     case insert_rows(conn, table, rows, schema) do
       :ok -> :ok
@@ -571,6 +973,11 @@ defmodule Natch do
         created_at: :datetime
       ]
       :ok = Natch.insert_cols(conn, "events", columns, schema)
+
+      # Fixed-width numeric columns also accept packed little-endian binaries,
+      # which are copied into the column without decoding a list
+      columns = %{id: <<1::little-64, 2::little-64>>, name: ["a", "b"]}
+      :ok = Natch.insert_cols(conn, "users", columns, [id: :uint64, name: :string])
   """
   @spec insert_cols(conn(), String.t(), map(), schema()) :: :ok | {:error, term()}
   def insert_cols(conn, table, columns, schema) when is_map(columns) and is_list(schema) do
@@ -593,4 +1000,139 @@ defmodule Natch do
       {:error, reason} -> raise "Insert failed: #{inspect(reason)}"
     end
   end
+
+  @doc """
+  Inserts data that is already in ClickHouse's Native format.
+
+  `data` is one or more Native format blocks, as returned by
+  `SELECT ... FORMAT Native` over HTTP or written by `clickhouse-local`. It
+  is parsed straight into native columns by clickhouse-cpp and sent as one
+  INSERT, without creating a term per value or needing a schema: column
+  names and types come from the data. They must match the table's.
+
+  RowBinary isn't accepted: clickhouse-cpp only reads the columnar Native
+  layout.
+
+  ## Examples
+
+      # clickhouse-local -q "SELECT * FROM file('events.csv') FORMAT Native" > events.native
+      :ok = Natch.insert_native(conn, "events", File.read!("events.native"))
+  """
+  @spec insert_native(conn(), String.t(), binary()) :: :ok | {:error, term()}
+  def insert_native(conn, table, data) when is_binary(data) do
+    GenServer.call(conn, {:insert_native, table, data}, :infinity)
+  end
+
+  @doc """
+  Inserts a stream of columnar batches with a single pipelined INSERT.
+
+  Every element of `batches` is a columnar map like the one taken by
+  `insert_cols/4` and becomes one block. All blocks are sent through one
+  INSERT query on the connection's worker thread, so the next block is built
+  in the calling process while the previous one is compressed and sent. The
+  connection is busy until the insert finishes.
+
+  If building a batch fails, or the server rejects a block, the INSERT is
+  abandoned and an error returned. Blocks already sent may have been written
+  by then.
+
+  ## Options
+
+  - `:window` - Number of built blocks that may wait to be sent before
+    building the next one waits (default: 1). The calling process waits in
+    `receive`, not on a scheduler.
+  - `:timeout` - Deadline in milliseconds for the whole INSERT, overriding
+    the connection's `:query_timeout`. Past it the INSERT is abandoned and
+    `{:error, :timeout}` returned.
+
+  ## Examples
+
+      File.stream!("events.csv")
+      |> Stream.chunk_every(50_000)
+      |> Stream.map(&parse_events/1)
+      |> then(&Natch.insert_stream(conn, "events", &1, schema))
+  """
+  @spec insert_stream(conn(), String.t(), Enumerable.t(), schema(), keyword()) ::
+          :ok | {:error, term()}
+  def insert_stream(conn, table, batches, schema, opts \\ []) when is_list(schema) do
+    window = Keyword.get(opts, :window, 1)
+    tag = make_ref()
+    stream = Natch.Native.insert_stream_create(window, tag)
+    column_names = Enum.map(schema, fn {name, _type} -> to_string(name) end)
+    monitor = Process.monitor(GenServer.whereis(conn) || conn)
+    query_opts = Keyword.take(opts, [:timeout])
+
+    result =
+      with {:ok, ref} <-
+             Connection.insert_stream_async(conn, table, column_names, stream, query_opts) do
+        case push_batches(stream, {tag, monitor}, batches, schema) do
+          {:down, reason} ->
+            {:error, {:connection_down, reason}}
+
+          pushed ->
+            result = await_insert(ref, monitor)
+
+            # A batch that failed to build is reported instead of the
+            # cancellation it caused
+            case pushed do
+              :ok -> result
+              {:error, e} -> Natch.Error.handle_callback_error(e)
+            end
+        end
+      end
+
+    Process.demonitor(monitor, [:flush])
+    flush_credits(tag)
+    result
+  end
+
+  defp push_batches(stream, waiting, batches, schema) do
+    pushed =
+      Enum.reduce_while(batches, :ok, fn columns, :ok ->
+        block = Natch.Block.build_block(columns, schema)
+
+        case push_block(stream, waiting, block) do
+          :ok -> {:cont, :ok}
+          :closed -> {:halt, :ok}
+          {:down, _reason} = down -> {:halt, down}
+        end
+      end)
+
+    Natch.Native.insert_stream_close(stream)
+    pushed
+  rescue
+    e ->
+      Natch.Native.insert_stream_cancel(stream)
+      {:error, e}
+  end
+
+  # A full window is retried after the worker's next credit, which also comes
+  # when the INSERT ends, so the next push then returns :closed
+  defp push_block(stream, {tag, monitor} = waiting, block) do
+    case Natch.Native.insert_stream_push(stream, block) do
+      :full ->
+        receive do
+          {^tag, :credit} -> push_block(stream, waiting, block)
+          {:DOWN, ^monitor, :process, _pid, reason} -> {:down, reason}
+        end
+
+      result ->
+        result
+    end
+  end
+
+  defp flush_credits(tag) do
+    receive do
+      {^tag, :credit} -> flush_credits(tag)
+    after
+      0 -> :ok
+    end
+  end
+
+  defp await_insert(ref, monitor) do
+    receive do
+      {^ref, result} -> result
+      {:DOWN, ^monitor, :process, _pid, reason} -> {:error, {:connection_down, reason}}
+    end
+  end
 end
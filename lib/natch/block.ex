@@ -25,7 +25,8 @@ defmodule Natch.Block do
   - **Matches ClickHouse native format** (no transposition needed)
   - **Natural for analytics** (operate on columns, not rows)
 
-  If you have row-oriented data, use `Natch.Conversion.rows_to_columns/2`.
+  If you have row-oriented data, `build_block_from_rows/2` builds the block
+  from it directly.
   """
 
   alias Natch.{Column, Native}
@@ -76,6 +77,59 @@ defmodule Natch.Block do
     e -> Natch.Error.handle_nif_error(e)
   end
 
+  @doc """
+  Builds a Block from row-oriented data and schema.
+
+  Rows are maps with atom or string keys (like
+  `Natch.Conversion.rows_to_columns/2` accepts), or tuples holding one value
+  per schema column in schema order.
+
+  Scalar columns (integers, floats, strings, booleans, dates, datetimes and
+  the supported Nullable types) are filled by one NIF call that walks the
+  rows once and appends every value straight into its column, without
+  building per-column lists. Columns of other types are collected from the
+  rows in Elixir and appended as in `build_block/2`.
+
+  ## Examples
+
+      schema = [id: :uint64, name: :string]
+      rows = [%{id: 1, name: "Alice"}, %{id: 2, name: "Bob"}]
+      block = Natch.Block.build_block_from_rows(rows, schema)
+
+      # Tuples in schema order
+      block = Natch.Block.build_block_from_rows([{1, "Alice"}, {2, "Bob"}], schema)
+  """
+  @spec build_block_from_rows([map() | tuple()], keyword()) :: reference()
+  def build_block_from_rows(rows, schema) when is_list(rows) and is_list(schema) do
+    block = Native.block_create()
+    row_count = length(rows)
+
+    columns =
+      for {{name, type}, key} <- Enum.zip(schema, row_keys(rows, schema)) do
+        {name, type, key, Column.new(type, reserve: row_count)}
+      end
+
+    {native, other} = Enum.split_with(columns, fn {_, type, _, _} -> native_row_type?(type) end)
+
+    if native != [] and rows != [] do
+      refs = Enum.map(native, fn {_, _, _, column} -> column.ref end)
+      keys = Enum.map(native, fn {_, _, key, _} -> key end)
+      Native.column_append_rows(refs, keys, rows)
+    end
+
+    for {_name, type, key, column} <- other do
+      append_column_values(column, type, Enum.map(rows, &row_value(&1, key)))
+    end
+
+    for {name, _type, _key, column} <- columns do
+      Native.block_append_column(block, to_string(name), column.ref)
+    end
+
+    block
+  rescue
+    e -> Natch.Error.handle_nif_error(e)
+  end
+
   @doc """
   Builds columns from columnar data using bulk append operations.
 
@@ -99,6 +153,13 @@ defmodule Natch.Block do
   For Map columns, provide list of maps:
       columns = %{metrics: [%{"k1" => 1, "k2" => 2}, %{"k3" => 3}]}
       schema = [metrics: {:map, :string, :uint64}]
+
+  ## Packed Binaries
+
+  Fixed-width numeric columns also accept a packed little-endian binary
+  instead of a list (see `Natch.Column.append_binary/2`):
+      columns = %{id: <<1::little-64, 2::little-64>>}
+      schema = [id: :uint64]
   """
   @spec build_columns_bulk(map(), keyword()) :: keyword()
   def build_columns_bulk(columns, schema) when is_map(columns) and is_list(schema) do
@@ -111,13 +172,20 @@ defmodule Natch.Block do
           raise ArgumentError,
                 "Missing column #{inspect(name)} in columns #{inspect(Map.keys(columns))}"
 
+        is_binary(values) ->
+          # Packed little-endian values for fixed-width numeric columns
+          column = Column.new(type)
+          Column.append_binary(column, values)
+          {name, column.ref}
+
         not is_list(values) ->
           raise ArgumentError,
-                "Column #{inspect(name)} must be a list, got: #{inspect(values)}"
+                "Column #{inspect(name)} must be a list or packed binary, got: #{inspect(values)}"
 
         true ->
-          # Create column and append values using appropriate method
-          column = Column.new(type)
+          # Create column sized for all values and append them using the
+          # appropriate method
+          column = Column.new(type, reserve: length(values))
           append_column_values(column, type, values)
           {name, column.ref}
       end
@@ -152,6 +220,48 @@ defmodule Natch.Block do
     Column.append_bulk(column, values)
   end
 
+  # Types column_append_rows/3 appends natively (see column.cpp)
+  @native_row_types [
+    :uint64,
+    :uint32,
+    :uint16,
+    :int64,
+    :int32,
+    :int16,
+    :int8,
+    :float64,
+    :float32,
+    :string,
+    :bool,
+    :datetime,
+    :datetime64,
+    :date,
+    :nullable_uint64,
+    :nullable_int64,
+    :nullable_string,
+    :nullable_float64
+  ]
+
+  defp native_row_type?({:nullable, inner}), do: inner in [:uint64, :int64, :string, :float64]
+  defp native_row_type?(type), do: type in @native_row_types
+
+  # How each schema column is found in a row: its position for tuple rows,
+  # otherwise its atom or string key (detected once from the first row)
+  defp row_keys([first | _], schema) when is_tuple(first) do
+    Enum.to_list(0..(length(schema) - 1)//1)
+  end
+
+  defp row_keys([first | _], schema) when is_map(first) do
+    for {name, _type} <- schema do
+      if Map.has_key?(first, name), do: name, else: to_string(name)
+    end
+  end
+
+  defp row_keys(_rows, schema), do: Keyword.keys(schema)
+
+  defp row_value(row, position) when is_tuple(row), do: elem(row, position)
+  defp row_value(row, key), do: Map.fetch!(row, key)
+
   # Transpose list of tuples into list of column lists
   # [{"a", 1}, {"b", 2}] -> [["a", "b"], [1, 2]]
   defp transpose_tuples(tuples, size) do
@@ -0,0 +1,306 @@
+defmodule Natch.Cache do
+  @moduledoc """
+  An opt-in result cache for repeated identical SELECTs on a connection.
+
+  Results are keyed by the result format, the SQL text and the bound
+  parameters of a `Natch.Query`, and kept for a TTL in an ETS table owned by
+  the cache process. Hits are read from the table by the calling process, so
+  concurrent readers don't queue behind each other or the cache process; each
+  hit copies the result onto the reader's heap, except binaries larger than
+  64 bytes, which are shared.
+
+  Concurrent misses for the same key are collapsed into a single query: the
+  first caller's query runs on the connection, and every caller that asked
+  for the same key meanwhile gets its result. Errors are returned to all of
+  them and not cached. If the connection goes down while a query runs, its
+  callers get `{:error, {:connection_down, reason}}`.
+
+  Results are evicted when they expire, or oldest first once the cache holds
+  more than `:max_bytes` (measured as the external term size of the results).
+  A result larger than `:max_bytes` by itself is returned but not cached.
+
+  Results are not kept in `:persistent_term`, although that would make hits
+  copy-free: every expiry would then trigger a global garbage collection
+  pass over all processes.
+
+  ## Options
+
+  - `:conn` - The `Natch` connection that runs the queries (required)
+  - `:ttl` - Milliseconds a result is served from the cache (default: 5000)
+  - `:max_bytes` - Memory cap for cached results (default: 64 MiB)
+  - `:name` - Register the cache process under a name
+
+  ## Examples
+
+      {:ok, cache} = Natch.Cache.start_link(conn: conn, ttl: 10_000)
+
+      query =
+        Natch.Query.new("SELECT count() AS n FROM events WHERE day = {day:Date}")
+        |> Natch.Query.bind(:day, ~D[2024-06-01])
+
+      {:ok, %{n: [n]}} = Natch.Cache.select_cols(cache, query)
+  """
+
+  use GenServer
+
+  @default_ttl 5_000
+  @default_max_bytes 64 * 1024 * 1024
+
+  @type cache :: GenServer.server()
+
+  @doc """
+  Starts a cache in front of the connection in `:conn`.
+  """
+  @spec start_link(keyword()) :: GenServer.on_start()
+  def start_link(opts) do
+    {gen_opts, opts} = Keyword.split(opts, [:name])
+    GenServer.start_link(__MODULE__, opts, gen_opts)
+  end
+
+  @doc """
+  Like `Natch.select_cols/2`, served from the cache when possible.
+
+  ## Options
+
+  - `:ttl` - Milliseconds to cache this result for, overriding the cache's
+    `:ttl`
+  - `:timeout` - Query deadline on a miss, see `Natch.select_cols_async/3`
+  """
+  @spec select_cols(cache(), String.t() | Natch.Query.t(), keyword()) ::
+          {:ok, map()} | {:error, term()}
+  def select_cols(cache, query_or_sql, opts \\ []) do
+    fetch(cache, :select_cols, query_or_sql, opts)
+  end
+
+  @doc """
+  Like `Natch.select_rows/2`, served from the cache when possible.
+
+  Takes the same options as `select_cols/3`.
+  """
+  @spec select_rows(cache(), String.t() | Natch.Query.t(), keyword()) ::
+          {:ok, [map()]} | {:error, term()}
+  def select_rows(cache, query_or_sql, opts \\ []) do
+    fetch(cache, :select_rows, query_or_sql, opts)
+  end
+
+  @doc """
+  Drops every cached result. Queries still running won't be cached either.
+  """
+  @spec invalidate(cache()) :: :ok
+  def invalidate(cache) do
+    GenServer.call(cache, :invalidate)
+  end
+
+  defp fetch(cache, kind, query, opts) do
+    key = key(kind, query)
+
+    case lookup(table(cache), key) do
+      {:ok, result} -> {:ok, result}
+      :miss -> GenServer.call(cache, {:fetch, key, kind, query, opts}, :infinity)
+    end
+  end
+
+  defp key(kind, %Natch.Query{sql: sql, params: params}), do: {kind, sql, params}
+  defp key(kind, sql) when is_binary(sql), do: {kind, sql, %{}}
+
+  defp table(cache) do
+    case GenServer.whereis(cache) do
+      pid when is_pid(pid) -> :persistent_term.get({__MODULE__, pid}, nil)
+      _ -> nil
+    end
+  end
+
+  defp lookup(nil, _key), do: :miss
+
+  defp lookup(table, key) do
+    now = System.monotonic_time(:millisecond)
+
+    case :ets.lookup(table, key) do
+      [{^key, result, expires_at}] when expires_at > now -> {:ok, result}
+      _ -> :miss
+    end
+  rescue
+    # The cache stopped between whereis and lookup
+    ArgumentError -> :miss
+  end
+
+  # GenServer callbacks
+
+  @impl true
+  def init(opts) do
+    Process.flag(:trap_exit, true)
+
+    table = :ets.new(__MODULE__, [:set, :protected, read_concurrency: true])
+    :persistent_term.put({__MODULE__, self()}, table)
+
+    state = %{
+      conn: Keyword.fetch!(opts, :conn),
+      table: table,
+      ttl: Keyword.get(opts, :ttl, @default_ttl),
+      max_bytes: Keyword.get(opts, :max_bytes, @default_max_bytes),
+      # key => {size, expires_at} of every cached result
+      entries: %{},
+      # {expires_at, key} of every cached result, soonest first
+      expiry: :gb_sets.new(),
+      bytes: 0,
+      # key => callers waiting for the query running for it
+      waiting: %{},
+      # async query ref => {key, ttl, monitor of the connection}
+      running: %{}
+    }
+
+    schedule_sweep(state.ttl)
+    {:ok, state}
+  end
+
+  @impl true
+  def handle_call({:fetch, key, kind, query, opts}, from, state) do
+    case lookup(state.table, key) do
+      # Filled while the caller was on its way here
+      {:ok, _} = hit -> {:reply, hit, state}
+      :miss when is_map_key(state.waiting, key) -> {:noreply, wait(state, key, from)}
+      :miss -> start_query(state, from, key, kind, query, opts)
+    end
+  end
+
+  @impl true
+  def handle_call(:invalidate, _from, state) do
+    :ets.delete_all_objects(state.table)
+    running = Map.new(state.running, fn {ref, {key, _ttl, mon}} -> {ref, {key, 0, mon}} end)
+    {:reply, :ok, %{state | entries: %{}, expiry: :gb_sets.new(), bytes: 0, running: running}}
+  end
+
+  @impl true
+  def handle_info({ref, result}, state) when is_map_key(state.running, ref) do
+    {{key, ttl, monitor}, running} = Map.pop(state.running, ref)
+    Process.demonitor(monitor, [:flush])
+
+    state =
+      case result do
+        {:ok, value} when ttl > 0 -> store(%{state | running: running}, key, value, ttl)
+        _ -> %{state | running: running}
+      end
+
+    {:noreply, finish(state, key, result)}
+  end
+
+  # The connection died with the query: its result will never come
+  def handle_info({:DOWN, monitor, :process, _pid, reason}, state) do
+    case Enum.find(state.running, fn {_ref, {_key, _ttl, m}} -> m == monitor end) do
+      {ref, {key, _ttl, _monitor}} ->
+        state = %{state | running: Map.delete(state.running, ref)}
+        {:noreply, finish(state, key, {:error, {:connection_down, reason}})}
+
+      nil ->
+        {:noreply, state}
+    end
+  end
+
+  def handle_info(:sweep, state) do
+    schedule_sweep(state.ttl)
+    {:noreply, sweep(state, System.monotonic_time(:millisecond))}
+  end
+
+  def handle_info(_msg, state) do
+    {:noreply, state}
+  end
+
+  @impl true
+  def terminate(_reason, _state) do
+    :persistent_term.erase({__MODULE__, self()})
+  end
+
+  # Private functions
+
+  defp start_query(state, from, key, kind, query, opts) do
+    ttl = Keyword.get(opts, :ttl, state.ttl)
+    query_opts = Keyword.take(opts, [:timeout])
+
+    monitor = Process.monitor(GenServer.whereis(state.conn) || state.conn)
+
+    result =
+      try do
+        case kind do
+          :select_cols -> Natch.select_cols_async(state.conn, query, query_opts)
+          :select_rows -> Natch.select_rows_async(state.conn, query, query_opts)
+        end
+      catch
+        :exit, reason -> {:error, {:connection_down, reason}}
+      end
+
+    case result do
+      {:ok, ref} ->
+        state = put_in(state.running[ref], {key, ttl, monitor})
+        {:noreply, put_in(state.waiting[key], [from])}
+
+      {:error, _} = error ->
+        Process.demonitor(monitor, [:flush])
+        {:reply, error, state}
+    end
+  end
+
+  defp wait(state, key, from), do: update_in(state.waiting[key], &[from | &1])
+
+  # Answer every caller waiting for `key`
+  defp finish(state, key, result) do
+    {waiting, all_waiting} = Map.pop(state.waiting, key, [])
+    Enum.each(waiting, &GenServer.reply(&1, result))
+    %{state | waiting: all_waiting}
+  end
+
+  defp store(state, key, value, ttl) do
+    size = :erlang.external_size(value)
+
+    if size > state.max_bytes do
+      state
+    else
+      expires_at = System.monotonic_time(:millisecond) + ttl
+      state = delete(state, key)
+      :ets.insert(state.table, {key, value, expires_at})
+
+      state = %{
+        state
+        | entries: Map.put(state.entries, key, {size, expires_at}),
+          expiry: :gb_sets.add({expires_at, key}, state.expiry),
+          bytes: state.bytes + size
+      }
+
+      evict(state)
+    end
+  end
+
+  # Drop results that expire soonest (the oldest, for one TTL) until the
+  # cache fits in :max_bytes
+  defp evict(%{bytes: bytes, max_bytes: max_bytes} = state) when bytes <= max_bytes, do: state
+
+  defp evict(state) do
+    {_expires_at, key} = :gb_sets.smallest(state.expiry)
+    state |> delete(key) |> evict()
+  end
+
+  # Drop every result expired by `now`
+  defp sweep(state, now) do
+    with false <- :gb_sets.is_empty(state.expiry),
+         {expires_at, key} when expires_at <= now <- :gb_sets.smallest(state.expiry) do
+      state |> delete(key) |> sweep(now)
+    else
+      _ -> state
+    end
+  end
+
+  defp delete(state, key) do
+    case Map.pop(state.entries, key) do
+      {nil, _} ->
+        state
+
+      {{size, expires_at}, entries} ->
+        :ets.delete(state.table, key)
+        expiry = :gb_sets.delete({expires_at, key}, state.expiry)
+        %{state | entries: entries, expiry: expiry, bytes: state.bytes - size}
+    end
+  end
+
+  defp schedule_sweep(ttl) do
+    Process.send_after(self(), :sweep, max(ttl, 100))
+  end
+end
@@ -0,0 +1,181 @@
+defmodule Natch.Cluster do
+  @moduledoc """
+  Scatter-gather SELECTs over several ClickHouse nodes queried directly.
+
+  A cluster holds one native client per host. `select_cols/3` runs the same
+  query on all of them at once, each on its client's native worker thread,
+  and merges the columnar results in native code into one `select_cols`
+  shape. The query takes as long as the slowest shard: nothing is queued
+  behind another shard or decoded in Elixir.
+
+  By default the shards' rows are concatenated in host order. With
+  `:order_by`, each shard's result must be sorted by that column (put the
+  matching `ORDER BY` in the query) and the rows are merged by it, so the
+  result is sorted as a whole. Keys compare in Erlang term order, where
+  `nil` sorts after numbers and before strings.
+
+  Every shard runs under one deadline and is cancelled together: if one
+  shard fails, the others are stopped and the error is returned.
+
+  ## Options
+
+  - `:hosts` - The nodes to query, as `"host"`, `"host:port"` or keyword
+    lists of connection options (required)
+  - `:query_timeout` - Deadline in milliseconds for each query (default:
+    `:infinity`)
+  - `:name` - Register the cluster process under a name
+
+  Every other `Natch.start_link/1` connection option applies to all hosts.
+
+  ## Examples
+
+      {:ok, cluster} =
+        Natch.Cluster.start_link(hosts: for(n <- 1..12, do: "shard-\#{n}:9000"))
+
+      {:ok, %{day: days, hits: hits}} =
+        Natch.Cluster.select_cols(cluster, "SELECT day, count() AS hits FROM events GROUP BY day")
+
+      {:ok, %{ts: ts}} =
+        Natch.Cluster.select_cols(cluster, "SELECT ts FROM events ORDER BY ts LIMIT 100",
+          order_by: :ts
+        )
+
+  Queries emit the same telemetry events as `Natch` connections, with
+  `:kind` `:cluster_select_cols`. Their counters add up over the shards,
+  except `:receive_ns` (the slowest shard) and `:first_block_ns` (the
+  earliest).
+  """
+
+  use GenServer
+  alias Natch.Native
+
+  @type cluster :: GenServer.server()
+
+  @doc """
+  Starts a cluster and connects a client to every host.
+  """
+  @spec start_link(keyword()) :: GenServer.on_start()
+  def start_link(opts) do
+    Natch.Connection.validate_timeout!(opts, :query_timeout)
+    Natch.Connection.validate_decoding!(opts)
+    {gen_opts, opts} = Keyword.split(opts, [:name])
+    GenServer.start_link(__MODULE__, opts, gen_opts)
+  end
+
+  @doc """
+  Runs a SELECT on every host and returns the merged columns.
+
+  ## Options
+
+  - `:order_by` - Merge the shards' sorted results by this column, given as
+    `column` or `{column, :asc | :desc}` (default: concatenate)
+  - `:timeout` - Deadline in milliseconds, overriding `:query_timeout`
+  """
+  @spec select_cols(cluster(), String.t() | Natch.Query.t(), keyword()) ::
+          {:ok, map()} | {:error, term()}
+  def select_cols(cluster, query_or_sql, opts \\ []) do
+    Natch.Connection.validate_timeout!(opts, :timeout)
+    GenServer.call(cluster, {:select_cols, query_or_sql, opts}, :infinity)
+  end
+
+  # GenServer callbacks
+
+  @impl true
+  def init(opts) do
+    {hosts, client_opts} = Keyword.pop(opts, :hosts)
+
+    clients =
+      for host <- hosts || raise(ArgumentError, "Natch.Cluster needs :hosts") do
+        {:ok, client} = Natch.Connection.build_client(Keyword.merge(client_opts, host_opts(host)))
+        client
+      end
+
+    {_codec, compression} = Natch.Compression.new(Keyword.get(opts, :compression, true))
+    {:ok, %{clients: clients, opts: opts, compression: compression, pending: %{}}}
+  end
+
+  @impl true
+  def handle_call({:select_cols, query, opts}, from, state) do
+    timeout = Keyword.get(opts, :timeout, Keyword.get(state.opts, :query_timeout, :infinity))
+
+    {control, telemetry} =
+      Natch.Connection.query_control(:cluster_select_cols, query, timeout, state.compression)
+
+    {order_by, descending} = order_by(Keyword.get(opts, :order_by))
+    ref = make_ref()
+
+    try do
+      :ok = start(state.clients, query, control, order_by, descending, ref)
+
+      job = %{
+        from: from,
+        control: control,
+        monitor: Process.monitor(elem(from, 0)),
+        telemetry: telemetry
+      }
+
+      {:noreply, put_in(state.pending[ref], job)}
+    rescue
+      e -> {:reply, Natch.Error.handle_callback_error(e), state}
+    end
+  end
+
+  @impl true
+  def handle_info({ref, result}, state) when is_map_key(state.pending, ref) do
+    {job, pending} = Map.pop(state.pending, ref)
+    Process.demonitor(job.monitor, [:flush])
+
+    GenServer.reply(job.from, Natch.Connection.complete_query(job.telemetry, result))
+    {:noreply, %{state | pending: pending, compression: observe(state, job, result)}}
+  end
+
+  # The caller exited: stop its query on every shard
+  def handle_info({:DOWN, monitor, :process, _pid, _reason}, state) do
+    for {_ref, %{monitor: ^monitor, control: control}} <- state.pending,
+        do: Native.query_control_cancel(control)
+
+    {:noreply, state}
+  end
+
+  def handle_info(_msg, state) do
+    {:noreply, state}
+  end
+
+  # Private functions
+
+  # Feed the merged counters of a finished query to an adaptive :compression
+  defp observe(state, %{telemetry: %{compression: codec}}, {:ok, {_columns, stats}}),
+    do: Natch.Compression.observe(state.compression, codec, stats)
+
+  defp observe(state, _job, _result), do: state
+
+  defp start(clients, %Natch.Query{} = query, control, order_by, descending, ref) do
+    Native.cluster_select_cols_parameterized_async(
+      clients,
+      query.ref,
+      control,
+      order_by,
+      descending,
+      self(),
+      ref
+    )
+  end
+
+  defp start(clients, sql, control, order_by, descending, ref) when is_binary(sql) do
+    Native.cluster_select_cols_async(clients, sql, control, order_by, descending, self(), ref)
+  end
+
+  defp host_opts(opts) when is_list(opts), do: opts
+
+  defp host_opts(host) when is_binary(host) do
+    case String.split(host, ":") do
+      [host] -> [host: host]
+      [host, port] -> [host: host, port: String.to_integer(port)]
+    end
+  end
+
+  defp order_by(nil), do: {"", false}
+  defp order_by({column, :asc}), do: {to_string(column), false}
+  defp order_by({column, :desc}), do: {to_string(column), true}
+  defp order_by(column), do: {to_string(column), false}
+end
@@ -64,11 +64,18 @@ defmodule Natch.Column do
 
       iex> Natch.Column.new({:array, :uint64})
       %Natch.Column{type: {:array, :uint64}, clickhouse_type: "Array(UInt64)", ref: #Reference<...>}
+
+  ## Options
+
+  - `:reserve` - Expected number of rows. Storage for them is reserved up
+    front so bulk appends don't repeatedly grow the column (default: 0)
+
+      iex> Natch.Column.new(:uint64, reserve: 1_000_000)
   """
-  @spec new(atom() | tuple()) :: column()
-  def new(type) do
+  @spec new(atom() | tuple(), keyword()) :: column()
+  def new(type, opts \\ []) do
     clickhouse_type = elixir_type_to_clickhouse(type)
-    ref = Native.column_create(clickhouse_type)
+    ref = Native.column_create(clickhouse_type, Keyword.get(opts, :reserve, 0))
 
     %__MODULE__{
       ref: ref,
@@ -368,7 +375,7 @@ defmodule Natch.Column do
   def append_bulk(%__MODULE__{type: {:low_cardinality, inner_type}, ref: lc_ref}, values)
       when is_list(values) do
     # Build a temporary column with the inner type
-    temp_col = new(inner_type)
+    temp_col = new(inner_type, reserve: length(values))
     append_bulk(temp_col, values)
 
     # Pass to LowCardinality NIF which handles dictionary building
@@ -450,6 +457,39 @@ defmodule Natch.Column do
     raise ArgumentError, "append_bulk/2 requires a list of values, got: #{inspect(values)}"
   end
 
+  @doc """
+  Appends values given as a packed little-endian binary (single NIF call).
+
+  The binary is copied straight into the column's storage, skipping list
+  decoding entirely. Use this when values already arrive packed, e.g. from
+  `<<value::little-unsigned-64>>` encoders or an upstream native format.
+
+  Supported for the fixed-width numeric types: `:uint64`, `:uint32`,
+  `:uint16`, `:uint8`, `:bool`, `:int64`, `:int32`, `:int16`, `:int8`,
+  `:float64` and `:float32`. The binary size must be a multiple of the
+  element size.
+
+  ## Examples
+
+      col = Natch.Column.new(:uint64)
+      :ok = Natch.Column.append_binary(col, <<1::little-64, 2::little-64>>)
+
+      col = Natch.Column.new(:float64)
+      :ok = Natch.Column.append_binary(col, <<1.5::little-float-64>>)
+  """
+  @spec append_binary(column(), binary()) :: :ok
+  def append_binary(%__MODULE__{type: type, ref: ref}, packed) when is_binary(packed) do
+    width = packed_width(type)
+
+    unless rem(byte_size(packed), width) == 0 do
+      raise ArgumentError,
+            "Packed binary of #{byte_size(packed)} bytes is not a multiple of " <>
+              "#{width} bytes for #{inspect(type)} column"
+    end
+
+    append_packed(type, ref, packed)
+  end
+
   @doc """
   Appends tuple values using columnar API (high performance).
 
@@ -497,7 +537,7 @@ defmodule Natch.Column do
     nested_cols =
       Enum.zip(element_types, column_lists)
       |> Enum.map(fn {type, values} ->
-        col = new(type)
+        col = new(type, reserve: hd(column_lengths))
         append_bulk(col, values)
         col
       end)
@@ -557,7 +597,7 @@ defmodule Natch.Column do
 
     # Build Array(Tuple(K,V)) column
     tuple_type = {:tuple, [key_type, value_type]}
-    array_tuple_col = new({:array, tuple_type})
+    array_tuple_col = new({:array, tuple_type}, reserve: length(keys_arrays))
 
     # For each map (row), we need to build the tuples
     # Concatenate all keys and values across all maps (only one level)
@@ -570,7 +610,7 @@ defmodule Natch.Column do
     all_keys = Enum.concat(all_keys_per_map)
     all_values = Enum.concat(all_values_per_map)
 
-    nested_tuple_col = new(tuple_type)
+    nested_tuple_col = new(tuple_type, reserve: length(all_keys))
     append_tuple_columns(nested_tuple_col, [all_keys, all_values])
 
     # Calculate offsets for the array (cumulative counts of tuples)
@@ -668,6 +708,27 @@ defmodule Natch.Column do
     raise ArgumentError, "Unsupported column type: #{inspect(type)}"
   end
 
+  defp packed_width(type) when type in [:uint64, :int64, :float64], do: 8
+  defp packed_width(type) when type in [:uint32, :int32, :float32], do: 4
+  defp packed_width(type) when type in [:uint16, :int16], do: 2
+  defp packed_width(type) when type in [:uint8, :bool, :int8], do: 1
+
+  defp packed_width(type) do
+    raise ArgumentError, "append_binary/2 does not support #{inspect(type)} columns"
+  end
+
+  defp append_packed(:uint64, ref, packed), do: Native.column_uint64_append_binary(ref, packed)
+  defp append_packed(:uint32, ref, packed), do: Native.column_uint32_append_binary(ref, packed)
+  defp append_packed(:uint16, ref, packed), do: Native.column_uint16_append_binary(ref, packed)
+  defp append_packed(:uint8, ref, packed), do: Native.column_uint8_append_binary(ref, packed)
+  defp append_packed(:bool, ref, packed), do: Native.column_uint8_append_binary(ref, packed)
+  defp append_packed(:int64, ref, packed), do: Native.column_int64_append_binary(ref, packed)
+  defp append_packed(:int32, ref, packed), do: Native.column_int32_append_binary(ref, packed)
+  defp append_packed(:int16, ref, packed), do: Native.column_int16_append_binary(ref, packed)
+  defp append_packed(:int8, ref, packed), do: Native.column_int8_append_binary(ref, packed)
+  defp append_packed(:float64, ref, packed), do: Native.column_float64_append_binary(ref, packed)
+  defp append_packed(:float32, ref, packed), do: Native.column_float32_append_binary(ref, packed)
+
   # Helper function to split nullable values into actual values and null flags
   # Returns {[values], [nulls]} where null flags are UInt8 (0 = not null, 1 = null)
   defp split_nullable_values(values, default_value) do
@@ -698,8 +759,9 @@ defmodule Natch.Column do
   # Generic path for Array columns - works for ANY inner type
   # Builds nested column, then passes it to C++ via column_array_append_from_column
   defp append_array_generic(%__MODULE__{type: {:array, inner_type}, ref: array_ref}, arrays) do
-    # Build nested column with all array elements
-    nested_col = new(inner_type)
+    # Build nested column with all array elements, reserved for all of them
+    element_count = Enum.reduce(arrays, 0, &(length(&1) + &2))
+    nested_col = new(inner_type, reserve: element_count)
 
     # Accumulate offsets as we append arrays
     offsets =
@@ -0,0 +1,100 @@
+defmodule Natch.Compression do
+  @moduledoc false
+  # Network compression of a connection, from its :compression option.
+  #
+  # The client's own codec (set when the client is created) compresses what
+  # it sends, i.e. INSERT blocks. What the server sends back is compressed
+  # with the codec each query asks for, so a connection can switch between
+  # LZ4 and ZSTD from one query to the next.
+  #
+  # :adaptive keeps a moving average of receive throughput (uncompressed
+  # result bytes per second of transfer time) for each codec and runs its
+  # queries with the faster one. It starts with LZ4, tries ZSTD once LZ4 has
+  # been measured and keeps probing the slower codec every @probe_every
+  # measured queries, so it follows links that change. Only results of at
+  # least @min_sample_bytes are measured: smaller ones are dominated by
+  # round-trip time whatever the codec. Transfer time is the receive time
+  # after the first data block arrived, which leaves out the server's time
+  # to start producing the result.
+
+  @min_sample_bytes 1_048_576
+  @probe_every 16
+  @weight 0.2
+
+  # ClickHouse's default network_zstd_compression_level
+  @default_zstd_level 1
+
+  defstruct mode: :fixed, codec: :lz4, level: 0, throughput: %{}, measured: 0
+
+  @type option ::
+          boolean() | :none | :lz4 | :zstd | {:zstd, 1..22} | :adaptive | {:adaptive, 1..22}
+
+  @type t :: %__MODULE__{}
+
+  @doc """
+  Parses a :compression option into the client's codec and the query policy.
+  """
+  @spec new(option()) :: {:none | :lz4 | :zstd, t()}
+  def new(option \\ true)
+
+  def new(true), do: new(:lz4)
+  def new(false), do: new(:none)
+  def new(:none), do: {:none, %__MODULE__{codec: :none}}
+  def new(:lz4), do: {:lz4, %__MODULE__{codec: :lz4}}
+  def new(:zstd), do: new({:zstd, @default_zstd_level})
+  def new(:adaptive), do: new({:adaptive, @default_zstd_level})
+
+  def new({:zstd, level}) when level in 1..22,
+    do: {:zstd, %__MODULE__{codec: :zstd, level: level}}
+
+  def new({:adaptive, level}) when level in 1..22,
+    do: {:lz4, %__MODULE__{mode: :adaptive, codec: :lz4, level: level}}
+
+  def new(other) do
+    raise ArgumentError,
+          "invalid :compression #{inspect(other)}, expected a boolean, :none, :lz4, " <>
+            ":zstd, {:zstd, level}, :adaptive or {:adaptive, level}"
+  end
+
+  @doc """
+  The {codec, zstd_level} to run the next query with.
+  """
+  @spec choose(t()) :: {:none | :lz4 | :zstd, non_neg_integer()}
+  def choose(%__MODULE__{mode: :fixed, codec: codec, level: level}), do: {codec, level}
+
+  def choose(%__MODULE__{throughput: throughput, measured: measured} = policy) do
+    codec =
+      case throughput do
+        %{lz4: lz4, zstd: zstd} ->
+          {best, other} = if zstd > lz4, do: {:zstd, :lz4}, else: {:lz4, :zstd}
+          if rem(measured, @probe_every) == @probe_every - 1, do: other, else: best
+
+        %{lz4: _} ->
+          :zstd
+
+        %{} ->
+          :lz4
+      end
+
+    {codec, if(codec == :zstd, do: policy.level, else: 0)}
+  end
+
+  @doc """
+  Records the counters of a query that ran with `codec`.
+  """
+  @spec observe(t(), atom(), map()) :: t()
+  def observe(%__MODULE__{mode: :adaptive} = policy, codec, stats) do
+    %{result_bytes: bytes, receive_ns: receive_ns, first_block_ns: first_block_ns} = stats
+    ns = receive_ns - first_block_ns
+
+    if bytes >= @min_sample_bytes and ns > 0 do
+      sample = bytes * 1_000_000_000 / ns
+      throughput = Map.update(policy.throughput, codec, sample, &(&1 + @weight * (sample - &1)))
+      %{policy | throughput: throughput, measured: policy.measured + 1}
+    else
+      policy
+    end
+  end
+
+  def observe(policy, _codec, _stats), do: policy
+end
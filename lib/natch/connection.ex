@@ -12,11 +12,15 @@ defmodule Natch.Connection do
           | {:database, String.t()}
           | {:user, String.t()}
           | {:password, String.t()}
-          | {:compression, boolean()}
+          | {:compression, Natch.Compression.option()}
           | {:ssl, boolean()}
           | {:connect_timeout, non_neg_integer()}
           | {:recv_timeout, non_neg_integer()}
           | {:send_timeout, non_neg_integer()}
+          | {:strings, :copy | :sub_binary}
+          | {:enums, :string | :atom}
+          | {:decode_threads, pos_integer()}
+          | {:query_timeout, timeout()}
           | {:name, atom()}
 
   @doc """
@@ -33,6 +37,8 @@ defmodule Natch.Connection do
   """
   @spec start_link([option()]) :: GenServer.on_start()
   def start_link(opts \\ []) do
+    validate_timeout!(opts, :query_timeout)
+    validate_decoding!(opts)
     {gen_opts, client_opts} = Keyword.split(opts, [:name])
     GenServer.start_link(__MODULE__, client_opts, gen_opts)
   end
@@ -103,6 +109,50 @@ defmodule Natch.Connection do
     GenServer.call(conn, {:select_cols, query}, :infinity)
   end
 
+  @doc """
+  Executes a SELECT query and returns the column names and one tuple per row.
+
+  See `Natch.select_tuples/2`.
+  """
+  @spec select_tuples(GenServer.server(), String.t() | Natch.Query.t()) ::
+          {:ok, {[atom()], [tuple()]}} | {:error, term()}
+  def select_tuples(conn, query) do
+    GenServer.call(conn, {:select_tuples, query}, :infinity)
+  end
+
+  @doc """
+  Executes a SELECT query and returns each column as packed binaries.
+
+  See `Natch.select_packed/2` for the layout.
+  """
+  @spec select_packed(GenServer.server(), String.t() | Natch.Query.t()) ::
+          {:ok, map()} | {:error, term()}
+  def select_packed(conn, query) do
+    GenServer.call(conn, {:select_packed, query}, :infinity)
+  end
+
+  @doc """
+  Executes a SELECT query and returns the result as an Arrow IPC stream.
+
+  See `Natch.select_arrow/2`.
+  """
+  @spec select_arrow(GenServer.server(), String.t() | Natch.Query.t()) ::
+          {:ok, binary()} | {:error, term()}
+  def select_arrow(conn, query) do
+    GenServer.call(conn, {:select_arrow, query}, :infinity)
+  end
+
+  @doc """
+  Executes a SELECT query and returns its result blocks without decoding them.
+
+  See `Natch.select_lazy/2`.
+  """
+  @spec select_lazy(GenServer.server(), String.t() | Natch.Query.t()) ::
+          {:ok, {list(), [atom()], [String.t()]}} | {:error, term()}
+  def select_lazy(conn, query) do
+    GenServer.call(conn, {:select_lazy, query}, :infinity)
+  end
+
   # Phase 6C - Parameterized Query API
 
   @doc """
@@ -131,12 +181,116 @@ defmodule Natch.Connection do
     GenServer.call(conn, {:select_cols_parameterized, query}, :infinity)
   end
 
+  @doc """
+  Starts a SELECT without waiting for it to finish.
+
+  `kind` is `:select_rows` or `:select_cols`. Returns `{:ok, ref}` once the
+  query is queued; the caller later receives `{ref, {:ok, result}}` or
+  `{ref, {:error, reason}}`. The `:timeout` option overrides the
+  connection's `:query_timeout` for this query.
+  """
+  @spec select_async(
+          GenServer.server(),
+          :select_rows | :select_cols,
+          String.t() | Natch.Query.t(),
+          keyword()
+        ) :: {:ok, reference()} | {:error, term()}
+  def select_async(conn, kind, query, opts \\ []) when kind in [:select_rows, :select_cols] do
+    validate_timeout!(opts, :timeout)
+    GenServer.call(conn, {:async, kind, query, {:send, self(), make_ref()}, opts})
+  end
+
+  @doc """
+  Cancels a query started with `select_async/4`.
+
+  The caller still receives `{ref, {:error, :cancelled}}`, or the result if
+  the query finished first. Unknown refs are ignored.
+  """
+  @spec cancel(GenServer.server(), reference()) :: :ok
+  def cancel(conn, ref) do
+    GenServer.call(conn, {:cancel, ref})
+  end
+
+  @doc """
+  Starts a pipelined INSERT of the blocks pushed to `stream`.
+
+  The INSERT runs on the client's worker thread. Returns `{:ok, ref}` once it
+  is queued; the caller receives `{ref, :ok}` or `{ref, {:error, reason}}`
+  after the stream is closed and every block has been sent. The `:timeout`
+  option overrides the connection's `:query_timeout`, and `cancel/2` with
+  the ref aborts the INSERT.
+  """
+  @spec insert_stream_async(
+          GenServer.server(),
+          String.t(),
+          [String.t()],
+          reference(),
+          keyword()
+        ) :: {:ok, reference()} | {:error, term()}
+  def insert_stream_async(conn, table, column_names, stream, opts \\ []) do
+    validate_timeout!(opts, :timeout)
+
+    GenServer.call(
+      conn,
+      {:insert_stream, table, column_names, stream, {:send, self(), make_ref()}, opts}
+    )
+  end
+
+  @doc """
+  Starts a streaming SELECT that sends each result block to `consumer`.
+
+  The query runs on the client's worker thread. Returns `{:ok, tag}` once it
+  is queued. Blocks arrive as `{tag, {:block, columns_map}}` and must be
+  acknowledged with `Natch.Native.stream_ack/1`. When the query finishes the
+  consumer receives `{tag, :done}` or `{tag, {:error, reason}}`. The
+  `:timeout` option overrides the connection's `:query_timeout`.
+  """
+  @spec select_cols_stream(
+          GenServer.server(),
+          String.t() | Natch.Query.t(),
+          reference(),
+          pid(),
+          reference(),
+          keyword()
+        ) :: {:ok, reference()} | {:error, term()}
+  def select_cols_stream(conn, query, stream, consumer, tag, opts \\ []) do
+    validate_timeout!(opts, :timeout)
+    GenServer.call(conn, {:select_cols_stream, query, stream, {:send, consumer, tag}, opts})
+  end
+
+  @doc false
+  # Raises in the caller for a timeout option that can't be a query deadline,
+  # rather than letting it crash the process that runs the query
+  @spec validate_timeout!(keyword(), atom()) :: :ok
+  def validate_timeout!(opts, key) do
+    case Keyword.get(opts, key, :infinity) do
+      :infinity ->
+        :ok
+
+      ms when is_integer(ms) and ms > 0 ->
+        :ok
+
+      other ->
+        raise ArgumentError,
+              "#{inspect(key)} must be a positive integer or :infinity, got: #{inspect(other)}"
+    end
+  end
+
+  # Also used by Natch.Pool and Natch.Cluster, so that a bad decoding option
+  # raises in start_link rather than crashing init
+  @doc false
+  def validate_decoding!(opts) do
+    _ = decode_options!(opts)
+    :ok
+  end
+
   # GenServer callbacks
 
   @impl true
   def init(opts) do
     {:ok, client} = build_client(opts)
-    {:ok, %{client: client, opts: opts}}
+    {_codec, compression} = Natch.Compression.new(Keyword.get(opts, :compression, true))
+    {:ok, %{client: client, opts: opts, pending: %{}, compression: compression}}
   end
 
   @impl true
@@ -144,108 +298,338 @@ defmodule Natch.Connection do
     {:reply, {:ok, state.client}, state}
   end
 
+  # Queries run on the client's native worker thread. The result comes back
+  # as a {ref, result} message (see handle_info/2), so the mailbox stays free
+  # while ClickHouse is working.
+
   @impl true
-  def handle_call({:execute, sql}, _from, state) do
-    try do
-      Native.client_execute(state.client, sql)
-      {:reply, :ok, state}
-    rescue
-      e -> {:reply, error_tuple(e), state}
-    end
+  def handle_call({:execute, sql}, from, state) do
+    run_query(state, {:reply, from}, &ok/1, {:execute, sql, []}, fn client, control, ref ->
+      Native.client_execute_async(client, sql, control, self(), ref)
+    end)
   end
 
   @impl true
-  def handle_call(:ping, _from, state) do
-    try do
-      Native.client_ping(state.client)
-      {:reply, :ok, state}
-    rescue
-      e -> {:reply, error_tuple(e), state}
-    end
+  def handle_call(:ping, from, state) do
+    run_async(state, {:reply, from}, &ok/1, fn client, ref ->
+      Native.client_ping_async(client, self(), ref)
+    end)
   end
 
+  # Queued behind any running job, like every other query
   @impl true
-  def handle_call(:reset, _from, state) do
-    try do
-      Native.client_reset_connection(state.client)
-      {:reply, :ok, state}
-    rescue
-      e -> {:reply, error_tuple(e), state}
-    end
+  def handle_call(:reset, from, state) do
+    run_async(state, {:reply, from}, &ok/1, fn client, ref ->
+      Native.client_reset_connection_async(client, self(), ref)
+    end)
   end
 
   @impl true
-  def handle_call({:insert, table, columns, schema}, _from, state) do
-    try do
-      # Build block from columnar data
-      block = Natch.Block.build_block(columns, schema)
+  def handle_call({:insert, table, columns, schema}, from, state) do
+    insert_block(state, from, table, fn -> Natch.Block.build_block(columns, schema) end)
+  end
+
+  @impl true
+  def handle_call({:insert_native, table, data}, from, state) do
+    insert_block(state, from, table, fn -> Native.block_from_native(data) end)
+  end
 
-      # Insert block
-      Native.client_insert(state.client, table, block)
+  @impl true
+  def handle_call({:insert_rows, table, rows, schema}, from, state) do
+    insert_block(state, from, table, fn -> Natch.Block.build_block_from_rows(rows, schema) end)
+  end
 
-      {:reply, :ok, state}
-    rescue
-      e -> {:reply, error_tuple(e), state}
+  # Runs under a control for its deadline and cancellation, but reports no
+  # telemetry, like the other inserts
+  @impl true
+  def handle_call({:insert_stream, table, column_names, stream, target, opts}, _from, state) do
+    timeout = Keyword.get(opts, :timeout, Keyword.get(state.opts, :query_timeout, :infinity))
+    control = Native.query_control_create(timeout_ms(timeout), :none, 0)
+
+    start = fn client, ref ->
+      Native.client_insert_stream_async(client, table, column_names, stream, control, self(), ref)
     end
+
+    run_async(state, target, &ok/1, start, {control, nil})
   end
 
   @impl true
-  def handle_call({:select_rows, query}, _from, state) do
-    try do
-      # client_select returns list of maps directly
-      rows = Native.client_select(state.client, query)
+  def handle_call({:select_rows, query}, from, state) do
+    handle_call({:async, :select_rows, query, {:reply, from}, []}, from, state)
+  end
 
-      {:reply, {:ok, rows}, state}
-    rescue
-      e -> {:reply, error_tuple(e), state}
-    end
+  @impl true
+  def handle_call({:select_cols, query}, from, state) do
+    handle_call({:async, :select_cols, query, {:reply, from}, []}, from, state)
   end
 
   @impl true
-  def handle_call({:select_cols, query}, _from, state) do
-    try do
-      # client_select_cols returns map of column lists
-      cols = Native.client_select_cols(state.client, query)
+  def handle_call({:select_tuples, query}, from, state) do
+    handle_call({:async, :select_tuples, query, {:reply, from}, []}, from, state)
+  end
 
-      {:reply, {:ok, cols}, state}
-    rescue
-      e -> {:reply, error_tuple(e), state}
-    end
+  @impl true
+  def handle_call({:select_packed, query}, from, state) do
+    handle_call({:async, :select_packed, query, {:reply, from}, []}, from, state)
+  end
+
+  @impl true
+  def handle_call({:select_arrow, query}, from, state) do
+    handle_call({:async, :select_arrow, query, {:reply, from}, []}, from, state)
+  end
+
+  @impl true
+  def handle_call({:select_lazy, query}, from, state) do
+    handle_call({:async, :select_lazy, query, {:reply, from}, []}, from, state)
   end
 
   # Phase 6C - Parameterized Query Support
 
   @impl true
-  def handle_call({:execute_parameterized, query}, _from, state) do
-    try do
-      Native.client_execute_parameterized(state.client, query.ref)
-      {:reply, :ok, state}
-    rescue
-      e -> {:reply, error_tuple(e), state}
-    end
+  def handle_call({:execute_parameterized, query}, from, state) do
+    run_query(state, {:reply, from}, &ok/1, {:execute, query, []}, fn client, control, ref ->
+      Native.client_execute_parameterized_async(client, query.ref, control, self(), ref)
+    end)
+  end
+
+  @impl true
+  def handle_call({:select_rows_parameterized, query}, from, state) do
+    handle_call({:async, :select_rows, query, {:reply, from}, []}, from, state)
+  end
+
+  @impl true
+  def handle_call({:select_cols_parameterized, query}, from, state) do
+    handle_call({:async, :select_cols, query, {:reply, from}, []}, from, state)
+  end
+
+  # Async SELECT - {:reply, from} answers a pending call, {:send, pid, ref}
+  # delivers {ref, result} to pid for Natch.select_*_async/3
+  @impl true
+  def handle_call({:async, kind, query, target, opts}, _from, state) do
+    run_query(state, target, &{:ok, &1}, {kind, query, opts}, fn client, control, ref ->
+      start_select(kind, client, query, control, ref)
+    end)
+  end
+
+  # Streaming SELECT - blocks are sent straight from the worker thread to the
+  # consumer, the final status from handle_info/2, so it always arrives after
+  # the last block
+  @impl true
+  def handle_call({:select_cols_stream, query, stream, target, opts}, _from, state) do
+    start = &start_stream(&1, query, &2, stream, target, &3)
+    run_query(state, target, fn _ -> :done end, {:stream_cols, query, opts}, start)
   end
 
   @impl true
-  def handle_call({:select_rows_parameterized, query}, _from, state) do
+  def handle_call({:cancel, user_ref}, _from, state) do
+    for {_ref, %{target: {:send, _pid, ^user_ref}, control: control}} <- state.pending,
+        control != nil,
+        do: Native.query_control_cancel(control)
+
+    {:reply, :ok, state}
+  end
+
+  @impl true
+  def handle_info({ref, result}, state) when is_map_key(state.pending, ref) do
+    {job, pending} = Map.pop(state.pending, ref)
+    if job.monitor, do: Process.demonitor(job.monitor, [:flush])
+
+    reply = complete(job, result)
+    state = observe_compression(state, job, result)
+
+    case job.target do
+      {:reply, from} -> GenServer.reply(from, reply)
+      {:send, pid, user_ref} -> send(pid, {user_ref, reply})
+    end
+
+    {:noreply, %{state | pending: pending}}
+  end
+
+  # The caller exited (e.g. its GenServer.call timed out): stop its queries
+  # rather than let them hold the connection
+  def handle_info({:DOWN, monitor, :process, _pid, _reason}, state) do
+    for {_ref, %{monitor: ^monitor, control: control}} <- state.pending,
+        do: Native.query_control_cancel(control)
+
+    {:noreply, state}
+  end
+
+  def handle_info(_msg, state) do
+    {:noreply, state}
+  end
+
+  # Private functions
+
+  # Queue a job with `start.(client, ref)` and remember who gets the result.
+  # Calls from {:reply, from} targets are answered later from handle_info/2.
+  defp run_async(state, target, on_ok, start, query \\ nil) do
+    ref = make_ref()
+
     try do
-      rows = Native.client_select_parameterized(state.client, query.ref)
-      {:reply, {:ok, rows}, state}
+      :ok = start.(state.client, ref)
+      {control, telemetry} = query || {nil, nil}
+      monitor = if control, do: Process.monitor(target_pid(target))
+      job = %{target: target, on_ok: on_ok, control: control, monitor: monitor}
+      state = put_in(state.pending[ref], Map.put(job, :telemetry, telemetry))
+
+      case target do
+        {:reply, _from} -> {:noreply, state}
+        {:send, _pid, user_ref} -> {:reply, {:ok, user_ref}, state}
+      end
     rescue
       e -> {:reply, error_tuple(e), state}
     end
   end
 
-  @impl true
-  def handle_call({:select_cols_parameterized, query}, _from, state) do
+  # Like run_async/4 for queries that can be stopped: `start.(client, control, ref)`
+  # gets the query's control, whose deadline is the :timeout option or the
+  # connection's :query_timeout. The caller is monitored for as long as the
+  # query runs. `kind` and `query` only label the telemetry events.
+  defp run_query(state, target, on_ok, {kind, query, opts}, start) do
+    timeout = Keyword.get(opts, :timeout, Keyword.get(state.opts, :query_timeout, :infinity))
+    {control, telemetry} = query_control(kind, query, timeout, state.compression)
+    run_async(state, target, on_ok, &start.(&1, control, &2), {control, telemetry})
+  end
+
+  # The control of a query about to start, and the telemetry complete_query/2
+  # reports it with. Also used by Natch.Pool.
+  @doc false
+  @spec query_control(atom(), term(), timeout(), Natch.Compression.t()) :: {reference(), map()}
+  def query_control(kind, query, timeout, compression) do
+    {codec, level} = Natch.Compression.choose(compression)
+    control = Native.query_control_create(timeout_ms(timeout), codec, level)
+
+    telemetry = %{
+      kind: kind,
+      query: query,
+      compression: codec,
+      compression_level: level,
+      started: System.monotonic_time()
+    }
+
+    {control, telemetry}
+  end
+
+  # Turns the reply of a controlled query into {:ok, value} or
+  # {:error, reason}, emitting [:natch, :query, :stop] or
+  # [:natch, :query, :exception]
+  @doc false
+  @spec complete_query(map(), {:ok, {term(), map()}} | {:error, String.t()}) ::
+          {:ok, term()} | {:error, term()}
+  def complete_query(telemetry, {:ok, {value, stats}}) do
+    {by_type, counters} = Map.pop(stats, :decode_ns_by_type)
+    duration = System.monotonic_time() - telemetry.started
+    metadata = telemetry_metadata(telemetry, :decode_ns_by_type, by_type)
+    :telemetry.execute([:natch, :query, :stop], Map.put(counters, :duration, duration), metadata)
+    {:ok, value}
+  end
+
+  def complete_query(telemetry, {:error, message}) do
+    {:error, reason} = reply = error_tuple(%RuntimeError{message: message})
+    duration = System.monotonic_time() - telemetry.started
+    metadata = telemetry_metadata(telemetry, :reason, reason)
+    :telemetry.execute([:natch, :query, :exception], %{duration: duration}, metadata)
+    reply
+  end
+
+  # Feed the counters of a finished query to an adaptive :compression
+  defp observe_compression(state, %{telemetry: %{compression: codec}}, {:ok, {_value, stats}}),
+    do: %{state | compression: Natch.Compression.observe(state.compression, codec, stats)}
+
+  defp observe_compression(state, _job, _result), do: state
+
+  # The reply to a finished job. Queries reply with {result, stats} and emit
+  # [:natch, :query, :stop] or [:natch, :query, :exception].
+  defp complete(%{telemetry: nil, on_ok: on_ok}, {:ok, value}), do: on_ok.(value)
+
+  defp complete(%{telemetry: nil}, {:error, message}),
+    do: error_tuple(%RuntimeError{message: message})
+
+  defp complete(%{telemetry: telemetry, on_ok: on_ok}, result) do
+    case complete_query(telemetry, result) do
+      {:ok, value} -> on_ok.(value)
+      error -> error
+    end
+  end
+
+  defp telemetry_metadata(telemetry, key, value) do
+    telemetry
+    |> Map.take([:kind, :query, :compression, :compression_level])
+    |> Map.put(key, value)
+  end
+
+  defp timeout_ms(:infinity), do: 0
+  defp timeout_ms(ms) when is_integer(ms) and ms > 0, do: ms
+
+  defp target_pid({:reply, {pid, _tag}}), do: pid
+  defp target_pid({:send, pid, _user_ref}), do: pid
+
+  defp insert_block(state, from, table, build) do
     try do
-      cols = Native.client_select_cols_parameterized(state.client, query.ref)
-      {:reply, {:ok, cols}, state}
+      block = build.()
+
+      run_async(state, {:reply, from}, &ok/1, fn client, ref ->
+        Native.client_insert_async(client, table, block, self(), ref)
+      end)
     rescue
       e -> {:reply, error_tuple(e), state}
     end
   end
 
-  # Private functions
+  defp start_select(:select_rows, client, %Natch.Query{} = query, control, ref),
+    do: Native.client_select_parameterized_async(client, query.ref, control, self(), ref)
+
+  defp start_select(:select_rows, client, sql, control, ref) when is_binary(sql),
+    do: Native.client_select_async(client, sql, control, self(), ref)
+
+  defp start_select(:select_cols, client, %Natch.Query{} = query, control, ref),
+    do: Native.client_select_cols_parameterized_async(client, query.ref, control, self(), ref)
+
+  defp start_select(:select_cols, client, sql, control, ref) when is_binary(sql),
+    do: Native.client_select_cols_async(client, sql, control, self(), ref)
+
+  defp start_select(:select_tuples, client, %Natch.Query{} = query, control, ref),
+    do: Native.client_select_tuples_parameterized_async(client, query.ref, control, self(), ref)
+
+  defp start_select(:select_tuples, client, sql, control, ref) when is_binary(sql),
+    do: Native.client_select_tuples_async(client, sql, control, self(), ref)
+
+  defp start_select(:select_packed, client, %Natch.Query{} = query, control, ref),
+    do: Native.client_select_packed_parameterized_async(client, query.ref, control, self(), ref)
+
+  defp start_select(:select_packed, client, sql, control, ref) when is_binary(sql),
+    do: Native.client_select_packed_async(client, sql, control, self(), ref)
+
+  defp start_select(:select_arrow, client, %Natch.Query{} = query, control, ref),
+    do: Native.client_select_arrow_parameterized_async(client, query.ref, control, self(), ref)
+
+  defp start_select(:select_arrow, client, sql, control, ref) when is_binary(sql),
+    do: Native.client_select_arrow_async(client, sql, control, self(), ref)
+
+  defp start_select(:select_lazy, client, %Natch.Query{} = query, control, ref),
+    do: Native.client_select_lazy_parameterized_async(client, query.ref, control, self(), ref)
+
+  defp start_select(:select_lazy, client, sql, control, ref) when is_binary(sql),
+    do: Native.client_select_lazy_async(client, sql, control, self(), ref)
+
+  defp ok(_result), do: :ok
+
+  defp start_stream(client, %Natch.Query{} = query, control, stream, {:send, pid, tag}, ref) do
+    Native.client_select_cols_stream_parameterized_async(
+      client,
+      query.ref,
+      control,
+      stream,
+      pid,
+      tag,
+      self(),
+      ref
+    )
+  end
+
+  defp start_stream(client, sql, control, stream, {:send, pid, tag}, ref) when is_binary(sql) do
+    Native.client_select_cols_stream_async(client, sql, control, stream, pid, tag, self(), ref)
+  end
 
   # Delegate to shared error handling
   defp handle_error(exception_struct) do
@@ -256,13 +640,15 @@ defmodule Natch.Connection do
     Natch.Error.handle_callback_error(exception_struct)
   end
 
-  defp build_client(opts) do
+  # Also used by Natch.Pool to create its clients
+  @doc false
+  def build_client(opts) do
     host = Keyword.get(opts, :host, "localhost")
     port = Keyword.get(opts, :port, 9000)
     database = Keyword.get(opts, :database, "default")
     user = Keyword.get(opts, :user, "default")
     password = Keyword.get(opts, :password, "")
-    compression = Keyword.get(opts, :compression, true)
+    {compression, _policy} = Natch.Compression.new(Keyword.get(opts, :compression, true))
     ssl = Keyword.get(opts, :ssl, false)
 
     # Timeout options - match C++ library defaults
@@ -285,9 +671,44 @@ defmodule Natch.Connection do
           send_timeout
         )
 
+      configure_decoding(client, opts)
+
       {:ok, client}
     rescue
       e -> handle_error(e)
     end
   end
+
+  defp configure_decoding(client, opts) do
+    {sub_binary_strings, enum_atoms, decode_threads} = decode_options!(opts)
+    Native.client_set_decode_options(client, sub_binary_strings, enum_atoms, decode_threads)
+  end
+
+  defp decode_options!(opts) do
+    sub_binary_strings =
+      case Keyword.get(opts, :strings, :copy) do
+        :copy -> false
+        :sub_binary -> true
+        other -> invalid_option!(:strings, ":copy or :sub_binary", other)
+      end
+
+    enum_atoms =
+      case Keyword.get(opts, :enums, :string) do
+        :string -> false
+        :atom -> true
+        other -> invalid_option!(:enums, ":string or :atom", other)
+      end
+
+    decode_threads =
+      case Keyword.get(opts, :decode_threads, 1) do
+        n when is_integer(n) and n > 0 -> n
+        other -> invalid_option!(:decode_threads, "a positive integer", other)
+      end
+
+    {sub_binary_strings, enum_atoms, decode_threads}
+  end
+
+  defp invalid_option!(key, expected, value) do
+    raise ArgumentError, "#{inspect(key)} must be #{expected}, got: #{inspect(value)}"
+  end
 end
@@ -241,6 +241,12 @@ defmodule Natch.Error do
         # Return structured error with type and details
         {:error, %{type: type, message: error["message"], details: error}}
 
+      {:ok, %{"type" => "cancelled"}} ->
+        {:error, :cancelled}
+
+      {:ok, %{"type" => "timeout"}} ->
+        {:error, :timeout}
+
       {:ok, error} ->
         # Other error types as simple error tuple
         {:error, error["message"]}
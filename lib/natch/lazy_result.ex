@@ -0,0 +1,107 @@
+defmodule Natch.LazyResult do
+  @moduledoc """
+  A SELECT result kept as native blocks, from `Natch.select_lazy/2`.
+
+  No value is turned into a term until it is asked for: `column/3`,
+  `columns/3` and `rows/2` decode only the columns and rows they return, so
+  code that reads a few columns of a wide result doesn't pay for the rest.
+  Each call decodes again; keep what you read rather than reading it twice.
+
+  The blocks stay in native memory, outside the process heap, until every
+  copy of the result has been garbage collected.
+
+  ## Fields
+
+  - `:columns` - the column names, in SELECT order
+  - `:types` - the ClickHouse type of each column
+  - `:rows` - the total number of rows
+  - `:blocks` - `{block, rows}` of each result block (opaque)
+
+  ## Options
+
+  `column/3`, `columns/3` and `rows/2` take:
+
+  - `:offset` - first row to return (default: 0)
+  - `:limit` - rows to return at most (default: all)
+  """
+
+  alias Natch.Native
+
+  defstruct blocks: [], columns: [], types: [], rows: 0
+
+  @type t :: %__MODULE__{
+          blocks: [{reference(), non_neg_integer()}],
+          columns: [atom()],
+          types: [String.t()],
+          rows: non_neg_integer()
+        }
+
+  @doc false
+  def new({blocks, columns, types}) do
+    rows = Enum.reduce(blocks, 0, fn {_block, rows}, sum -> sum + rows end)
+    %__MODULE__{blocks: blocks, columns: columns, types: types, rows: rows}
+  end
+
+  @doc """
+  The values of one column.
+
+  ## Examples
+
+      {:ok, result} = Natch.select_lazy(conn, "SELECT * FROM events")
+      ids = Natch.LazyResult.column(result, :id, limit: 100)
+  """
+  @spec column(t(), atom(), keyword()) :: list()
+  def column(%__MODULE__{} = result, name, opts \\ []) do
+    index = index!(result, name)
+
+    result
+    |> block_ranges(opts)
+    |> Enum.flat_map(fn {block, offset, count} ->
+      Native.block_column_terms(block, index, offset, count)
+    end)
+  end
+
+  @doc """
+  The values of several columns, as a map of column name to values.
+  """
+  @spec columns(t(), [atom()], keyword()) :: %{atom() => list()}
+  def columns(%__MODULE__{} = result, names, opts \\ []) do
+    Map.new(names, &{&1, column(result, &1, opts)})
+  end
+
+  @doc """
+  Rows as maps. Takes `:columns`, the names to include in each row
+  (default: all), besides `:offset` and `:limit`.
+  """
+  @spec rows(t(), keyword()) :: [map()]
+  def rows(%__MODULE__{} = result, opts \\ []) do
+    indexes = Enum.map(Keyword.get(opts, :columns, result.columns), &index!(result, &1))
+
+    result
+    |> block_ranges(opts)
+    |> Enum.flat_map(fn {block, offset, count} ->
+      Native.block_row_terms(block, indexes, offset, count)
+    end)
+  end
+
+  defp index!(result, name) do
+    Enum.find_index(result.columns, &(&1 == name)) ||
+      raise ArgumentError, "unknown column #{inspect(name)}"
+  end
+
+  # {block, offset, count} of the blocks overlapping [offset, offset + limit)
+  defp block_ranges(result, opts) do
+    first = Keyword.get(opts, :offset, 0)
+    last = min(first + Keyword.get(opts, :limit, result.rows), result.rows)
+
+    {ranges, _start} =
+      Enum.flat_map_reduce(result.blocks, 0, fn {block, rows}, start ->
+        from = max(first - start, 0)
+        to = min(last - start, rows)
+        ranges = if from < to, do: [{block, from, to - from}], else: []
+        {ranges, start + rows}
+      end)
+
+    ranges
+  end
+end
@@ -32,8 +32,11 @@ defmodule Natch.Native do
   def client_execute(_client, _sql), do: :erlang.nif_error(:nif_not_loaded)
   def client_reset_connection(_client), do: :erlang.nif_error(:nif_not_loaded)
 
+  def client_set_decode_options(_client, _sub_binary_strings, _enum_atoms, _decode_threads),
+    do: :erlang.nif_error(:nif_not_loaded)
+
   # Phase 2 - Column NIFs
-  def column_create(_type_name), do: :erlang.nif_error(:nif_not_loaded)
+  def column_create(_type_name, _expected_rows), do: :erlang.nif_error(:nif_not_loaded)
 
   # Single-value append (deprecated, use bulk append for better performance)
   def column_uint64_append(_col, _value), do: :erlang.nif_error(:nif_not_loaded)
@@ -64,6 +67,18 @@ defmodule Natch.Native do
   def column_float32_append_bulk(_col, _values), do: :erlang.nif_error(:nif_not_loaded)
   def column_uuid_append_bulk(_col, _highs, _lows), do: :erlang.nif_error(:nif_not_loaded)
 
+  # Packed little-endian binary append NIFs
+  def column_uint64_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+  def column_uint32_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+  def column_uint16_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+  def column_uint8_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+  def column_int64_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+  def column_int32_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+  def column_int16_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+  def column_int8_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+  def column_float64_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+  def column_float32_append_binary(_col, _packed), do: :erlang.nif_error(:nif_not_loaded)
+
   # Array column NIF
   def column_array_append_from_column(_array_col, _nested_col, _offsets),
     do: :erlang.nif_error(:nif_not_loaded)
@@ -100,6 +115,16 @@ defmodule Natch.Native do
   def block_column_count(_block), do: :erlang.nif_error(:nif_not_loaded)
   def client_insert(_client, _table_name, _block), do: :erlang.nif_error(:nif_not_loaded)
 
+  # Native format data (native_format.cpp)
+  def block_from_native(_data), do: :erlang.nif_error(:nif_not_loaded)
+  def column_append_rows(_columns, _keys, _rows), do: :erlang.nif_error(:nif_not_loaded)
+
+  # Pipelined INSERT NIFs
+  def insert_stream_create(_window, _tag), do: :erlang.nif_error(:nif_not_loaded)
+  def insert_stream_push(_stream, _block), do: :erlang.nif_error(:nif_not_loaded)
+  def insert_stream_close(_stream), do: :erlang.nif_error(:nif_not_loaded)
+  def insert_stream_cancel(_stream), do: :erlang.nif_error(:nif_not_loaded)
+
   # Phase 4 - SELECT NIFs
   def client_select(_client, _query), do: :erlang.nif_error(:nif_not_loaded)
   def client_select_cols(_client, _query), do: :erlang.nif_error(:nif_not_loaded)
@@ -127,9 +152,145 @@ defmodule Natch.Native do
 
   # Query parameter binding - NULL
   def query_bind_null(_query, _name), do: :erlang.nif_error(:nif_not_loaded)
+  def query_bind_all(_query, _params), do: :erlang.nif_error(:nif_not_loaded)
+
+  # Query templates
+  def query_template_create(_sql), do: :erlang.nif_error(:nif_not_loaded)
+  def query_template_bind(_template, _values), do: :erlang.nif_error(:nif_not_loaded)
 
   # Parameterized query execution
   def client_execute_parameterized(_client, _query), do: :erlang.nif_error(:nif_not_loaded)
   def client_select_parameterized(_client, _query), do: :erlang.nif_error(:nif_not_loaded)
   def client_select_cols_parameterized(_client, _query), do: :erlang.nif_error(:nif_not_loaded)
+
+  # Streaming SELECT NIFs
+  def stream_create(_window, _prefetch), do: :erlang.nif_error(:nif_not_loaded)
+  def stream_ack(_stream), do: :erlang.nif_error(:nif_not_loaded)
+  def stream_cancel(_stream), do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_cols_stream_async(
+        _client,
+        _query,
+        _control,
+        _stream,
+        _consumer,
+        _tag,
+        _pid,
+        _ref
+      ),
+      do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_cols_stream_parameterized_async(
+        _client,
+        _query,
+        _control,
+        _stream,
+        _consumer,
+        _tag,
+        _pid,
+        _ref
+      ),
+      do: :erlang.nif_error(:nif_not_loaded)
+
+  # Async NIFs - queue the query on the client's worker thread and reply with
+  # {ref, {:ok, result} | {:error, message}}
+  def client_ping_async(_client, _pid, _ref), do: :erlang.nif_error(:nif_not_loaded)
+  def client_reset_connection_async(_client, _pid, _ref), do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_execute_async(_client, _sql, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_execute_parameterized_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_insert_async(_client, _table_name, _block, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_insert_stream_async(
+        _client,
+        _table_name,
+        _column_names,
+        _stream,
+        _control,
+        _pid,
+        _ref
+      ),
+      do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_parameterized_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_cols_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_cols_parameterized_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_tuples_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_tuples_parameterized_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_packed_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_packed_parameterized_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_arrow_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_arrow_parameterized_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  # Lazy SELECT (lazy.cpp)
+  def client_select_lazy_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def client_select_lazy_parameterized_async(_client, _query, _control, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def block_column_terms(_block, _index, _offset, _count), do: :erlang.nif_error(:nif_not_loaded)
+
+  def block_row_terms(_block, _indexes, _offset, _count), do: :erlang.nif_error(:nif_not_loaded)
+
+  # Scatter-gather SELECT (cluster.cpp)
+  def cluster_select_cols_async(_clients, _sql, _control, _order_by, _descending, _pid, _ref),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def cluster_select_cols_parameterized_async(
+        _clients,
+        _query,
+        _control,
+        _order_by,
+        _descending,
+        _pid,
+        _ref
+      ),
+      do: :erlang.nif_error(:nif_not_loaded)
+
+  # Query cancellation and deadlines
+  def query_control_create(_timeout_ms, _codec, _zstd_level),
+    do: :erlang.nif_error(:nif_not_loaded)
+  def query_control_cancel(_control), do: :erlang.nif_error(:nif_not_loaded)
+
+  # Connection pool NIFs
+  def pool_create(_clients, _partitions), do: :erlang.nif_error(:nif_not_loaded)
+  def pool_checkout(_pool, _scheduler_id), do: :erlang.nif_error(:nif_not_loaded)
+  def pool_checkin(_pool, _index, _healthy), do: :erlang.nif_error(:nif_not_loaded)
+  def pool_wait(_pool), do: :erlang.nif_error(:nif_not_loaded)
+  def pool_unwait(_pool), do: :erlang.nif_error(:nif_not_loaded)
+  def pool_watch(_pool, _index, _control), do: :erlang.nif_error(:nif_not_loaded)
+  def pool_health_check(_pool), do: :erlang.nif_error(:nif_not_loaded)
+  def pool_size(_pool), do: :erlang.nif_error(:nif_not_loaded)
+
+  # Native micro-benchmark NIFs, only built with NATCH_BUILD_BENCH=1
+  def bench_decode(_type_name, _rows, _iterations, _kernel, _sub_binary_strings, _enum_atoms),
+    do: :erlang.nif_error(:nif_not_loaded)
+
+  def bench_allocations, do: :erlang.nif_error(:nif_not_loaded)
 end
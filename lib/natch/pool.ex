@@ -0,0 +1,328 @@
+defmodule Natch.Pool do
+  @moduledoc """
+  A pool of native ClickHouse clients with per-scheduler checkout.
+
+  Unlike `Natch.Connection`, queries on a pool don't go through a GenServer
+  mailbox. The calling process claims a free client directly in native code
+  (a lock-free compare-and-swap on the slot, preferring slots assigned to the
+  caller's scheduler), runs the query on the client's native worker thread
+  and waits for its result, and returns the client. Throughput therefore
+  scales with cores rather than with the number of connection processes.
+
+  When every client is busy, callers queue in native code and the next
+  checkin wakes the longest waiting one, so waiting costs no CPU.
+
+  Queries run under a deadline (`:query_timeout`, or the `:timeout` option
+  of each call) and emit the same telemetry events as `Natch` connections.
+  Their result compression follows `:compression`, except that `:adaptive`
+  stays on LZ4: pool queries don't pass through a process that could
+  measure them.
+
+  The pool process only owns the native pool and periodically pings idle
+  clients. Clients that fail are reset lazily with `ResetConnection` the next
+  time they are checked out, and clients held by processes that died are
+  reclaimed by the health check, which also cancels the query such a
+  process left running.
+
+  ## Options
+
+  Accepts all `Natch.start_link/1` connection options, plus:
+
+  - `:size` - Number of clients (default: `System.schedulers_online()`)
+  - `:checkout_timeout` - Milliseconds to wait for a free client
+    (default: 5000)
+  - `:health_check_interval` - Milliseconds between health pings
+    (default: 30000)
+  - `:name` - Register the pool process under a name
+
+  ## Examples
+
+      {:ok, pool} = Natch.Pool.start_link(host: "localhost", size: 8)
+
+      {:ok, cols} = Natch.Pool.select_cols(pool, "SELECT count() AS n FROM events")
+
+      Natch.Pool.checkout(pool, fn client ->
+        Natch.Native.client_select_cols(client, "SELECT 1 AS x")
+      end)
+  """
+
+  use GenServer
+  alias Natch.Native
+
+  @default_checkout_timeout 5_000
+  @default_health_check_interval 30_000
+
+  @type pool :: GenServer.server()
+
+  @doc """
+  Starts a pool and connects all of its clients.
+  """
+  @spec start_link(keyword()) :: GenServer.on_start()
+  def start_link(opts \\ []) do
+    Natch.Connection.validate_timeout!(opts, :query_timeout)
+    Natch.Connection.validate_decoding!(opts)
+    {gen_opts, opts} = Keyword.split(opts, [:name])
+    GenServer.start_link(__MODULE__, opts, gen_opts)
+  end
+
+  @doc """
+  Stops the pool and closes its clients once they are checked in.
+  """
+  @spec stop(pool()) :: :ok
+  def stop(pool) do
+    GenServer.stop(pool)
+  end
+
+  @doc """
+  Checks out a client, runs `fun` with it in the calling process and checks
+  it back in.
+
+  The client is flagged for a reset if `fun` raises or returns an error that
+  isn't a server-side query error. Returns `{:error, :checkout_timeout}` if no
+  client becomes free in time.
+  """
+  @spec checkout(pool(), (reference() -> result)) :: result | {:error, term()} when result: term()
+  def checkout(pool, fun) when is_function(fun, 1) do
+    with_slot(pool, fn _native, _index, client -> fun.(client) end)
+  end
+
+  @doc """
+  Executes a SELECT and returns rows as maps. See `Natch.select_rows/2`.
+
+  ## Options
+
+  - `:timeout` - Deadline in milliseconds, overriding the pool's
+    `:query_timeout`. Past it the query is cancelled and the result is
+    `{:error, :timeout}`.
+  """
+  @spec select_rows(pool(), String.t() | Natch.Query.t(), keyword()) ::
+          {:ok, [map()]} | {:error, term()}
+  def select_rows(pool, query_or_sql, opts \\ []) do
+    run_query(pool, :select_rows, query_or_sql, opts, &start_select_rows/4)
+  end
+
+  @doc """
+  Executes a SELECT and returns columns as lists. See `Natch.select_cols/2`.
+
+  Takes the same options as `select_rows/3`.
+  """
+  @spec select_cols(pool(), String.t() | Natch.Query.t(), keyword()) ::
+          {:ok, map()} | {:error, term()}
+  def select_cols(pool, query_or_sql, opts \\ []) do
+    run_query(pool, :select_cols, query_or_sql, opts, &start_select_cols/4)
+  end
+
+  @doc """
+  Executes a DDL or DML statement. See `Natch.execute/2`.
+
+  Takes the same options as `select_rows/3`.
+  """
+  @spec execute(pool(), String.t() | Natch.Query.t(), keyword()) :: :ok | {:error, term()}
+  def execute(pool, query_or_sql, opts \\ []) do
+    with {:ok, :ok} <- run_query(pool, :execute, query_or_sql, opts, &start_execute/4), do: :ok
+  end
+
+  @doc """
+  Inserts columnar data. See `Natch.insert_cols/4`.
+  """
+  @spec insert_cols(pool(), String.t(), map(), keyword()) :: :ok | {:error, term()}
+  def insert_cols(pool, table, columns, schema) do
+    block = Natch.Block.build_block(columns, schema)
+
+    checkout(pool, fn client ->
+      case run_job(&Native.client_insert_async(client, table, block, self(), &1)) do
+        {:ok, _} -> :ok
+        {:error, message} -> Natch.Error.handle_callback_error(%RuntimeError{message: message})
+      end
+    end)
+  rescue
+    e -> Natch.Error.handle_callback_error(e)
+  end
+
+  # GenServer callbacks
+
+  @impl true
+  def init(opts) do
+    {pool_opts, client_opts} =
+      Keyword.split(opts, [:size, :checkout_timeout, :health_check_interval, :query_timeout])
+
+    size = Keyword.get(pool_opts, :size, System.schedulers_online())
+    interval = Keyword.get(pool_opts, :health_check_interval, @default_health_check_interval)
+
+    clients =
+      for _ <- 1..size do
+        {:ok, client} = Natch.Connection.build_client(client_opts)
+        client
+      end
+
+    {_codec, compression} = Natch.Compression.new(Keyword.get(client_opts, :compression, true))
+
+    handle = %{
+      pool: Native.pool_create(clients, System.schedulers_online()),
+      checkout_timeout: Keyword.get(pool_opts, :checkout_timeout, @default_checkout_timeout),
+      query_timeout: Keyword.get(pool_opts, :query_timeout, :infinity),
+      compression: compression
+    }
+
+    # Callers look the native pool up without messaging this process
+    :persistent_term.put({__MODULE__, self()}, handle)
+    Process.flag(:trap_exit, true)
+    schedule_health_check(interval)
+
+    {:ok, %{pool: handle.pool, interval: interval}}
+  end
+
+  @impl true
+  def handle_info(:health_check, state) do
+    Native.pool_health_check(state.pool)
+    schedule_health_check(state.interval)
+    {:noreply, state}
+  end
+
+  def handle_info(_msg, state) do
+    {:noreply, state}
+  end
+
+  @impl true
+  def terminate(_reason, _state) do
+    :persistent_term.erase({__MODULE__, self()})
+  end
+
+  # Private functions
+
+  defp handle(pool) do
+    pid = GenServer.whereis(pool) || exit({:noproc, {__MODULE__, :checkout, [pool]}})
+    :persistent_term.get({__MODULE__, pid})
+  end
+
+  # Checks out a slot for `fun.(native, index, client)` and checks it back in
+  defp with_slot(pool, fun) do
+    %{pool: native, checkout_timeout: timeout} = handle(pool)
+    deadline = System.monotonic_time(:millisecond) + timeout
+
+    with {:ok, index, client} <- claim(native, deadline) do
+      try do
+        result = fun.(native, index, client)
+        Native.pool_checkin(native, index, healthy?(result))
+        result
+      catch
+        kind, reason ->
+          Native.pool_checkin(native, index, false)
+          :erlang.raise(kind, reason, __STACKTRACE__)
+      end
+    end
+  end
+
+  # Once every slot is busy, queue for the next checkin (see pool_wait) and
+  # retry in case a slot was freed before we were queued
+  defp claim(native, deadline) do
+    with nil <- checkout_slot(native) do
+      :ok = Native.pool_wait(native)
+
+      case checkout_slot(native) do
+        nil -> await_checkin(native, deadline)
+        slot -> unwait(native, slot)
+      end
+    end
+  end
+
+  defp await_checkin(native, deadline) do
+    receive do
+      :natch_pool_checkin -> claim(native, deadline)
+    after
+      max(deadline - System.monotonic_time(:millisecond), 0) ->
+        unwait(native, {:error, :checkout_timeout})
+    end
+  end
+
+  # Leave the wait queue, dropping a wake-up that came after all
+  defp unwait(native, result) do
+    unless Native.pool_unwait(native) do
+      receive do
+        :natch_pool_checkin -> :ok
+      end
+    end
+
+    result
+  end
+
+  defp checkout_slot(native) do
+    case Native.pool_checkout(native, :erlang.system_info(:scheduler_id)) do
+      {index, client, false} -> {:ok, index, client}
+      {index, client, true} -> reset(native, index, client)
+      nil -> nil
+    end
+  end
+
+  defp reset(native, index, client) do
+    Native.client_reset_connection(client)
+    {:ok, index, client}
+  rescue
+    e ->
+      Native.pool_checkin(native, index, false)
+      Natch.Error.handle_callback_error(e)
+  end
+
+  # Run a query on a checked out client under a control for its deadline,
+  # reporting it like Natch.Connection does
+  # The health check cancels the query if the caller dies (see pool_watch)
+  defp run_query(pool, kind, query, opts, start) do
+    Natch.Connection.validate_timeout!(opts, :timeout)
+    %{query_timeout: query_timeout, compression: compression} = handle(pool)
+    timeout = Keyword.get(opts, :timeout, query_timeout)
+
+    with_slot(pool, fn native, index, client ->
+      {control, telemetry} = Natch.Connection.query_control(kind, query, timeout, compression)
+      :ok = Native.pool_watch(native, index, control)
+      Natch.Connection.complete_query(telemetry, run_job(&start.(client, query, control, &1)))
+    end)
+  end
+
+  # Queue a job on the client's worker thread and wait for its
+  # {:ok, result} | {:error, message} reply. The reply always comes: a query
+  # that runs too long is stopped by its control.
+  defp run_job(start) do
+    ref = make_ref()
+
+    try do
+      :ok = start.(ref)
+
+      receive do
+        {^ref, result} -> result
+      end
+    rescue
+      e -> {:error, Exception.message(e)}
+    end
+  end
+
+  defp start_select_rows(client, %Natch.Query{} = query, control, ref),
+    do: Native.client_select_parameterized_async(client, query.ref, control, self(), ref)
+
+  defp start_select_rows(client, sql, control, ref) when is_binary(sql),
+    do: Native.client_select_async(client, sql, control, self(), ref)
+
+  defp start_select_cols(client, %Natch.Query{} = query, control, ref),
+    do: Native.client_select_cols_parameterized_async(client, query.ref, control, self(), ref)
+
+  defp start_select_cols(client, sql, control, ref) when is_binary(sql),
+    do: Native.client_select_cols_async(client, sql, control, self(), ref)
+
+  defp start_execute(client, %Natch.Query{} = query, control, ref),
+    do: Native.client_execute_parameterized_async(client, query.ref, control, self(), ref)
+
+  defp start_execute(client, sql, control, ref) when is_binary(sql),
+    do: Native.client_execute_async(client, sql, control, self(), ref)
+
+  # Server errors leave the connection usable, as do stopped queries (the
+  # worker resets an interrupted one); anything else is treated as a broken
+  # connection and triggers a reset on the next checkout
+  defp healthy?({:error, %{type: "protocol"}}), do: false
+  defp healthy?({:error, %{type: _type}}), do: true
+  defp healthy?({:error, reason}) when reason in [:timeout, :cancelled], do: true
+  defp healthy?({:error, _reason}), do: false
+  defp healthy?(_result), do: true
+
+  defp schedule_health_check(interval) do
+    Process.send_after(self(), :health_check, interval)
+  end
+end
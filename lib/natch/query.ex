@@ -88,12 +88,24 @@ defmodule Natch.Query do
   - `UInt32`, `UInt16`, `UInt8`
   - `Float32`
   - `DateTime64`
+
+  ## Prepared Templates
+
+  A query run many times with different values can be prepared once with
+  `prepare/1`. Its placeholders are parsed into positional slots, and
+  `bind_slots/2` binds every slot in a single NIF call:
+
+      lookup = Natch.Query.prepare("SELECT * FROM users WHERE id = {id:UInt64}")
+
+      {:ok, rows} = Natch.select_rows(conn, Natch.Query.bind_slots(lookup, {42}))
   """
 
   @type t :: %__MODULE__{
           sql: String.t(),
           params: %{optional(atom()) => param_value()},
-          ref: reference()
+          ref: reference(),
+          template: reference() | nil,
+          slots: [{atom(), String.t()}] | nil
         }
 
   @type param_value :: integer() | float() | String.t() | DateTime.t() | Date.t() | nil
@@ -113,7 +125,7 @@ defmodule Natch.Query do
           | :datetime64
           | :date
 
-  defstruct [:sql, :params, :ref]
+  defstruct [:sql, :params, :ref, :template, :slots]
 
   @doc """
   Creates a new parameterized query.
@@ -215,8 +227,8 @@ defmodule Natch.Query do
   @doc """
   Binds multiple parameters from a keyword list or map.
 
-  This is a convenience function that calls `bind/3` for each parameter,
-  using automatic type inference. For explicit type control, use `bind/4`
+  Every parameter is bound in a single NIF call, using the same automatic
+  type inference as `bind/3`. For explicit type control, use `bind/4`
   individually.
 
   ## Examples
@@ -235,18 +247,79 @@ defmodule Natch.Query do
       |> Natch.Query.bind_all([])
   """
   @spec bind_all(t(), keyword() | map()) :: t()
-  def bind_all(%__MODULE__{} = query, params) when is_list(params) do
-    Enum.reduce(params, query, fn {key, value}, acc ->
-      bind(acc, key, value)
-    end)
+  def bind_all(%__MODULE__{} = query, params) when is_list(params) or is_map(params) do
+    bound = Enum.map(params, fn {key, value} -> {key, native_value(value, "")} end)
+    :ok = Natch.Native.query_bind_all(query.ref, bound)
+
+    %{query | params: Enum.into(params, query.params)}
   end
 
-  def bind_all(%__MODULE__{} = query, params) when is_map(params) do
-    Enum.reduce(params, query, fn {key, value}, acc ->
-      bind(acc, key, value)
-    end)
+  @doc """
+  Prepares a query template whose parameters are bound by position.
+
+  The `{name:Type}` placeholders are parsed once, in order of first
+  appearance, into the template's slots (listed in `:slots` as
+  `{name, type}`). The result is a regular query that can also be bound by
+  name with `bind/3`.
+
+  ## Examples
+
+      iex> query = Natch.Query.prepare("SELECT {a:UInt64} + {b:UInt64} AS sum")
+      iex> query.slots
+      [a: "UInt64", b: "UInt64"]
+  """
+  @spec prepare(String.t()) :: t()
+  def prepare(sql) when is_binary(sql) do
+    {template, ref, slots} = Natch.Native.query_template_create(sql)
+    slots = Enum.map(slots, fn {name, type} -> {String.to_atom(name), type} end)
+
+    %__MODULE__{sql: sql, params: %{}, ref: ref, template: template, slots: slots}
   end
 
+  @doc """
+  Binds a value to every slot of a prepared template, in slot order.
+
+  `values` is a tuple or list with one value per slot. Integers, floats,
+  strings, `DateTime` (`DateTime64` slots take microseconds), `Date` and
+  `nil` are accepted.
+
+  Each binding returns a query of its own and leaves the prepared one
+  untouched, so the same prepared query can be bound concurrently, and a
+  bound query stays valid while the template is bound again.
+
+  ## Examples
+
+      query = Natch.Query.prepare("SELECT * FROM t WHERE id = {id:UInt64} AND k = {k:String}")
+      query = Natch.Query.bind_slots(query, {42, "key"})
+  """
+  @spec bind_slots(t(), tuple() | list()) :: t()
+  def bind_slots(%__MODULE__{} = query, values) when is_tuple(values),
+    do: bind_slots(query, Tuple.to_list(values))
+
+  def bind_slots(%__MODULE__{template: template, slots: slots} = query, values)
+      when is_reference(template) and is_list(values) do
+    if length(values) != length(slots) do
+      raise ArgumentError, "Expected #{length(slots)} parameter values, got #{length(values)}"
+    end
+
+    bound = Enum.zip_with(values, slots, fn value, {_name, type} -> native_value(value, type) end)
+    ref = Natch.Native.query_template_bind(template, bound)
+
+    params = slots |> Enum.map(&elem(&1, 0)) |> Enum.zip(values) |> Map.new()
+    %{query | params: params, ref: ref}
+  end
+
+  # Values as the batch binding NIFs take them: DateTime as Unix seconds
+  # (microseconds for a DateTime64 slot) and Date as days since the epoch
+  defp native_value(%DateTime{} = value, type) do
+    if String.contains?(type, "DateTime64"),
+      do: DateTime.to_unix(value, :microsecond),
+      else: DateTime.to_unix(value)
+  end
+
+  defp native_value(%Date{} = value, _type), do: Date.to_gregorian_days(value) - 719_528
+  defp native_value(value, _type), do: value
+
   # Private: Bind value with automatic type inference
   defp bind_value(ref, name, value) when is_integer(value) and value >= 0 do
     Natch.Native.query_bind_uint64(ref, name, value)
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <clickhouse/columns/array.h>
+#include <cstddef>
+
+// ColumnArray keeps its flattened data and offsets protected (they're meant
+// for ColumnArrayT). Member pointers formed through a derived class give
+// access to them, so arrays can be decoded without GetAsColumn(), which
+// slices a new column out of the data for every row, and their data can be
+// reserved ahead of an append.
+struct ArrayColumnAccess : clickhouse::ColumnArray {
+  static clickhouse::ColumnRef data(clickhouse::ColumnArray &col) {
+    return (col.*(&ArrayColumnAccess::GetData))();
+  }
+
+  // Index of row n's first element in data()
+  static size_t offset(const clickhouse::ColumnArray &col, size_t n) {
+    return (col.*(&ArrayColumnAccess::GetOffset))(n);
+  }
+
+  static size_t size(const clickhouse::ColumnArray &col, size_t n) {
+    return (col.*(&ArrayColumnAccess::GetSize))(n);
+  }
+};
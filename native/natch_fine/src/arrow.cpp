@@ -0,0 +1,741 @@
+// arrow.cpp - SELECT results as an Arrow IPC stream (see arrow.h)
+//
+// Columns are converted into a tree of ArrowArrays (one per Arrow array,
+// with children for list values), then the stream is sized and written into
+// a single binary. Leaf columns reuse pack_parts from packed.cpp; only
+// Array offsets, LowCardinality dictionaries and bit-packed Bools are built
+// here.
+//
+// The IPC metadata is a flatbuffer per message. The handful of tables in
+// Arrow's Schema.fbs and Message.fbs that a result needs are written with
+// FlatBuilder below rather than generated code, so the NIF doesn't depend on
+// flatbuffers or the Arrow libraries. Field ids in the encode_* functions are
+// the declaration order in those schemas (a union takes two: its type tag,
+// then its value).
+
+#include <fine.hpp>
+#include <clickhouse/block.h>
+#include <clickhouse/columns/column.h>
+#include <clickhouse/columns/array.h>
+#include <clickhouse/columns/lowcardinality.h>
+#include <clickhouse/types/types.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "arrow.h"
+#include "array_access.h"
+#include "packed.h"
+
+using namespace clickhouse;
+
+namespace {
+
+// Arrow Type union tags (Schema.fbs)
+constexpr uint8_t kArrowInt = 2;
+constexpr uint8_t kArrowFloatingPoint = 3;
+constexpr uint8_t kArrowBool = 6;
+constexpr uint8_t kArrowDate = 8;
+constexpr uint8_t kArrowTimestamp = 10;
+constexpr uint8_t kArrowLargeUtf8 = 20;
+constexpr uint8_t kArrowLargeList = 21;
+
+// MessageHeader union tags (Message.fbs)
+constexpr uint8_t kSchemaMessage = 1;
+constexpr uint8_t kDictionaryBatchMessage = 2;
+constexpr uint8_t kRecordBatchMessage = 3;
+
+constexpr int16_t kMetadataV5 = 4;
+constexpr uint32_t kContinuation = 0xFFFFFFFF;
+
+size_t pad8(size_t size) { return (size + 7) & ~size_t(7); }
+
+// ============================================================================
+// Flatbuffers
+// ============================================================================
+
+// Builds a flatbuffer back to front, as the flatbuffers library does: objects
+// are added children first and referred to by their distance from the end of
+// the buffer, which stays valid while the buffer grows at the front. Only one
+// table can be under construction at a time.
+class FlatBuilder {
+public:
+  using Ref = uint32_t;
+
+  template <typename T>
+  void push(T value) {
+    align(sizeof(T), sizeof(T));
+    prepend(&value, sizeof(T));
+  }
+
+  // Pad so that `size` bytes added next start at a multiple of `alignment`
+  void align(size_t size, size_t alignment) {
+    max_align_ = std::max(max_align_, alignment);
+    size_t pad = (alignment - (buf_.size() + size) % alignment) % alignment;
+    buf_.insert(buf_.begin(), pad, 0);
+  }
+
+  // A uoffset to `target`, relative to where it is written
+  void push_ref(Ref target) {
+    align(sizeof(uint32_t), sizeof(uint32_t));
+    push<uint32_t>(static_cast<uint32_t>(buf_.size() + sizeof(uint32_t) - target));
+  }
+
+  Ref string(std::string_view s) {
+    align(s.size() + 1, sizeof(uint32_t));
+    buf_.insert(buf_.begin(), 0);
+    prepend(s.data(), s.size());
+    push<uint32_t>(static_cast<uint32_t>(s.size()));
+    return here();
+  }
+
+  // Vector of fixed-size structs made of 8-byte fields
+  template <typename T>
+  Ref struct_vector(const std::vector<T> &items) {
+    align(items.size() * sizeof(T), 8);
+    prepend(items.data(), items.size() * sizeof(T));
+    push<uint32_t>(static_cast<uint32_t>(items.size()));
+    return here();
+  }
+
+  Ref ref_vector(const std::vector<Ref> &refs) {
+    align(refs.size() * sizeof(uint32_t), sizeof(uint32_t));
+    for (auto it = refs.rbegin(); it != refs.rend(); ++it) {
+      push_ref(*it);
+    }
+    push<uint32_t>(static_cast<uint32_t>(refs.size()));
+    return here();
+  }
+
+  void start_table() {
+    fields_.clear();
+    table_end_ = here();
+  }
+
+  template <typename T>
+  void add_field(uint16_t id, T value) {
+    push(value);
+    fields_.emplace_back(id, here());
+  }
+
+  void add_ref_field(uint16_t id, Ref ref) {
+    push_ref(ref);
+    fields_.emplace_back(id, here());
+  }
+
+  // Write the table's vtable (just before it) and return the table
+  Ref end_table() {
+    push<int32_t>(0);
+    Ref table = here();
+
+    uint16_t count = 0;
+    for (const auto &field : fields_) {
+      count = std::max<uint16_t>(count, field.first + 1);
+    }
+    std::vector<uint16_t> slots(count, 0);
+    for (const auto &[id, at] : fields_) {
+      slots[id] = static_cast<uint16_t>(table - at);
+    }
+
+    for (auto it = slots.rbegin(); it != slots.rend(); ++it) {
+      push<uint16_t>(*it);
+    }
+    push<uint16_t>(static_cast<uint16_t>(table - table_end_));
+    push<uint16_t>(static_cast<uint16_t>((count + 2) * sizeof(uint16_t)));
+
+    // The table starts with the signed distance back to its vtable
+    int32_t to_vtable = static_cast<int32_t>(here() - table);
+    std::memcpy(buf_.data() + buf_.size() - table, &to_vtable, sizeof(to_vtable));
+    return table;
+  }
+
+  std::vector<uint8_t> finish(Ref root) {
+    align(sizeof(uint32_t), max_align_);
+    push_ref(root);
+    return std::move(buf_);
+  }
+
+private:
+  Ref here() const { return static_cast<Ref>(buf_.size()); }
+
+  void prepend(const void *data, size_t size) {
+    auto bytes = static_cast<const uint8_t *>(data);
+    buf_.insert(buf_.begin(), bytes, bytes + size);
+  }
+
+  std::vector<uint8_t> buf_;
+  size_t max_align_ = 1;
+  std::vector<std::pair<uint16_t, Ref>> fields_;
+  Ref table_end_ = 0;
+};
+
+// ============================================================================
+// Arrays
+// ============================================================================
+
+// One Arrow buffer: handed over from a PackedColumn or built here
+struct ArrowBuffer {
+  OwnedBinary binary;
+  std::vector<uint8_t> bytes;
+
+  ArrowBuffer() = default;
+  explicit ArrowBuffer(OwnedBinary binary) : binary(std::move(binary)) {}
+  explicit ArrowBuffer(std::vector<uint8_t> bytes) : bytes(std::move(bytes)) {}
+
+  const uint8_t *data() const { return binary ? binary.data() : bytes.data(); }
+  size_t size() const { return binary ? binary.size() : bytes.size(); }
+};
+
+struct ArrowArray {
+  std::string name;
+  bool nullable = false;
+  int64_t length = 0;
+  int64_t null_count = 0;
+
+  // Arrow type: a Type union tag and the parameters it uses
+  uint8_t type = 0;
+  int32_t bit_width = 0;   // Int
+  bool is_signed = false;  // Int
+  int16_t precision = 0;   // FloatingPoint: 1 single, 2 double
+  int16_t unit = 0;        // Date: 0 days. Timestamp: 0 s .. 3 ns
+
+  // Dictionary-encoded arrays hold Int32 indices into dictionaries[id]
+  int64_t dictionary_id = -1;
+
+  // In Arrow layout order: validity, then offsets and/or values
+  std::vector<ArrowBuffer> buffers;
+  std::vector<ArrowArray> children;
+};
+
+struct ArrowResult {
+  std::vector<ArrowArray> columns;
+  std::vector<ArrowArray> dictionaries;
+  int64_t rows = 0;
+};
+
+void set_int(ArrowArray &array, int32_t bit_width, bool is_signed) {
+  array.type = kArrowInt;
+  array.bit_width = bit_width;
+  array.is_signed = is_signed;
+}
+
+// Arrow type of a leaf column, checked before packing so unsupported types
+// fail with the column's type name
+void set_leaf_type(ArrowArray &array, const clickhouse::Type &type) {
+  switch (type.GetCode()) {
+  case Type::UInt64:
+    return set_int(array, 64, false);
+  case Type::UInt32:
+    return set_int(array, 32, false);
+  case Type::UInt16:
+    return set_int(array, 16, false);
+  case Type::UInt8:
+    if (type.GetName() == "Bool") {
+      array.type = kArrowBool;
+      return;
+    }
+    return set_int(array, 8, false);
+  case Type::Int64:
+    return set_int(array, 64, true);
+  case Type::Int32:
+    return set_int(array, 32, true);
+  case Type::Int16:
+    return set_int(array, 16, true);
+  case Type::Int8:
+    return set_int(array, 8, true);
+  case Type::Float64:
+    array.type = kArrowFloatingPoint;
+    array.precision = 2;
+    return;
+  case Type::Float32:
+    array.type = kArrowFloatingPoint;
+    array.precision = 1;
+    return;
+  case Type::Date:
+  case Type::Date32:
+    array.type = kArrowDate;
+    return;
+  case Type::DateTime:
+  case Type::DateTime64:
+    array.type = kArrowTimestamp;
+    return;
+  case Type::String:
+    array.type = kArrowLargeUtf8;
+    return;
+  default:
+    throw std::runtime_error("Unsupported column type for Arrow results: " + type.GetName());
+  }
+}
+
+int64_t count_nulls(const OwnedBinary &validity, size_t rows) {
+  if (!validity) {
+    return 0;
+  }
+
+  size_t valid = 0;
+  for (size_t row = 0; row < rows; row++) {
+    valid += (validity.data()[row / 8] >> (row % 8)) & 1;
+  }
+  return static_cast<int64_t>(rows - valid);
+}
+
+std::vector<uint8_t> pack_bits(const OwnedBinary &bytes, size_t rows) {
+  std::vector<uint8_t> bits((rows + 7) / 8, 0);
+  for (size_t row = 0; row < rows; row++) {
+    if (bytes.data()[row]) {
+      bits[row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+    }
+  }
+  return bits;
+}
+
+// Arrow timestamps only have second, milli, micro and nanosecond units, so
+// DateTime64 ticks are scaled up to the next unit that holds their precision
+void set_timestamp_unit(ArrowArray &array, PackedColumn &packed) {
+  int precision = std::max(packed.precision, 0);
+  array.unit = static_cast<int16_t>((precision + 2) / 3);
+
+  int64_t scale = 1;
+  for (int p = precision; p < array.unit * 3; p++) {
+    scale *= 10;
+  }
+  if (scale > 1) {
+    auto *ticks = reinterpret_cast<int64_t *>(packed.data.data());
+    for (size_t i = 0; i < packed.rows; i++) {
+      ticks[i] *= scale;
+    }
+  }
+}
+
+ArrowArray convert_column(
+    std::string name,
+    std::vector<ColumnRef> parts,
+    size_t rows,
+    ArrowResult &result);
+
+ArrowArray convert_leaf(std::string name, std::vector<ColumnRef> parts, size_t rows) {
+  ArrowArray array;
+  array.name = name;
+  array.length = static_cast<int64_t>(rows);
+
+  const auto &type = *parts[0]->Type();
+  array.nullable = type.GetCode() == Type::Nullable;
+  set_leaf_type(array, array.nullable ? *type.As<NullableType>()->GetNestedType() : type);
+
+  PackedColumn packed = pack_parts(std::move(name), std::move(parts), rows);
+  array.null_count = count_nulls(packed.validity, rows);
+  array.buffers.emplace_back(std::move(packed.validity));
+
+  if (array.type == kArrowBool) {
+    array.buffers.emplace_back(pack_bits(packed.data, rows));
+    return array;
+  }
+  if (array.type == kArrowTimestamp) {
+    set_timestamp_unit(array, packed);
+  }
+  if (packed.offsets) {
+    array.buffers.emplace_back(std::move(packed.offsets));
+  }
+  array.buffers.emplace_back(std::move(packed.data));
+  return array;
+}
+
+std::vector<uint8_t> make_offsets(size_t rows) {
+  return std::vector<uint8_t>((rows + 1) * sizeof(int64_t));
+}
+
+// Array(T) becomes a LargeList whose child holds the elements of all blocks
+ArrowArray convert_array(
+    std::string name,
+    std::vector<ColumnRef> parts,
+    size_t rows,
+    ArrowResult &result) {
+  ArrowArray array;
+  array.name = std::move(name);
+  array.type = kArrowLargeList;
+  array.length = static_cast<int64_t>(rows);
+
+  std::vector<uint8_t> offsets = make_offsets(rows);
+  auto *out = reinterpret_cast<int64_t *>(offsets.data());
+  *out++ = 0;
+
+  std::vector<ColumnRef> elements;
+  elements.reserve(parts.size());
+  size_t base = 0;
+  for (const auto &part : parts) {
+    auto &col = *part->As<ColumnArray>();
+    for (size_t i = 0; i < col.Size(); i++) {
+      *out++ = static_cast<int64_t>(
+          base + ArrayColumnAccess::offset(col, i) + ArrayColumnAccess::size(col, i));
+    }
+    ColumnRef data = ArrayColumnAccess::data(col);
+    base += data->Size();
+    elements.push_back(data);
+  }
+
+  array.buffers.emplace_back();
+  array.buffers.emplace_back(std::move(offsets));
+  array.children.push_back(convert_column("item", std::move(elements), base, result));
+  return array;
+}
+
+// LowCardinality(String) becomes Int32 indices into one dictionary shared by
+// all blocks (each block has its own ClickHouse dictionary)
+ArrowArray convert_lowcardinality(
+    std::string name,
+    const std::vector<ColumnRef> &parts,
+    size_t rows,
+    ArrowResult &result) {
+  ArrowArray array;
+  array.name = std::move(name);
+  array.type = kArrowLargeUtf8;
+  array.length = static_cast<int64_t>(rows);
+
+  const auto &nested = *parts[0]->Type()->As<LowCardinalityType>()->GetNestedType();
+  array.nullable = nested.GetCode() == Type::Nullable;
+
+  std::vector<uint8_t> validity(array.nullable ? (rows + 7) / 8 : 0, 0);
+  std::vector<uint8_t> indices(rows * sizeof(int32_t));
+  auto *index = reinterpret_cast<int32_t *>(indices.data());
+
+  std::unordered_map<std::string_view, int32_t> positions;
+  std::vector<std::string_view> values;
+  size_t total = 0;
+  size_t row = 0;
+
+  for (const auto &part : parts) {
+    const auto &col = *part->As<ColumnLowCardinality>();
+    for (size_t i = 0; i < col.Size(); i++, row++) {
+      auto item = col.GetItem(i);
+      if (item.type == Type::Void) {
+        array.null_count++;
+        index[row] = 0;
+        continue;
+      }
+      if (item.type != Type::String) {
+        throw std::runtime_error("Unsupported LowCardinality inner type");
+      }
+
+      auto value = item.get<std::string_view>();
+      auto [it, inserted] = positions.emplace(value, static_cast<int32_t>(values.size()));
+      if (inserted) {
+        values.push_back(value);
+        total += value.size();
+      }
+      index[row] = it->second;
+      if (array.nullable) {
+        validity[row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+      }
+    }
+  }
+
+  // Null rows point at entry 0, which must exist
+  if (values.empty() && rows > 0) {
+    values.emplace_back();
+  }
+
+  ArrowArray dictionary;
+  dictionary.type = kArrowLargeUtf8;
+  dictionary.length = static_cast<int64_t>(values.size());
+
+  std::vector<uint8_t> offsets = make_offsets(values.size());
+  std::vector<uint8_t> data(total);
+  auto *offset = reinterpret_cast<int64_t *>(offsets.data());
+  int64_t at = 0;
+  *offset++ = 0;
+  for (auto value : values) {
+    std::memcpy(data.data() + at, value.data(), value.size());
+    at += value.size();
+    *offset++ = at;
+  }
+
+  dictionary.buffers.emplace_back();
+  dictionary.buffers.emplace_back(std::move(offsets));
+  dictionary.buffers.emplace_back(std::move(data));
+
+  array.dictionary_id = static_cast<int64_t>(result.dictionaries.size());
+  result.dictionaries.push_back(std::move(dictionary));
+
+  array.buffers.emplace_back(std::move(validity));
+  array.buffers.emplace_back(std::move(indices));
+  return array;
+}
+
+ArrowArray convert_column(
+    std::string name,
+    std::vector<ColumnRef> parts,
+    size_t rows,
+    ArrowResult &result) {
+  switch (parts[0]->Type()->GetCode()) {
+  case Type::Array:
+    return convert_array(std::move(name), std::move(parts), rows, result);
+  case Type::LowCardinality:
+    return convert_lowcardinality(std::move(name), parts, rows, result);
+  default:
+    return convert_leaf(std::move(name), std::move(parts), rows);
+  }
+}
+
+ArrowResult convert_blocks(const std::vector<Block> &blocks) {
+  ArrowResult result;
+  if (blocks.empty()) {
+    return result;
+  }
+
+  for (const auto &block : blocks) {
+    result.rows += static_cast<int64_t>(block.GetRowCount());
+  }
+
+  const auto &first = blocks.front();
+  for (size_t c = 0; c < first.GetColumnCount(); c++) {
+    std::vector<ColumnRef> parts;
+    parts.reserve(blocks.size());
+    for (const auto &block : blocks) {
+      parts.push_back(block[c]);
+    }
+    result.columns.push_back(
+        convert_column(first.GetColumnName(c), std::move(parts), result.rows, result));
+  }
+  return result;
+}
+
+// ============================================================================
+// Messages
+// ============================================================================
+
+// FieldNode and Buffer structs of a RecordBatch
+struct FieldNodeEntry {
+  int64_t length;
+  int64_t null_count;
+};
+
+struct BufferEntry {
+  int64_t offset;
+  int64_t length;
+};
+
+// The arrays of one batch flattened in depth-first order, with the position
+// of each buffer in the message body
+struct BatchLayout {
+  std::vector<FieldNodeEntry> nodes;
+  std::vector<BufferEntry> buffers;
+  std::vector<const ArrowBuffer *> bodies;
+  int64_t body_length = 0;
+
+  void add(const ArrowArray &array) {
+    nodes.push_back({array.length, array.null_count});
+    for (const auto &buffer : array.buffers) {
+      buffers.push_back({body_length, static_cast<int64_t>(buffer.size())});
+      bodies.push_back(&buffer);
+      body_length += static_cast<int64_t>(pad8(buffer.size()));
+    }
+    for (const auto &child : array.children) {
+      add(child);
+    }
+  }
+};
+
+struct Message {
+  std::vector<uint8_t> metadata;
+  BatchLayout body;
+};
+
+FlatBuilder::Ref encode_int_type(FlatBuilder &b, int32_t bit_width, bool is_signed) {
+  b.start_table();
+  b.add_field<int32_t>(0, bit_width);
+  b.add_field<uint8_t>(1, is_signed);
+  return b.end_table();
+}
+
+FlatBuilder::Ref encode_type(FlatBuilder &b, const ArrowArray &array) {
+  if (array.type == kArrowInt) {
+    return encode_int_type(b, array.bit_width, array.is_signed);
+  }
+
+  FlatBuilder::Ref timezone = array.type == kArrowTimestamp ? b.string("UTC") : 0;
+
+  b.start_table();
+  if (array.type == kArrowFloatingPoint) {
+    b.add_field<int16_t>(0, array.precision);
+  } else if (array.type == kArrowDate) {
+    b.add_field<int16_t>(0, 0);
+  } else if (array.type == kArrowTimestamp) {
+    b.add_field<int16_t>(0, array.unit);
+    b.add_ref_field(1, timezone);
+  }
+  return b.end_table();
+}
+
+FlatBuilder::Ref encode_field(FlatBuilder &b, const ArrowArray &array) {
+  std::vector<FlatBuilder::Ref> children;
+  for (const auto &child : array.children) {
+    children.push_back(encode_field(b, child));
+  }
+
+  FlatBuilder::Ref children_ref = b.ref_vector(children);
+  FlatBuilder::Ref name = b.string(array.name);
+  FlatBuilder::Ref type = encode_type(b, array);
+
+  FlatBuilder::Ref dictionary = 0;
+  if (array.dictionary_id >= 0) {
+    FlatBuilder::Ref index_type = encode_int_type(b, 32, true);
+    b.start_table();
+    b.add_field<int64_t>(0, array.dictionary_id);
+    b.add_ref_field(1, index_type);
+    dictionary = b.end_table();
+  }
+
+  b.start_table();
+  b.add_ref_field(0, name);
+  b.add_field<uint8_t>(1, array.nullable);
+  b.add_field<uint8_t>(2, array.type);
+  b.add_ref_field(3, type);
+  if (dictionary) {
+    b.add_ref_field(4, dictionary);
+  }
+  b.add_ref_field(5, children_ref);
+  return b.end_table();
+}
+
+FlatBuilder::Ref encode_record_batch(FlatBuilder &b, int64_t length, const BatchLayout &layout) {
+  FlatBuilder::Ref nodes = b.struct_vector(layout.nodes);
+  FlatBuilder::Ref buffers = b.struct_vector(layout.buffers);
+
+  b.start_table();
+  b.add_field<int64_t>(0, length);
+  b.add_ref_field(1, nodes);
+  b.add_ref_field(2, buffers);
+  return b.end_table();
+}
+
+std::vector<uint8_t> finish_message(
+    FlatBuilder &b,
+    uint8_t header_type,
+    FlatBuilder::Ref header,
+    int64_t body_length) {
+  b.start_table();
+  b.add_field<int64_t>(3, body_length);
+  b.add_ref_field(2, header);
+  b.add_field<int16_t>(0, kMetadataV5);
+  b.add_field<uint8_t>(1, header_type);
+  return b.finish(b.end_table());
+}
+
+Message schema_message(const ArrowResult &result) {
+  FlatBuilder b;
+  std::vector<FlatBuilder::Ref> fields;
+  for (const auto &column : result.columns) {
+    fields.push_back(encode_field(b, column));
+  }
+  FlatBuilder::Ref fields_ref = b.ref_vector(fields);
+
+  b.start_table();
+  b.add_field<int16_t>(0, 0);  // Little endian
+  b.add_ref_field(1, fields_ref);
+  FlatBuilder::Ref schema = b.end_table();
+
+  return {finish_message(b, kSchemaMessage, schema, 0), {}};
+}
+
+Message dictionary_message(int64_t id, const ArrowArray &dictionary) {
+  Message message;
+  message.body.add(dictionary);
+
+  FlatBuilder b;
+  FlatBuilder::Ref data = encode_record_batch(b, dictionary.length, message.body);
+  b.start_table();
+  b.add_field<int64_t>(0, id);
+  b.add_ref_field(1, data);
+  FlatBuilder::Ref batch = b.end_table();
+
+  message.metadata =
+      finish_message(b, kDictionaryBatchMessage, batch, message.body.body_length);
+  return message;
+}
+
+Message record_batch_message(const ArrowResult &result) {
+  Message message;
+  for (const auto &column : result.columns) {
+    message.body.add(column);
+  }
+
+  FlatBuilder b;
+  FlatBuilder::Ref batch = encode_record_batch(b, result.rows, message.body);
+  message.metadata = finish_message(b, kRecordBatchMessage, batch, message.body.body_length);
+  return message;
+}
+
+// Writes encapsulated messages: continuation marker, metadata length,
+// metadata padded to 8 bytes, then the body
+class StreamWriter {
+public:
+  explicit StreamWriter(unsigned char *out) : out_(out) {}
+
+  static size_t size(const Message &message) {
+    return 2 * sizeof(uint32_t) + pad8(message.metadata.size()) +
+           static_cast<size_t>(message.body.body_length);
+  }
+
+  void write(const Message &message) {
+    write_u32(kContinuation);
+    write_u32(static_cast<uint32_t>(pad8(message.metadata.size())));
+    write_padded(message.metadata.data(), message.metadata.size());
+    for (const auto *buffer : message.body.bodies) {
+      write_padded(buffer->data(), buffer->size());
+    }
+  }
+
+  void write_end() {
+    write_u32(kContinuation);
+    write_u32(0);
+  }
+
+private:
+  void write_u32(uint32_t value) {
+    std::memcpy(out_, &value, sizeof(value));
+    out_ += sizeof(value);
+  }
+
+  void write_padded(const void *data, size_t size) {
+    if (size > 0) {
+      std::memcpy(out_, data, size);
+    }
+    std::memset(out_ + size, 0, pad8(size) - size);
+    out_ += pad8(size);
+  }
+
+  unsigned char *out_;
+};
+
+}  // namespace
+
+ERL_NIF_TERM make_arrow_stream(ErlNifEnv *env, const std::vector<Block> &blocks) {
+  ArrowResult result = convert_blocks(blocks);
+
+  std::vector<Message> messages;
+  messages.push_back(schema_message(result));
+  for (size_t id = 0; id < result.dictionaries.size(); id++) {
+    messages.push_back(dictionary_message(static_cast<int64_t>(id), result.dictionaries[id]));
+  }
+  messages.push_back(record_batch_message(result));
+
+  size_t total = 2 * sizeof(uint32_t);
+  for (const auto &message : messages) {
+    total += StreamWriter::size(message);
+  }
+
+  OwnedBinary stream(total);
+  StreamWriter writer(stream.data());
+  for (const auto &message : messages) {
+    writer.write(message);
+  }
+  writer.write_end();
+
+  return stream.release(env);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <fine.hpp>
+#include <clickhouse/block.h>
+#include <vector>
+
+// Arrow IPC SELECT results (defined in arrow.cpp)
+//
+// A result is written as one Arrow IPC stream (the format read by
+// pyarrow.ipc.open_stream, Polars and Explorer.DataFrame.load_ipc_stream):
+// a Schema message, one DictionaryBatch per LowCardinality column, a single
+// RecordBatch holding every row, and the end-of-stream marker. Column buffers
+// are built from the blocks with the packed layout (see packed.h), so no
+// per-value terms are created. Types map as:
+//
+//   UInt*/Int*          Int
+//   Float32/Float64     FloatingPoint
+//   Bool                Bool (bit-packed)
+//   String              LargeUtf8
+//   Date/Date32         Date (days)
+//   DateTime/64         Timestamp in UTC, at the coarsest unit that holds
+//                       the precision
+//   Array(T)            LargeList<T>
+//   LowCardinality      dictionary-encoded LargeUtf8 with Int32 indices
+//   Nullable(T)         T with a validity bitmap
+
+// Collects the blocks of a result for make_arrow_stream. The first block is
+// kept even when empty, so empty results still carry their schema.
+struct ArrowCollector {
+  std::vector<clickhouse::Block> blocks;
+
+  void operator()(const clickhouse::Block &block) {
+    if (block.GetRowCount() > 0 || blocks.empty()) {
+      blocks.push_back(block);
+    }
+  }
+};
+
+// The Arrow IPC stream for `blocks` (which share one schema) as a binary.
+// Throws for column types without an Arrow mapping.
+ERL_NIF_TERM make_arrow_stream(ErlNifEnv *env, const std::vector<clickhouse::Block> &blocks);
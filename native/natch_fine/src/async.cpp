@@ -0,0 +1,326 @@
+// async.cpp - Async query execution
+//
+// Every NIF here queues the query on the client's worker thread (see
+// client_resource.h and async.h) and returns :ok straight away, so they run
+// on normal schedulers. The result arrives later as a message:
+//
+//   {ref, {:ok, result}} | {ref, {:error, message}}
+//
+// Query NIFs take a QueryControl (see query_control.h) through which the
+// query can be cancelled or given a deadline, and reply with the result and
+// the query's QueryStats (see query_stats.h):
+//
+//   {ref, {:ok, {result, stats}}}
+//
+// Jobs on one client run in submission order. Synchronous NIFs on the same
+// client wait for the running job through the client lock.
+
+#include <fine.hpp>
+#include <clickhouse/client.h>
+#include <clickhouse/query.h>
+#include <clickhouse/block.h>
+#include <stdexcept>
+#include <string>
+
+#include "arrow.h"
+#include "async.h"
+#include "client_resource.h"
+#include "columnar.h"
+#include "packed.h"
+#include "query_control.h"
+#include "query_stats.h"
+
+using namespace clickhouse;
+
+FINE_RESOURCE(QueryControl);
+
+// Build a result, adding the time it takes to stats.decode_ns
+template <typename Build>
+ERL_NIF_TERM timed(QueryStats &stats, Build build) {
+  ScopedTimer timer(stats.decode_ns);
+  return build();
+}
+
+/// Create the control of one query; timeout_ms of 0 means no deadline.
+/// `codec` (:none, :lz4 or :zstd) is what the server compresses the result
+/// with, :none leaving it to the server's settings.
+fine::ResourcePtr<QueryControl> query_control_create(
+    ErlNifEnv *env,
+    uint64_t timeout_ms,
+    fine::Atom codec,
+    uint64_t zstd_level) {
+  std::string network_codec;
+  if (codec == fine::Atom("lz4")) {
+    network_codec = "lz4";
+  } else if (codec == fine::Atom("zstd")) {
+    network_codec = "zstd";
+  } else if (!(codec == fine::Atom("none"))) {
+    throw std::invalid_argument("Unknown codec, expected :none, :lz4 or :zstd");
+  }
+  return fine::make_resource<QueryControl>(timeout_ms, network_codec, zstd_level);
+}
+FINE_NIF(query_control_create, 0);
+
+/// Ask the query to stop; it replies {:error, :cancelled} unless it already finished
+fine::Atom query_control_cancel(ErlNifEnv *env, fine::ResourcePtr<QueryControl> control) {
+  control->cancelled.store(true);
+  return fine::Atom("ok");
+}
+FINE_NIF(query_control_cancel, 0);
+
+/// Ping the server; replies {ref, {:ok, "pong"}}
+fine::Atom client_ping_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    c.Ping();
+    return fine::encode(msg_env, std::string("pong"));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_ping_async, 0);
+
+/// Reconnect to the server; replies {ref, {:ok, :ok}}
+fine::Atom client_reset_connection_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    c.ResetConnection();
+    return enif_make_atom(msg_env, "ok");
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_reset_connection_async, 0);
+
+/// Execute DDL/DML; replies {ref, {:ok, :ok}}
+fine::Atom client_execute_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string sql,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [sql, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    QueryStats stats;
+    Query query(sql);
+    execute_controlled(c, query, *control, stats);
+    return stats.with_result(msg_env, enif_make_atom(msg_env, "ok"));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_execute_async, 0);
+
+/// Execute parameterized DDL/DML; replies {ref, {:ok, :ok}}
+fine::Atom client_execute_parameterized_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    QueryStats stats;
+    execute_controlled(c, *query, *control, stats);
+    return stats.with_result(msg_env, enif_make_atom(msg_env, "ok"));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_execute_parameterized_async, 0);
+
+/// SELECT as a list of row maps; replies {ref, {:ok, rows}}
+fine::Atom client_select_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    RowCollector collector(msg_env, opts, &stats);
+    Query select(query);
+    select_controlled(c, select, *control, stats, collector);
+    return stats.with_result(msg_env, timed(stats, [&] { return collector.result(); }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_async, 0);
+
+/// Parameterized SELECT as a list of row maps; replies {ref, {:ok, rows}}
+fine::Atom client_select_parameterized_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    RowCollector collector(msg_env, opts, &stats);
+    select_controlled(c, *query, *control, stats, collector);
+    return stats.with_result(msg_env, timed(stats, [&] { return collector.result(); }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_parameterized_async, 0);
+
+/// SELECT in columnar format; replies {ref, {:ok, %{column => [values]}}}
+fine::Atom client_select_cols_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    ColumnarCollector collector(msg_env, opts, &stats);
+    Query select(query);
+    select_controlled(c, select, *control, stats, collector);
+    return stats.with_result(msg_env, timed(stats, [&] { return collector.result(); }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_cols_async, 0);
+
+/// Parameterized SELECT in columnar format; replies {ref, {:ok, %{column => [values]}}}
+fine::Atom client_select_cols_parameterized_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    ColumnarCollector collector(msg_env, opts, &stats);
+    select_controlled(c, *query, *control, stats, collector);
+    return stats.with_result(msg_env, timed(stats, [&] { return collector.result(); }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_cols_parameterized_async, 0);
+
+/// SELECT as row tuples; replies {ref, {:ok, {[column], [{values}]}}}
+fine::Atom client_select_tuples_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    TupleCollector collector(msg_env, opts, &stats);
+    Query select(query);
+    select_controlled(c, select, *control, stats, collector);
+    return stats.with_result(msg_env, timed(stats, [&] { return collector.result(); }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_tuples_async, 0);
+
+/// Parameterized SELECT as row tuples; replies {ref, {:ok, {[column], [{values}]}}}
+fine::Atom client_select_tuples_parameterized_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    TupleCollector collector(msg_env, opts, &stats);
+    select_controlled(c, *query, *control, stats, collector);
+    return stats.with_result(msg_env, timed(stats, [&] { return collector.result(); }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_tuples_parameterized_async, 0);
+
+/// SELECT as packed column buffers (see packed.h); replies
+/// {ref, {:ok, %{column => %{type: type, data: binary, ...}}}}
+fine::Atom client_select_packed_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    QueryStats stats;
+    PackedCollector collector;
+    Query select(query);
+    select_controlled(c, select, *control, stats, collector);
+    return stats.with_result(msg_env, timed(stats, [&] {
+      auto columns = pack_blocks(collector.blocks);
+      return make_packed_result(msg_env, columns);
+    }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_packed_async, 0);
+
+/// Parameterized SELECT as packed column buffers
+fine::Atom client_select_packed_parameterized_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    QueryStats stats;
+    PackedCollector collector;
+    select_controlled(c, *query, *control, stats, collector);
+    return stats.with_result(msg_env, timed(stats, [&] {
+      auto columns = pack_blocks(collector.blocks);
+      return make_packed_result(msg_env, columns);
+    }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_packed_parameterized_async, 0);
+
+/// SELECT as an Arrow IPC stream (see arrow.h); replies {ref, {:ok, binary}}
+fine::Atom client_select_arrow_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    QueryStats stats;
+    ArrowCollector collector;
+    Query select(query);
+    select_controlled(c, select, *control, stats, collector);
+    return stats.with_result(
+        msg_env, timed(stats, [&] { return make_arrow_stream(msg_env, collector.blocks); }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_arrow_async, 0);
+
+/// Parameterized SELECT as an Arrow IPC stream
+fine::Atom client_select_arrow_parameterized_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    QueryStats stats;
+    ArrowCollector collector;
+    select_controlled(c, *query, *control, stats, collector);
+    return stats.with_result(
+        msg_env, timed(stats, [&] { return make_arrow_stream(msg_env, collector.blocks); }));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_arrow_parameterized_async, 0);
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <fine.hpp>
+#include <clickhouse/client.h>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "client_resource.h"
+#include "error_encoding.h"
+#include "query_control.h"
+
+// Async job plumbing shared by the *_async NIFs
+//
+// A job runs on the client's worker thread with the client locked, builds its
+// result in a process-independent environment and sends
+//
+//   {ref, {:ok, result}} | {ref, {:error, message}}
+//
+// to the caller, where message is the same JSON error payload the synchronous
+// NIFs raise. Jobs stopped by their QueryControl (see query_control.h) throw
+// QueryStopped; a job interrupted mid-receive gets its connection reset here,
+// while the client is still locked, so the next job starts clean.
+
+// Reply target (pid + ref) and the environment the result is built in
+class AsyncReply {
+public:
+  AsyncReply(ErlNifPid pid, ERL_NIF_TERM ref) : pid_(pid), env_(enif_alloc_env()) {
+    ref_ = enif_make_copy(env_, ref);
+  }
+
+  ~AsyncReply() { enif_free_env(env_); }
+
+  AsyncReply(const AsyncReply &) = delete;
+  AsyncReply &operator=(const AsyncReply &) = delete;
+
+  ErlNifEnv *env() { return env_; }
+
+  void ok(ERL_NIF_TERM result) {
+    send(enif_make_tuple2(env_, enif_make_atom(env_, "ok"), result));
+  }
+
+  void error(const std::string &message) {
+    ERL_NIF_TERM reason;
+    unsigned char *data = enif_make_new_binary(env_, message.size(), &reason);
+    std::memcpy(data, message.data(), message.size());
+    send(enif_make_tuple2(env_, enif_make_atom(env_, "error"), reason));
+  }
+
+private:
+  // Called from the worker thread, hence the NULL caller env
+  void send(ERL_NIF_TERM payload) {
+    enif_send(NULL, &pid_, env_, enif_make_tuple2(env_, ref_, payload));
+  }
+
+  ErlNifPid pid_;
+  ErlNifEnv *env_;
+  ERL_NIF_TERM ref_;
+};
+
+// Queue `fn(env, client, decode_options) -> ERL_NIF_TERM` on the client's worker thread and
+// reply to `pid` with its result. Anything `fn` needs must be captured by
+// value (resource pointers keep their resources alive until the job is done).
+template <typename Fn>
+void run_async(
+    fine::ResourcePtr<ClientResource> &client,
+    ErlNifPid pid,
+    ERL_NIF_TERM ref,
+    Fn fn) {
+  auto reply = std::make_shared<AsyncReply>(pid, ref);
+  auto state = client->state;
+
+  client->post([state, reply, fn = std::move(fn)]() {
+    try {
+      LockedClient locked(*state);
+      try {
+        reply->ok(fn(reply->env(), *locked, locked.options()));
+      } catch (const QueryStopped &e) {
+        if (e.interrupted) {
+          try {
+            locked->ResetConnection();
+          } catch (const std::exception &) {
+            // Server unreachable: the next query reports it
+          }
+        }
+        throw;
+      }
+    } catch (const QueryStopped &e) {
+      reply->error(encode_query_stopped(e));
+    } catch (const std::exception &e) {
+      reply->error(encode_clickhouse_error(e));
+    }
+  });
+}
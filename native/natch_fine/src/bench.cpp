@@ -0,0 +1,290 @@
+// bench.cpp - Native micro-benchmarks (built with NATCH_BUILD_BENCH only)
+//
+// Runs the decode kernels on synthetic clickhouse-cpp columns, so they can
+// be measured without a server or network noise (see
+// bench/native_kernels_bench.exs). Builds with this file also count every
+// operator new made in the process, which the bench reports per value for
+// the decoders here and around the column.cpp appenders it calls from
+// Elixir.
+
+#include <fine.hpp>
+#include <clickhouse/columns/factory.h>
+#include <clickhouse/columns/numeric.h>
+#include <clickhouse/columns/string.h>
+#include <clickhouse/columns/date.h>
+#include <clickhouse/columns/uuid.h>
+#include <clickhouse/columns/decimal.h>
+#include <clickhouse/columns/enum.h>
+#include <clickhouse/columns/nullable.h>
+#include <clickhouse/columns/array.h>
+#include <clickhouse/columns/tuple.h>
+#include <clickhouse/columns/map.h>
+#include <clickhouse/columns/lowcardinality.h>
+#include <clickhouse/types/types.h>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "columnar.h"
+#include "decode_options.h"
+#include "packed.h"
+
+using namespace clickhouse;
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_allocated_bytes{0};
+
+void *counted_alloc(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return counted_alloc(size); }
+void *operator new[](std::size_t size) { return counted_alloc(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+// ============================================================================
+// Synthetic columns
+// ============================================================================
+
+namespace {
+
+template <typename ColumnT, typename Value>
+void fill(const ColumnRef &col, size_t rows, Value value) {
+  auto typed = col->As<ColumnT>();
+  for (size_t i = 0; i < rows; i++) {
+    typed->Append(value(i));
+  }
+}
+
+// A column of `type_name` holding `rows` deterministic values. Nullable
+// columns have every fifth row NULL, arrays and maps two elements per row,
+// LowCardinality columns 16 distinct values.
+ColumnRef make_column(const std::string &type_name, size_t rows) {
+  auto col = CreateColumnByType(type_name);
+  if (!col) {
+    throw std::invalid_argument("Unknown column type: " + type_name);
+  }
+
+  auto type = col->Type();
+  switch (type->GetCode()) {
+  case Type::UInt8:
+    fill<ColumnUInt8>(col, rows, [](size_t i) { return uint8_t(i % 251); });
+    break;
+  case Type::UInt16:
+    fill<ColumnUInt16>(col, rows, [](size_t i) { return uint16_t(i); });
+    break;
+  case Type::UInt32:
+    fill<ColumnUInt32>(col, rows, [](size_t i) { return uint32_t(i); });
+    break;
+  case Type::UInt64:
+    fill<ColumnUInt64>(col, rows, [](size_t i) { return uint64_t(i) * 1000003; });
+    break;
+  case Type::Int8:
+    fill<ColumnInt8>(col, rows, [](size_t i) { return int8_t(i % 256 - 128); });
+    break;
+  case Type::Int16:
+    fill<ColumnInt16>(col, rows, [](size_t i) { return int16_t(i - 1000); });
+    break;
+  case Type::Int32:
+    fill<ColumnInt32>(col, rows, [](size_t i) { return int32_t(i) - 1000; });
+    break;
+  case Type::Int64:
+    fill<ColumnInt64>(col, rows, [](size_t i) { return int64_t(i) * -7919; });
+    break;
+  case Type::Float32:
+    fill<ColumnFloat32>(col, rows, [](size_t i) { return float(i) * 0.5f; });
+    break;
+  case Type::Float64:
+    fill<ColumnFloat64>(col, rows, [](size_t i) { return double(i) * 0.25; });
+    break;
+  case Type::Date: {
+    auto dates = col->As<ColumnDate>();
+    for (size_t i = 0; i < rows; i++) {
+      dates->AppendRaw(uint16_t(19000 + i % 1000));
+    }
+    break;
+  }
+  case Type::DateTime:
+    fill<ColumnDateTime>(col, rows, [](size_t i) { return std::time_t(1700000000 + i); });
+    break;
+  case Type::DateTime64:
+    fill<ColumnDateTime64>(col, rows, [](size_t i) { return int64_t(1700000000000 + i); });
+    break;
+  case Type::UUID:
+    fill<ColumnUUID>(col, rows, [](size_t i) { return UUID{i * 0x9E3779B97F4A7C15ull, ~i}; });
+    break;
+  case Type::Decimal:
+  case Type::Decimal32:
+  case Type::Decimal64:
+  case Type::Decimal128:
+    fill<ColumnDecimal>(col, rows, [](size_t i) { return Int128(i * 12345); });
+    break;
+  case Type::String:
+    fill<ColumnString>(col, rows, [](size_t i) { return "value_" + std::to_string(i % 4096); });
+    break;
+  case Type::Enum8:
+  case Type::Enum16: {
+    std::vector<int16_t> values;
+    EnumType enum_type(type);
+    for (auto it = enum_type.BeginValueToName(); it != enum_type.EndValueToName(); ++it) {
+      values.push_back(it->first);
+    }
+    for (size_t i = 0; i < rows; i++) {
+      int16_t value = values[i % values.size()];
+      if (type->GetCode() == Type::Enum8) {
+        col->As<ColumnEnum8>()->Append(static_cast<int8_t>(value));
+      } else {
+        col->As<ColumnEnum16>()->Append(value);
+      }
+    }
+    break;
+  }
+  case Type::Nullable: {
+    auto nested = make_column(type->As<NullableType>()->GetNestedType()->GetName(), rows);
+    auto nulls = std::make_shared<ColumnUInt8>();
+    fill<ColumnUInt8>(nulls, rows, [](size_t i) { return uint8_t(i % 5 == 0); });
+    return std::make_shared<ColumnNullable>(nested, nulls);
+  }
+  case Type::Array: {
+    auto items = make_column(type->As<ArrayType>()->GetItemType()->GetName(), rows * 2);
+    auto arrays = col->As<ColumnArray>();
+    for (size_t i = 0; i < rows; i++) {
+      arrays->AppendAsColumn(items->Slice(i * 2, 2));
+    }
+    break;
+  }
+  case Type::Tuple: {
+    std::vector<ColumnRef> elements;
+    for (const auto &element : type->As<TupleType>()->GetTupleType()) {
+      elements.push_back(make_column(element->GetName(), rows));
+    }
+    return std::make_shared<ColumnTuple>(elements);
+  }
+  case Type::Map: {
+    auto map_type = type->As<MapType>();
+    auto pairs = "Array(Tuple(" + map_type->GetKeyType()->GetName() + ", " +
+                 map_type->GetValueType()->GetName() + "))";
+    return std::make_shared<ColumnMap>(make_column(pairs, rows));
+  }
+  case Type::LowCardinality: {
+    auto nested_type = type->As<LowCardinalityType>()->GetNestedType()->GetName();
+    auto distinct = make_column(nested_type, 16);
+    for (size_t i = 0; i < rows; i++) {
+      col->Append(distinct->Slice(i % 16, 1));
+    }
+    break;
+  }
+  default:
+    throw std::invalid_argument("No synthetic values for column type: " + type_name);
+  }
+
+  return col;
+}
+
+struct KernelRun {
+  uint64_t ns = 0;
+  uint64_t allocations = 0;
+  uint64_t allocated_bytes = 0;
+};
+
+template <typename Fn>
+KernelRun measure(uint64_t iterations, Fn fn) {
+  KernelRun run;
+  for (uint64_t i = 0; i < iterations; i++) {
+    uint64_t allocations = g_allocations.load();
+    uint64_t bytes = g_allocated_bytes.load();
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    run.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+    run.allocations += g_allocations.load() - allocations;
+    run.allocated_bytes += g_allocated_bytes.load() - bytes;
+  }
+  return run;
+}
+
+} // namespace
+
+// ============================================================================
+// NIFs
+// ============================================================================
+
+/// Decode a synthetic column of `type_name` with `rows` values `iterations`
+/// times. `kernel` is "terms" (append_column_terms, the kernel of every term
+/// SELECT path, with the given string/enum options) or "packed"
+/// (pack_parts). Returns %{"ns" => total, "allocations" => count,
+/// "allocated_bytes" => bytes, "values" => rows * iterations}.
+std::map<std::string, uint64_t> bench_decode(
+    ErlNifEnv *env,
+    std::string type_name,
+    uint64_t rows,
+    uint64_t iterations,
+    fine::Atom kernel,
+    bool sub_binary_strings,
+    bool enum_atoms) {
+  auto col = make_column(type_name, rows);
+
+  DecodeOptions opts;
+  opts.sub_binary_strings = sub_binary_strings;
+  opts.enum_atoms = enum_atoms;
+
+  KernelRun run;
+  if (kernel == fine::Atom("terms")) {
+    run = measure(iterations, [&] {
+      // A fresh env per run, so terms don't pile up across iterations
+      ErlNifEnv *term_env = enif_alloc_env();
+      std::vector<ERL_NIF_TERM> terms;
+      terms.reserve(rows);
+      try {
+        append_column_terms(term_env, col, nullptr, opts, terms);
+      } catch (...) {
+        enif_free_env(term_env);
+        throw;
+      }
+      enif_free_env(term_env);
+    });
+  } else if (kernel == fine::Atom("packed")) {
+    run = measure(iterations, [&] { pack_parts("bench", {col}, rows); });
+  } else {
+    throw std::invalid_argument("Unknown kernel, expected :terms or :packed");
+  }
+
+  return {
+      {"ns", run.ns},
+      {"allocations", run.allocations},
+      {"allocated_bytes", run.allocated_bytes},
+      {"values", rows * iterations},
+  };
+}
+FINE_NIF(bench_decode, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+/// {allocations, bytes} made through operator new since the library loaded
+std::tuple<uint64_t, uint64_t> bench_allocations(ErlNifEnv *env) {
+  return {g_allocations.load(), g_allocated_bytes.load()};
+}
+FINE_NIF(bench_allocations, 0);
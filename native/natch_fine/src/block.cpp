@@ -1,10 +1,20 @@
 #include <fine.hpp>
 #include <clickhouse/client.h>
 #include <clickhouse/block.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <string>
+#include <utility>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
+#include "async.h"
+#include "block_resource.h"
+#include "client_resource.h"
 #include "error_encoding.h"
+#include "query_control.h"
 
 using namespace clickhouse;
 
@@ -14,14 +24,6 @@ struct ColumnResource {
   ColumnResource(std::shared_ptr<Column> p) : ptr(p) {}
 };
 
-// Wrapper for Block
-struct BlockResource {
-  std::shared_ptr<Block> ptr;
-
-  BlockResource() : ptr(std::make_shared<Block>()) {}
-  BlockResource(std::shared_ptr<Block> p) : ptr(p) {}
-};
-
 // Declare BlockResource as a FINE resource
 FINE_RESOURCE(BlockResource);
 
@@ -71,24 +73,260 @@ uint64_t block_column_count(
 }
 FINE_NIF(block_column_count, 0);
 
-// Forward declare Client (from minimal.cpp)
-// We need this to avoid duplicate FINE_RESOURCE declarations
-namespace clickhouse {
-  class Client;
-}
-
 // Insert a block into a table
 fine::Atom client_insert(
     ErlNifEnv *env,
-    fine::ResourcePtr<Client> client,
+    fine::ResourcePtr<ClientResource> client,
     std::string table_name,
     fine::ResourcePtr<BlockResource> block_res) {
   try {
-    // Block is copied by Insert
-    client->Insert(table_name, *block_res->ptr);
+    // Insert serializes the block in place, it is not copied
+    client->locked()->Insert(table_name, *block_res->ptr);
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(client_insert, 0);
+FINE_NIF(client_insert, ERL_NIF_DIRTY_JOB_IO_BOUND);
+
+// Insert a block on the client's worker thread; replies {ref, {:ok, :ok}}
+fine::Atom client_insert_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string table_name,
+    fine::ResourcePtr<BlockResource> block_res,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [table_name, block_res](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    c.Insert(table_name, *block_res->ptr);
+    return enif_make_atom(msg_env, "ok");
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_insert_async, 0);
+
+// ============================================================================
+// Pipelined INSERT
+// ============================================================================
+
+// Blocks queued for a pipelined INSERT (client_insert_stream_async)
+//
+// The producer pushes blocks as it builds them and the client's worker
+// thread sends each one as it arrives, so building block N+1 overlaps
+// serializing, compressing and sending block N. At most `window` blocks wait
+// to be sent. Push never blocks: on a full queue it returns :full, and the
+// worker sends the producer {tag, :credit} once a block has left the queue
+// (or the INSERT has ended), so the producer waits in `receive` rather than
+// on a scheduler. Queued blocks are shared with their BlockResource, never
+// copied.
+struct InsertStreamResource {
+  enum class Push { ok, full, closed };
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::shared_ptr<Block>> blocks;
+  uint64_t window;
+  ErlNifPid producer;
+  bool closed = false;     // No more blocks, end the INSERT once drained
+  bool cancelled = false;  // Abort the INSERT
+  bool finished = false;   // The INSERT has ended (committed or failed)
+  bool full = false;       // The producer was turned away and waits for a credit
+
+  InsertStreamResource(uint64_t window, ErlNifPid producer, ERL_NIF_TERM tag)
+      : window(window), producer(producer), tag_env_(enif_alloc_env()) {
+    tag_ = enif_make_copy(tag_env_, tag);
+  }
+
+  ~InsertStreamResource() { enif_free_env(tag_env_); }
+
+  // Queue a block if there is room
+  Push push(std::shared_ptr<Block> block) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (closed || cancelled || finished) {
+      return Push::closed;
+    }
+    if (blocks.size() >= window) {
+      full = true;
+      return Push::full;
+    }
+
+    blocks.push_back(std::move(block));
+    cv.notify_all();
+    return Push::ok;
+  }
+
+  // Next block to send, or nullptr once the stream is closed and drained.
+  // Throws if the stream was cancelled, the producer exited without closing
+  // it, or `control` says stop. `env` must be process independent
+  // (enif_is_process_alive).
+  std::shared_ptr<Block> pop(ErlNifEnv *env, const QueryControl &control) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (blocks.empty() && !closed && !cancelled) {
+      if (cv.wait_for(lock, std::chrono::milliseconds(100)) == std::cv_status::timeout) {
+        if (!enif_is_process_alive(env, &producer)) {
+          cancelled = true;
+        } else if (control.should_stop()) {
+          throw QueryStopped(!control.cancelled.load(), false);
+        }
+      }
+    }
+
+    if (cancelled) {
+      throw std::runtime_error("Insert stream cancelled");
+    }
+    if (blocks.empty()) {
+      return nullptr;
+    }
+
+    auto block = std::move(blocks.front());
+    blocks.pop_front();
+    bool credit = std::exchange(full, false);
+    lock.unlock();
+
+    if (credit) {
+      send_credit();
+    }
+    return block;
+  }
+
+  void close() { set_flag(closed); }
+  void cancel() { set_flag(cancelled); }
+
+  // Drop the blocks the INSERT will never send once it has ended, and let
+  // a producer waiting for a credit find out
+  void finish() {
+    bool credit;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished = true;
+      blocks.clear();
+      credit = std::exchange(full, false);
+    }
+    if (credit) {
+      send_credit();
+    }
+  }
+
+private:
+  void set_flag(bool &flag) {
+    std::lock_guard<std::mutex> lock(mutex);
+    flag = true;
+    cv.notify_all();
+  }
+
+  // Called from the worker thread, hence the NULL caller env
+  void send_credit() {
+    ErlNifEnv *msg_env = enif_alloc_env();
+    ERL_NIF_TERM msg = enif_make_tuple2(
+        msg_env, enif_make_copy(msg_env, tag_), enif_make_atom(msg_env, "credit"));
+    enif_send(NULL, &producer, msg_env, msg);
+    enif_free_env(msg_env);
+  }
+
+  ErlNifEnv *tag_env_;
+  ERL_NIF_TERM tag_;
+};
+
+FINE_RESOURCE(InsertStreamResource);
+
+/// Creates an insert stream fed by the calling process, with up to `window`
+/// built blocks waiting to be sent. Credits arrive as {tag, :credit}.
+fine::ResourcePtr<InsertStreamResource> insert_stream_create(
+    ErlNifEnv *env,
+    uint64_t window,
+    fine::Term tag) {
+  if (window == 0) {
+    throw std::invalid_argument("Insert stream window must be at least 1");
+  }
+
+  ErlNifPid producer;
+  enif_self(env, &producer);
+  return fine::make_resource<InsertStreamResource>(window, producer, tag);
+}
+FINE_NIF(insert_stream_create, 0);
+
+/// Queues a block for sending. Returns :full if the window is full (push it
+/// again after the next {tag, :credit}), or :closed if the INSERT has
+/// already ended (e.g. failed on the server).
+fine::Atom insert_stream_push(
+    ErlNifEnv *env,
+    fine::ResourcePtr<InsertStreamResource> stream,
+    fine::ResourcePtr<BlockResource> block_res) {
+  switch (stream->push(block_res->ptr)) {
+  case InsertStreamResource::Push::ok:
+    return fine::Atom("ok");
+  case InsertStreamResource::Push::full:
+    return fine::Atom("full");
+  default:
+    return fine::Atom("closed");
+  }
+}
+FINE_NIF(insert_stream_push, 0);
+
+/// Ends the stream; the INSERT finishes after the queued blocks are sent
+fine::Atom insert_stream_close(
+    ErlNifEnv *env,
+    fine::ResourcePtr<InsertStreamResource> stream) {
+  stream->close();
+  return fine::Atom("ok");
+}
+FINE_NIF(insert_stream_close, 0);
+
+/// Aborts the INSERT without sending the queued blocks
+fine::Atom insert_stream_cancel(
+    ErlNifEnv *env,
+    fine::ResourcePtr<InsertStreamResource> stream) {
+  stream->cancel();
+  return fine::Atom("ok");
+}
+FINE_NIF(insert_stream_cancel, 0);
+
+/// Runs an INSERT of every block pushed to `stream` on the client's worker
+/// thread, keeping one INSERT query open for all of them, until `control`
+/// stops it. Replies {ref, {:ok, :ok}} after the stream was closed and its
+/// blocks sent.
+fine::Atom client_insert_stream_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string table_name,
+    std::vector<std::string> column_names,
+    fine::ResourcePtr<InsertStreamResource> stream,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  std::string query = "INSERT INTO " + table_name + " ( ";
+  for (size_t i = 0; i < column_names.size(); i++) {
+    query += (i == 0 ? "" : ",") + column_names[i];
+  }
+  query += " ) VALUES";
+
+  run_async(client, pid, ref, [query, stream, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &) {
+    try {
+      c.BeginInsert(query);
+      while (auto block = stream->pop(msg_env, *control)) {
+        if (control->should_stop()) {
+          throw QueryStopped(!control->cancelled.load(), false);
+        }
+        c.SendInsertBlock(*block);
+      }
+      c.EndInsert();
+    } catch (...) {
+      stream->finish();
+
+      // The connection is left in the middle of the INSERT; reconnecting
+      // drops the unfinished query on the server
+      try {
+        c.ResetConnection();
+      } catch (...) {
+      }
+      throw;
+    }
+
+    stream->finish();
+    return enif_make_atom(msg_env, "ok");
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_insert_stream_async, 0);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <fine.hpp>
+#include <clickhouse/block.h>
+#include <memory>
+#include <utility>
+
+#include "decode_options.h"
+
+// Wrapper for Block
+//
+// Built column by column for INSERTs (block.cpp), or holding a result block
+// of select_lazy (lazy.cpp), whose columns are only turned into terms when
+// asked for, with the decode options of the client that ran the query.
+// Registered as a FINE resource in block.cpp.
+struct BlockResource {
+  std::shared_ptr<clickhouse::Block> ptr;
+  DecodeOptions decode_options;
+
+  BlockResource() : ptr(std::make_shared<clickhouse::Block>()) {}
+  BlockResource(std::shared_ptr<clickhouse::Block> p) : ptr(p) {}
+  BlockResource(clickhouse::Block &&block, const DecodeOptions &opts)
+      : ptr(std::make_shared<clickhouse::Block>(std::move(block))), decode_options(opts) {}
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <fine.hpp>
+#include <clickhouse/client.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "decode_options.h"
+#include "job_queue.h"
+
+// ClientResource - the FINE resource behind every client reference
+//
+// Wraps a clickhouse::Client together with the mutex that serializes access
+// to it (clickhouse-cpp clients are not thread-safe) and a worker thread that
+// runs async jobs (async.cpp). Synchronous NIFs use the client through
+// locked(), which holds the mutex for the full expression:
+//
+//   client->locked()->Select(query, callback);
+//
+// The worker thread is only started by the first async job. It shares the
+// client state and job queue through shared_ptrs, so the resource destructor
+// (which runs wherever the BEAM garbage collects the reference) never has to
+// join: it asks the worker to stop and the worker exits after draining the
+// queued jobs.
+
+// Client plus the mutex guarding it (and its decode options), shared with
+// the worker thread
+struct ClientState {
+  clickhouse::Client client;
+  std::mutex mutex;
+  DecodeOptions decode_options;
+
+  explicit ClientState(const clickhouse::ClientOptions &opts) : client(opts) {}
+};
+
+// Temporary that keeps the client locked while it is being used
+class LockedClient {
+public:
+  explicit LockedClient(ClientState &state) : lock_(state.mutex), state_(&state) {}
+
+  clickhouse::Client *operator->() { return &state_->client; }
+  clickhouse::Client &operator*() { return state_->client; }
+
+  DecodeOptions &options() { return state_->decode_options; }
+
+private:
+  std::unique_lock<std::mutex> lock_;
+  ClientState *state_;
+};
+
+struct ClientResource {
+  std::shared_ptr<ClientState> state;
+
+  explicit ClientResource(const clickhouse::ClientOptions &opts)
+      : state(std::make_shared<ClientState>(opts)) {}
+
+  ~ClientResource() {
+    if (queue_) {
+      std::lock_guard<std::mutex> lock(queue_->mutex);
+      queue_->stopping = true;
+      queue_->cv.notify_one();
+    }
+  }
+
+  LockedClient locked() { return LockedClient(*state); }
+
+  // Queue a job on the worker thread, starting the worker on first use.
+  // Jobs run one at a time in submission order and must not throw.
+  void post(std::function<void()> job) {
+    std::lock_guard<std::mutex> lock(post_mutex_);
+
+    if (!queue_) {
+      queue_ = std::make_shared<JobQueue>();
+      std::thread(JobQueue::run, queue_).detach();
+    }
+
+    queue_->push(std::move(job));
+  }
+
+private:
+  std::mutex post_mutex_;
+  std::shared_ptr<JobQueue> queue_;
+};
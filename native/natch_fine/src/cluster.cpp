@@ -0,0 +1,322 @@
+// cluster.cpp - Scatter-gather SELECT over several clients (Natch.Cluster)
+//
+// cluster_select_cols_async runs one query on every client at once: each
+// shard's part runs on that client's worker thread, like any async job (see
+// async.h), so the shards' latencies overlap and the query takes as long as
+// the slowest shard. The last shard to finish merges every shard's blocks
+// into one %{column => [values]} result and replies
+//
+//   {ref, {:ok, {columns, stats}}} | {ref, {:error, message}}
+//
+// Without a sort key the shards' rows are concatenated in client order,
+// through the same back-to-front ResultBuffer as a single SELECT. With one,
+// each shard's result must already be sorted by that column (ORDER BY in
+// the query) and the rows are k-way merged by it, comparing the decoded key
+// terms in Erlang term order.
+//
+// One QueryControl covers every shard: cancelling it, or its deadline,
+// stops them all, and so does the first shard to fail.
+
+#include <fine.hpp>
+#include <clickhouse/client.h>
+#include <clickhouse/query.h>
+#include <clickhouse/block.h>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "async.h"
+#include "client_resource.h"
+#include "columnar.h"
+#include "error_encoding.h"
+#include "query_control.h"
+#include "query_stats.h"
+
+using namespace clickhouse;
+
+namespace {
+
+// Blocks of a shard's result
+struct ShardCollector {
+  std::vector<Block> *blocks;
+
+  void operator()(const Block &block) {
+    if (block.GetRowCount() > 0) {
+      blocks->push_back(block);
+    }
+  }
+};
+
+// State shared by the shard jobs of one query
+struct Gather {
+  std::mutex mutex;
+  size_t remaining;
+  std::shared_ptr<AsyncReply> reply;
+  fine::ResourcePtr<QueryControl> control;
+  std::string order_by;
+  bool descending;
+
+  // Written by shard i's job only, read by the last one
+  std::vector<std::vector<Block>> shards;
+  std::vector<QueryStats> stats;
+
+  DecodeOptions opts;
+  std::string error;
+
+  Gather(size_t shard_count, std::shared_ptr<AsyncReply> reply,
+         fine::ResourcePtr<QueryControl> control, std::string order_by, bool descending)
+      : remaining(shard_count), reply(std::move(reply)), control(control),
+        order_by(std::move(order_by)), descending(descending), shards(shard_count),
+        stats(shard_count) {}
+
+  // Remember the first failure and stop the other shards
+  void fail(const std::string &message) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (error.empty()) {
+        error = message;
+      }
+    }
+    control->cancelled.store(true);
+  }
+
+  // Called by every shard job when it is done; true for the last one
+  bool finish_one() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return --remaining == 0;
+  }
+};
+
+std::vector<std::string> column_names(const Block &block) {
+  std::vector<std::string> names;
+  for (size_t c = 0; c < block.GetColumnCount(); c++) {
+    names.push_back(block.GetColumnName(c));
+  }
+  return names;
+}
+
+// The column names every non-empty shard returned; shards must agree
+std::vector<std::string> common_columns(const Gather &gather) {
+  std::vector<std::string> names;
+  for (const auto &blocks : gather.shards) {
+    if (blocks.empty()) {
+      continue;
+    }
+    auto shard_names = column_names(blocks.front());
+    if (names.empty()) {
+      names = std::move(shard_names);
+    } else if (shard_names != names) {
+      throw std::runtime_error("Shards returned different columns");
+    }
+  }
+  return names;
+}
+
+ERL_NIF_TERM concat_shards(ErlNifEnv *env, Gather &gather, QueryStats &stats) {
+  common_columns(gather);
+  ResultBuffer buffer(ResultShape::Columns, gather.opts, &stats);
+  for (auto &blocks : gather.shards) {
+    for (auto &block : blocks) {
+      buffer(block);
+    }
+    blocks.clear();
+  }
+  return buffer.build(env);
+}
+
+ERL_NIF_TERM merge_shards(ErlNifEnv *env, Gather &gather) {
+  auto names = common_columns(gather);
+  size_t key = names.size();
+  for (size_t c = 0; c < names.size(); c++) {
+    if (names[c] == gather.order_by) {
+      key = c;
+    }
+  }
+  if (!names.empty() && key == names.size()) {
+    throw std::invalid_argument("Sort key is not a result column: " + gather.order_by);
+  }
+
+  // values[s][c]: every value of column c from shard s, in shard order
+  size_t shard_count = gather.shards.size();
+  std::vector<std::vector<std::vector<ERL_NIF_TERM>>> values(shard_count);
+  size_t total = 0;
+  for (size_t s = 0; s < shard_count; s++) {
+    values[s].resize(names.size());
+    for (const auto &block : gather.shards[s]) {
+      for (size_t c = 0; c < names.size(); c++) {
+        append_column_terms(env, block[c], nullptr, gather.opts, values[s][c]);
+      }
+      total += block.GetRowCount();
+    }
+    gather.shards[s].clear();
+  }
+
+  // Heap of each shard's next row, ordered by its key
+  using Cursor = std::pair<size_t, size_t>;  // {shard, row}
+  bool descending = gather.descending;
+  auto after = [&values, key, descending](const Cursor &a, const Cursor &b) {
+    int order = enif_compare(values[a.first][key][a.second], values[b.first][key][b.second]);
+    // Ties keep client order
+    if (order == 0) {
+      return a.first > b.first;
+    }
+    return descending ? order < 0 : order > 0;
+  };
+  std::priority_queue<Cursor, std::vector<Cursor>, decltype(after)> heap(after);
+  for (size_t s = 0; s < shard_count; s++) {
+    if (!names.empty() && !values[s][key].empty()) {
+      heap.push({s, 0});
+    }
+  }
+
+  std::vector<Cursor> order;
+  order.reserve(total);
+  while (!heap.empty()) {
+    Cursor next = heap.top();
+    heap.pop();
+    order.push_back(next);
+    if (next.second + 1 < values[next.first][key].size()) {
+      heap.push({next.first, next.second + 1});
+    }
+  }
+
+  // Build each list back to front, so no merged copy of the values is needed
+  std::vector<ERL_NIF_TERM> keys;
+  std::vector<ERL_NIF_TERM> lists;
+  for (size_t c = 0; c < names.size(); c++) {
+    ERL_NIF_TERM list = enif_make_list(env, 0);
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      list = enif_make_list_cell(env, values[it->first][c][it->second], list);
+    }
+    keys.push_back(enif_make_atom(env, names[c].c_str()));
+    lists.push_back(list);
+  }
+
+  ERL_NIF_TERM columns;
+  enif_make_map_from_arrays(env, keys.data(), lists.data(), keys.size(), &columns);
+  return columns;
+}
+
+// Merge the shards and reply; runs on the worker of the last shard to finish
+void reply_merged(Gather &gather) {
+  if (!gather.error.empty()) {
+    gather.reply->error(gather.error);
+    return;
+  }
+
+  try {
+    QueryStats stats;
+    for (const auto &shard : gather.stats) {
+      stats.merge(shard);
+    }
+
+    ErlNifEnv *env = gather.reply->env();
+    ERL_NIF_TERM result;
+    {
+      ScopedTimer timer(stats.decode_ns);
+      result = gather.order_by.empty() ? concat_shards(env, gather, stats)
+                                       : merge_shards(env, gather);
+    }
+    gather.reply->ok(stats.with_result(env, result));
+  } catch (const std::exception &e) {
+    gather.reply->error(encode_clickhouse_error(e));
+  }
+}
+
+// Queue shard `index` of the query on its client's worker thread.
+// `make_query` builds the Query for the shard to run.
+template <typename MakeQuery>
+void post_shard(
+    fine::ResourcePtr<ClientResource> &client,
+    const std::shared_ptr<Gather> &gather,
+    size_t index,
+    MakeQuery make_query) {
+  auto state = client->state;
+
+  client->post([state, gather, index, make_query]() {
+    try {
+      LockedClient locked(*state);
+      if (index == 0) {
+        gather->opts = locked.options();
+      }
+      try {
+        ShardCollector collector{&gather->shards[index]};
+        select_controlled(*locked, make_query(), *gather->control, gather->stats[index], collector);
+      } catch (const QueryStopped &e) {
+        if (e.interrupted) {
+          try {
+            locked->ResetConnection();
+          } catch (const std::exception &) {
+            // Server unreachable: the next query reports it
+          }
+        }
+        throw;
+      }
+    } catch (const QueryStopped &e) {
+      gather->fail(encode_query_stopped(e));
+    } catch (const std::exception &e) {
+      gather->fail(encode_clickhouse_error(e));
+    }
+
+    if (gather->finish_one()) {
+      reply_merged(*gather);
+    }
+  });
+}
+
+std::shared_ptr<Gather> make_gather(
+    std::vector<fine::ResourcePtr<ClientResource>> &clients,
+    fine::ResourcePtr<QueryControl> control,
+    std::string order_by,
+    bool descending,
+    ErlNifPid pid,
+    ERL_NIF_TERM ref) {
+  if (clients.empty()) {
+    throw std::invalid_argument("A cluster query needs at least one client");
+  }
+  auto reply = std::make_shared<AsyncReply>(pid, ref);
+  return std::make_shared<Gather>(clients.size(), reply, control, std::move(order_by), descending);
+}
+
+} // namespace
+
+/// SELECT on every client, merged into one column map; `order_by` is the
+/// sort key column to merge by, or "" to concatenate in client order
+fine::Atom cluster_select_cols_async(
+    ErlNifEnv *env,
+    std::vector<fine::ResourcePtr<ClientResource>> clients,
+    std::string sql,
+    fine::ResourcePtr<QueryControl> control,
+    std::string order_by,
+    bool descending,
+    ErlNifPid pid,
+    fine::Term ref) {
+  auto gather = make_gather(clients, control, order_by, descending, pid, ref);
+  for (size_t i = 0; i < clients.size(); i++) {
+    post_shard(clients[i], gather, i, [sql] { return Query(sql); });
+  }
+  return fine::Atom("ok");
+}
+FINE_NIF(cluster_select_cols_async, 0);
+
+/// Parameterized cluster SELECT; each shard runs its own copy of `query`
+fine::Atom cluster_select_cols_parameterized_async(
+    ErlNifEnv *env,
+    std::vector<fine::ResourcePtr<ClientResource>> clients,
+    fine::ResourcePtr<Query> query,
+    fine::ResourcePtr<QueryControl> control,
+    std::string order_by,
+    bool descending,
+    ErlNifPid pid,
+    fine::Term ref) {
+  auto gather = make_gather(clients, control, order_by, descending, pid, ref);
+  for (size_t i = 0; i < clients.size(); i++) {
+    post_shard(clients[i], gather, i, [query] { return Query(*query); });
+  }
+  return fine::Atom("ok");
+}
+FINE_NIF(cluster_select_cols_parameterized_async, 0);
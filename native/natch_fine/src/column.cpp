@@ -14,6 +14,12 @@
 #include <string>
 #include <memory>
 #include <stdexcept>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "array_access.h"
 #include "error_encoding.h"
 
 using namespace clickhouse;
@@ -30,14 +36,20 @@ FINE_RESOURCE(ColumnResource);
 
 // Create a column by type name
 // Uses clickhouse-cpp's CreateColumnByType for dynamic type creation
+// expected_rows (0 for unknown) reserves storage up front, so bulk appends
+// into the column don't reallocate and copy as it grows
 fine::ResourcePtr<ColumnResource> column_create(
     ErlNifEnv *env,
-    std::string type_name) {
+    std::string type_name,
+    uint64_t expected_rows) {
   try {
     auto col = CreateColumnByType(type_name);
     if (!col) {
       throw std::runtime_error("Failed to create column of type: " + type_name);
     }
+    if (expected_rows > 0) {
+      col->Reserve(expected_rows);
+    }
     return fine::make_resource<ColumnResource>(col);
   } catch (const std::exception& e) {
     throw std::runtime_error(encode_clickhouse_error(e));
@@ -138,6 +150,9 @@ FINE_NIF(column_size, 0);
 // These functions accept vectors of values for efficient bulk insertion
 // Reduces NIF boundary crossings from N (one per value) to 1 (one per column)
 //
+// Decoding an arbitrarily long Erlang list is unbounded CPU work, so all bulk
+// appenders run on dirty CPU schedulers instead of blocking a normal one.
+//
 
 // Bulk append UInt64 values
 fine::Atom column_uint64_append_bulk(
@@ -154,7 +169,7 @@ fine::Atom column_uint64_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_uint64_append_bulk, 0);
+FINE_NIF(column_uint64_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Int64 values
 fine::Atom column_int64_append_bulk(
@@ -171,7 +186,7 @@ fine::Atom column_int64_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_int64_append_bulk, 0);
+FINE_NIF(column_int64_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append String values
 fine::Atom column_string_append_bulk(
@@ -188,7 +203,7 @@ fine::Atom column_string_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_string_append_bulk, 0);
+FINE_NIF(column_string_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Float64 values
 fine::Atom column_float64_append_bulk(
@@ -205,7 +220,7 @@ fine::Atom column_float64_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_float64_append_bulk, 0);
+FINE_NIF(column_float64_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append DateTime values (Unix timestamps as uint64)
 fine::Atom column_datetime_append_bulk(
@@ -222,7 +237,7 @@ fine::Atom column_datetime_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_datetime_append_bulk, 0);
+FINE_NIF(column_datetime_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append DateTime64 values (microsecond timestamps as int64)
 fine::Atom column_datetime64_append_bulk(
@@ -239,7 +254,7 @@ fine::Atom column_datetime64_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_datetime64_append_bulk, 0);
+FINE_NIF(column_datetime64_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Decimal64 values (scaled int64 values)
 fine::Atom column_decimal_append_bulk(
@@ -257,7 +272,7 @@ fine::Atom column_decimal_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_decimal_append_bulk, 0);
+FINE_NIF(column_decimal_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Nullable(UInt64) values
 fine::Atom column_nullable_uint64_append_bulk(
@@ -279,7 +294,7 @@ fine::Atom column_nullable_uint64_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_nullable_uint64_append_bulk, 0);
+FINE_NIF(column_nullable_uint64_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Nullable(Int64) values
 fine::Atom column_nullable_int64_append_bulk(
@@ -301,7 +316,7 @@ fine::Atom column_nullable_int64_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_nullable_int64_append_bulk, 0);
+FINE_NIF(column_nullable_int64_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Nullable(String) values
 fine::Atom column_nullable_string_append_bulk(
@@ -323,7 +338,7 @@ fine::Atom column_nullable_string_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_nullable_string_append_bulk, 0);
+FINE_NIF(column_nullable_string_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Nullable(Float64) values
 fine::Atom column_nullable_float64_append_bulk(
@@ -345,7 +360,7 @@ fine::Atom column_nullable_float64_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_nullable_float64_append_bulk, 0);
+FINE_NIF(column_nullable_float64_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 //
 // PHASE 5C - ADDITIONAL TYPE SUPPORT
@@ -367,7 +382,7 @@ fine::Atom column_date_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_date_append_bulk, 0);
+FINE_NIF(column_date_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append UInt8 values (used for Bool)
 fine::Atom column_uint8_append_bulk(
@@ -384,7 +399,7 @@ fine::Atom column_uint8_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_uint8_append_bulk, 0);
+FINE_NIF(column_uint8_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append UInt32 values
 fine::Atom column_uint32_append_bulk(
@@ -401,7 +416,7 @@ fine::Atom column_uint32_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_uint32_append_bulk, 0);
+FINE_NIF(column_uint32_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append UInt16 values
 fine::Atom column_uint16_append_bulk(
@@ -418,7 +433,7 @@ fine::Atom column_uint16_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_uint16_append_bulk, 0);
+FINE_NIF(column_uint16_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Int32 values
 fine::Atom column_int32_append_bulk(
@@ -435,7 +450,7 @@ fine::Atom column_int32_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_int32_append_bulk, 0);
+FINE_NIF(column_int32_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Int16 values
 fine::Atom column_int16_append_bulk(
@@ -452,7 +467,7 @@ fine::Atom column_int16_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_int16_append_bulk, 0);
+FINE_NIF(column_int16_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Int8 values
 fine::Atom column_int8_append_bulk(
@@ -469,7 +484,7 @@ fine::Atom column_int8_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_int8_append_bulk, 0);
+FINE_NIF(column_int8_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append Float32 values
 fine::Atom column_float32_append_bulk(
@@ -486,7 +501,7 @@ fine::Atom column_float32_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_float32_append_bulk, 0);
+FINE_NIF(column_float32_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // Bulk append UUID values (separate lists of high and low 64-bit values)
 fine::Atom column_uuid_append_bulk(
@@ -509,7 +524,142 @@ fine::Atom column_uuid_append_bulk(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_uuid_append_bulk, 0);
+FINE_NIF(column_uuid_append_bulk, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ============================================================================
+// Packed Binary Append
+// ============================================================================
+//
+// Append values given as one packed little-endian binary (the layout of
+// ClickHouse's native format) instead of a list. The binary is copied
+// straight into the column's storage with a single memcpy, so there's no
+// per-element list decoding and no per-value Append. This assumes a
+// little-endian host, like clickhouse-cpp's own wire encoding does.
+
+template <typename ColumnT>
+fine::Atom append_packed_binary(
+    ErlNifEnv *env,
+    const fine::ResourcePtr<ColumnResource> &col_res,
+    fine::Term packed) {
+  using T = typename ColumnT::ValueType;
+
+  try {
+    ErlNifBinary bin;
+    if (!enif_inspect_binary(env, packed, &bin)) {
+      throw std::runtime_error("Packed values must be a binary");
+    }
+    if (bin.size % sizeof(T) != 0) {
+      throw std::runtime_error(
+          "Packed binary size " + std::to_string(bin.size) +
+          " is not a multiple of the element size " + std::to_string(sizeof(T)));
+    }
+
+    auto typed = col_res->ptr->As<ColumnT>();
+    if (!typed) {
+      throw std::runtime_error("Packed binary does not match column type " +
+                               col_res->ptr->GetType().GetName());
+    }
+
+    auto &data = typed->GetWritableData();
+    size_t old_size = data.size();
+    data.resize(old_size + bin.size / sizeof(T));
+    std::memcpy(data.data() + old_size, bin.data, bin.size);
+
+    return fine::Atom("ok");
+  } catch (const std::exception& e) {
+    throw std::runtime_error(encode_clickhouse_error(e));
+  }
+}
+
+// Packed binary append for UInt64 columns (8 bytes per value)
+fine::Atom column_uint64_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnUInt64>(env, col_res, packed);
+}
+FINE_NIF(column_uint64_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Packed binary append for UInt32 columns (4 bytes per value)
+fine::Atom column_uint32_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnUInt32>(env, col_res, packed);
+}
+FINE_NIF(column_uint32_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Packed binary append for UInt16 columns (2 bytes per value)
+fine::Atom column_uint16_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnUInt16>(env, col_res, packed);
+}
+FINE_NIF(column_uint16_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Packed binary append for UInt8 and Bool columns (1 byte per value)
+fine::Atom column_uint8_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnUInt8>(env, col_res, packed);
+}
+FINE_NIF(column_uint8_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Packed binary append for Int64 columns (8 bytes per value)
+fine::Atom column_int64_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnInt64>(env, col_res, packed);
+}
+FINE_NIF(column_int64_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Packed binary append for Int32 columns (4 bytes per value)
+fine::Atom column_int32_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnInt32>(env, col_res, packed);
+}
+FINE_NIF(column_int32_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Packed binary append for Int16 columns (2 bytes per value)
+fine::Atom column_int16_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnInt16>(env, col_res, packed);
+}
+FINE_NIF(column_int16_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Packed binary append for Int8 columns (1 byte per value)
+fine::Atom column_int8_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnInt8>(env, col_res, packed);
+}
+FINE_NIF(column_int8_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Packed binary append for Float64 columns (IEEE 754 doubles)
+fine::Atom column_float64_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnFloat64>(env, col_res, packed);
+}
+FINE_NIF(column_float64_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Packed binary append for Float32 columns (IEEE 754 singles)
+fine::Atom column_float32_append_binary(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ColumnResource> col_res,
+    fine::Term packed) {
+  return append_packed_binary<ColumnFloat32>(env, col_res, packed);
+}
+FINE_NIF(column_float32_append_binary, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // ============================================================================
 // Array Column Support
@@ -539,6 +689,11 @@ fine::Atom column_array_append_from_column(
     ColumnRef nested_col = nested_col_res->ptr;
     size_t nested_size = nested_col->Size();
 
+    // Reserve the rows and their elements before appending them one by one
+    array_col->Reserve(array_col->Size() + offsets.size());
+    ColumnRef data = ArrayColumnAccess::data(*array_col);
+    data->Reserve(data->Size() + nested_size);
+
     size_t prev = 0;
     for (size_t offset : offsets) {
       if (offset < prev) {
@@ -565,7 +720,7 @@ fine::Atom column_array_append_from_column(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_array_append_from_column, 0);
+FINE_NIF(column_array_append_from_column, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // ============================================================================
 // Tuple Type Support - Columnar API
@@ -624,7 +779,7 @@ fine::Atom column_tuple_append_from_columns(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_tuple_append_from_columns, 0);
+FINE_NIF(column_tuple_append_from_columns, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // ============================================================================
 // Map Type Support - Columnar API
@@ -662,7 +817,7 @@ fine::Atom column_map_append_from_array(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_map_append_from_array, 0);
+FINE_NIF(column_map_append_from_array, ERL_NIF_DIRTY_JOB_CPU_BOUND);
 
 // ============================================================================
 // LowCardinality Type Support
@@ -694,4 +849,399 @@ fine::Atom column_lowcardinality_append_from_column(
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(column_lowcardinality_append_from_column, 0);
+FINE_NIF(column_lowcardinality_append_from_column, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ============================================================================
+// Row Append
+// ============================================================================
+//
+// Append a list of rows straight into the columns of a new block, walking the
+// rows once for all columns. This replaces transposing the rows into one list
+// per column in Elixir and then decoding every list again in its bulk append
+// NIF. Rows are maps (looked up by each column's key) or tuples (indexed by
+// each column's position).
+//
+// Values are accepted in the same forms as Natch.Column.append_bulk/2:
+// integers (range checked), numbers for floats, binaries for strings,
+// booleans for Bool, %DateTime{}/%Date{} or integers for temporal columns and
+// nil for the null rows of Nullable columns.
+
+namespace {
+
+// Atoms for reading %Date{} and %DateTime{} fields
+struct TemporalAtoms {
+  ERL_NIF_TERM struct_key, date, datetime;
+  ERL_NIF_TERM year, month, day, hour, minute, second, microsecond;
+  ERL_NIF_TERM utc_offset, std_offset;
+
+  explicit TemporalAtoms(ErlNifEnv *env)
+      : struct_key(enif_make_atom(env, "__struct__")),
+        date(enif_make_atom(env, "Elixir.Date")),
+        datetime(enif_make_atom(env, "Elixir.DateTime")),
+        year(enif_make_atom(env, "year")),
+        month(enif_make_atom(env, "month")),
+        day(enif_make_atom(env, "day")),
+        hour(enif_make_atom(env, "hour")),
+        minute(enif_make_atom(env, "minute")),
+        second(enif_make_atom(env, "second")),
+        microsecond(enif_make_atom(env, "microsecond")),
+        utc_offset(enif_make_atom(env, "utc_offset")),
+        std_offset(enif_make_atom(env, "std_offset")) {}
+};
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's
+// days_from_civil), matching Date.diff(date, ~D[1970-01-01])
+int64_t days_from_civil(int64_t y, int64_t m, int64_t d) {
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const int64_t yoe = y - era * 400;
+  const int64_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+bool get_field(ErlNifEnv *env, ERL_NIF_TERM map, ERL_NIF_TERM key, int64_t &out) {
+  ERL_NIF_TERM value;
+  ErlNifSInt64 n;
+  if (!enif_get_map_value(env, map, key, &value) || !enif_get_int64(env, value, &n)) {
+    return false;
+  }
+  out = n;
+  return true;
+}
+
+bool is_struct(ErlNifEnv *env, ERL_NIF_TERM term, ERL_NIF_TERM module, const TemporalAtoms &atoms) {
+  ERL_NIF_TERM value;
+  return enif_is_map(env, term) && enif_get_map_value(env, term, atoms.struct_key, &value) &&
+         enif_is_identical(value, module);
+}
+
+// Days since the epoch of a %Date{}
+bool get_date_days(ErlNifEnv *env, ERL_NIF_TERM term, const TemporalAtoms &atoms, int64_t &days) {
+  int64_t y, m, d;
+  if (!is_struct(env, term, atoms.date, atoms) || !get_field(env, term, atoms.year, y) ||
+      !get_field(env, term, atoms.month, m) || !get_field(env, term, atoms.day, d)) {
+    return false;
+  }
+  days = days_from_civil(y, m, d);
+  return true;
+}
+
+// Unix time of a %DateTime{} in seconds plus its microseconds, matching
+// DateTime.to_unix/2
+bool get_datetime(
+    ErlNifEnv *env,
+    ERL_NIF_TERM term,
+    const TemporalAtoms &atoms,
+    int64_t &seconds,
+    int64_t &micros) {
+  int64_t y, mo, d, h, mi, s, utc_offset, std_offset;
+  if (!is_struct(env, term, atoms.datetime, atoms) || !get_field(env, term, atoms.year, y) ||
+      !get_field(env, term, atoms.month, mo) || !get_field(env, term, atoms.day, d) ||
+      !get_field(env, term, atoms.hour, h) || !get_field(env, term, atoms.minute, mi) ||
+      !get_field(env, term, atoms.second, s) ||
+      !get_field(env, term, atoms.utc_offset, utc_offset) ||
+      !get_field(env, term, atoms.std_offset, std_offset)) {
+    return false;
+  }
+
+  // microsecond is {value, precision}
+  ERL_NIF_TERM usec;
+  const ERL_NIF_TERM *usec_parts;
+  int arity;
+  ErlNifSInt64 us;
+  if (!enif_get_map_value(env, term, atoms.microsecond, &usec) ||
+      !enif_get_tuple(env, usec, &arity, &usec_parts) || arity != 2 ||
+      !enif_get_int64(env, usec_parts[0], &us)) {
+    return false;
+  }
+
+  seconds = days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s - utc_offset - std_offset;
+  micros = us;
+  return true;
+}
+
+bool get_number(ErlNifEnv *env, ERL_NIF_TERM term, double &out) {
+  ErlNifSInt64 i;
+  ErlNifUInt64 u;
+  if (enif_get_double(env, term, &out)) {
+    return true;
+  }
+  if (enif_get_int64(env, term, &i)) {
+    out = static_cast<double>(i);
+    return true;
+  }
+  if (enif_get_uint64(env, term, &u)) {
+    out = static_cast<double>(u);
+    return true;
+  }
+  return false;
+}
+
+// Appends one row value to a column; returns false if the value has the
+// wrong type or is out of range
+using RowAppendFn = bool (*)(ErlNifEnv *, const TemporalAtoms &, Column &, ERL_NIF_TERM);
+
+template <typename ColumnT>
+bool append_row_integer(ErlNifEnv *env, const TemporalAtoms &, Column &col, ERL_NIF_TERM term) {
+  using T = typename ColumnT::ValueType;
+  if constexpr (std::is_same_v<T, uint64_t>) {
+    ErlNifUInt64 value;
+    if (!enif_get_uint64(env, term, &value)) {
+      return false;
+    }
+    static_cast<ColumnT &>(col).Append(value);
+  } else {
+    ErlNifSInt64 value;
+    if (!enif_get_int64(env, term, &value) || value < std::numeric_limits<T>::min() ||
+        value > std::numeric_limits<T>::max()) {
+      return false;
+    }
+    static_cast<ColumnT &>(col).Append(static_cast<T>(value));
+  }
+  return true;
+}
+
+template <typename ColumnT>
+bool append_row_float(ErlNifEnv *env, const TemporalAtoms &, Column &col, ERL_NIF_TERM term) {
+  double value;
+  if (!get_number(env, term, value)) {
+    return false;
+  }
+  static_cast<ColumnT &>(col).Append(static_cast<typename ColumnT::ValueType>(value));
+  return true;
+}
+
+bool append_row_bool(ErlNifEnv *env, const TemporalAtoms &, Column &col, ERL_NIF_TERM term) {
+  char name[6];
+  if (enif_get_atom(env, term, name, sizeof(name), ERL_NIF_LATIN1) <= 0) {
+    return false;
+  }
+  if (std::strcmp(name, "true") == 0) {
+    static_cast<ColumnUInt8 &>(col).Append(1);
+  } else if (std::strcmp(name, "false") == 0) {
+    static_cast<ColumnUInt8 &>(col).Append(0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool append_row_string(ErlNifEnv *env, const TemporalAtoms &, Column &col, ERL_NIF_TERM term) {
+  ErlNifBinary bin;
+  if (!enif_inspect_binary(env, term, &bin)) {
+    return false;
+  }
+  static_cast<ColumnString &>(col).Append(
+      std::string_view(reinterpret_cast<const char *>(bin.data), bin.size));
+  return true;
+}
+
+bool append_row_datetime(ErlNifEnv *env, const TemporalAtoms &atoms, Column &col, ERL_NIF_TERM term) {
+  ErlNifSInt64 timestamp;
+  int64_t seconds, micros;
+  if (enif_get_int64(env, term, &timestamp)) {
+    seconds = timestamp;
+  } else if (!get_datetime(env, term, atoms, seconds, micros)) {
+    return false;
+  }
+  // DateTime is stored as UInt32 seconds
+  if (seconds < 0 || seconds > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  static_cast<ColumnDateTime &>(col).Append(static_cast<time_t>(seconds));
+  return true;
+}
+
+bool append_row_datetime64(ErlNifEnv *env, const TemporalAtoms &atoms, Column &col, ERL_NIF_TERM term) {
+  ErlNifSInt64 ticks;
+  int64_t seconds, micros;
+  if (!enif_get_int64(env, term, &ticks)) {
+    if (!get_datetime(env, term, atoms, seconds, micros)) {
+      return false;
+    }
+    ticks = seconds * 1000000 + micros;
+  }
+  static_cast<ColumnDateTime64 &>(col).Append(ticks);
+  return true;
+}
+
+bool append_row_date(ErlNifEnv *env, const TemporalAtoms &atoms, Column &col, ERL_NIF_TERM term) {
+  ErlNifSInt64 value;
+  int64_t days;
+  if (enif_get_int64(env, term, &value)) {
+    days = value;
+  } else if (!get_date_days(env, term, atoms, days)) {
+    return false;
+  }
+  // Date is stored as UInt16 days since the epoch
+  if (days < 0 || days > std::numeric_limits<uint16_t>::max()) {
+    return false;
+  }
+  static_cast<ColumnDate &>(col).AppendRaw(static_cast<uint16_t>(days));
+  return true;
+}
+
+// Appender for a column created from one of the row-appendable types, or
+// nullptr if the type has no row appender
+RowAppendFn row_append_fn(const Column &col) {
+  switch (col.Type()->GetCode()) {
+  case Type::UInt64:
+    return append_row_integer<ColumnUInt64>;
+  case Type::UInt32:
+    return append_row_integer<ColumnUInt32>;
+  case Type::UInt16:
+    return append_row_integer<ColumnUInt16>;
+  case Type::Int64:
+    return append_row_integer<ColumnInt64>;
+  case Type::Int32:
+    return append_row_integer<ColumnInt32>;
+  case Type::Int16:
+    return append_row_integer<ColumnInt16>;
+  case Type::Int8:
+    return append_row_integer<ColumnInt8>;
+  case Type::Float64:
+    return append_row_float<ColumnFloat64>;
+  case Type::Float32:
+    return append_row_float<ColumnFloat32>;
+  case Type::UInt8:
+    return append_row_bool;
+  case Type::String:
+    return append_row_string;
+  case Type::DateTime:
+    return append_row_datetime;
+  case Type::DateTime64:
+    return append_row_datetime64;
+  case Type::Date:
+    return append_row_date;
+  default:
+    return nullptr;
+  }
+}
+
+// Where one column's values come from and where they go
+struct RowTarget {
+  ERL_NIF_TERM key;
+  size_t position = 0;
+  Column *column;          // Nested column for Nullable
+  ColumnUInt8 *nulls = nullptr;
+  ERL_NIF_TERM null_default;
+  RowAppendFn append;
+};
+
+std::string format_term(ERL_NIF_TERM term) {
+  char buf[128];
+  enif_snprintf(buf, sizeof(buf), "%T", term);
+  return buf;
+}
+
+RowTarget make_row_target(ErlNifEnv *env, Column &col, ERL_NIF_TERM key) {
+  RowTarget target;
+  target.key = key;
+  target.column = &col;
+
+  if (auto nullable = col.As<ColumnNullable>()) {
+    target.column = nullable->Nested().get();
+    target.nulls = nullable->Nulls()->As<ColumnUInt8>().get();
+  }
+
+  target.append = row_append_fn(*target.column);
+  if (!target.append) {
+    throw std::runtime_error(
+        "Column " + format_term(key) + " of type " + col.Type()->GetName() +
+        " can't be appended from rows");
+  }
+
+  // Value appended to the nested column of a null row
+  if (target.column->Type()->GetCode() == Type::String) {
+    enif_make_new_binary(env, 0, &target.null_default);
+  } else if (target.column->Type()->GetCode() == Type::UInt8) {
+    target.null_default = enif_make_atom(env, "false");
+  } else {
+    target.null_default = enif_make_int(env, 0);
+  }
+
+  ErlNifUInt64 position;
+  if (enif_get_uint64(env, key, &position)) {
+    target.position = position;
+  }
+  return target;
+}
+
+}  // namespace
+
+// Append `rows` to `columns`, reading column i's value from each row by
+// keys[i] (maps) or at position keys[i] (tuples)
+fine::Atom column_append_rows(
+    ErlNifEnv *env,
+    std::vector<fine::ResourcePtr<ColumnResource>> columns,
+    std::vector<fine::Term> keys,
+    fine::Term rows) {
+  try {
+    if (columns.size() != keys.size()) {
+      throw std::runtime_error("Each column needs exactly one key");
+    }
+
+    TemporalAtoms atoms(env);
+    ERL_NIF_TERM nil = enif_make_atom(env, "nil");
+
+    std::vector<RowTarget> targets;
+    targets.reserve(columns.size());
+    for (size_t c = 0; c < columns.size(); c++) {
+      targets.push_back(make_row_target(env, *columns[c]->ptr, keys[c]));
+    }
+
+    ERL_NIF_TERM list = rows;
+    ERL_NIF_TERM row;
+    size_t row_index = 0;
+
+    while (enif_get_list_cell(env, list, &row, &list)) {
+      bool is_map = enif_is_map(env, row);
+      const ERL_NIF_TERM *elements = nullptr;
+      int arity = 0;
+      if (!is_map && !enif_get_tuple(env, row, &arity, &elements)) {
+        throw std::runtime_error(
+            "Row " + std::to_string(row_index) + " is not a map or tuple: " + format_term(row));
+      }
+
+      for (auto &target : targets) {
+        ERL_NIF_TERM value;
+        if (is_map) {
+          if (!enif_get_map_value(env, row, target.key, &value)) {
+            throw std::runtime_error(
+                "Row " + std::to_string(row_index) + " has no column " + format_term(target.key));
+          }
+        } else {
+          if (target.position >= static_cast<size_t>(arity)) {
+            throw std::runtime_error(
+                "Row " + std::to_string(row_index) + " has " + std::to_string(arity) +
+                " elements, expected at least " + std::to_string(target.position + 1));
+          }
+          value = elements[target.position];
+        }
+
+        bool is_null = target.nulls && enif_is_identical(value, nil);
+        if (!target.append(env, atoms, *target.column, is_null ? target.null_default : value)) {
+          throw std::runtime_error(
+              "Invalid value for " + target.column->Type()->GetName() + " column " +
+              format_term(target.key) + " in row " + std::to_string(row_index) + ": " +
+              format_term(value));
+        }
+        if (target.nulls) {
+          target.nulls->Append(is_null ? 1 : 0);
+        }
+      }
+
+      row_index++;
+    }
+
+    if (!enif_is_empty_list(env, list)) {
+      throw std::runtime_error("Rows must be a proper list");
+    }
+
+    return fine::Atom("ok");
+  } catch (const std::exception& e) {
+    throw std::runtime_error(encode_clickhouse_error(e));
+  }
+}
+FINE_NIF(column_append_rows, ERL_NIF_DIRTY_JOB_CPU_BOUND);
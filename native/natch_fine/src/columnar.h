@@ -0,0 +1,129 @@
+#pragma once
+
+#include <fine.hpp>
+#include <clickhouse/block.h>
+#include <clickhouse/columns/nullable.h>
+#include <string>
+#include <vector>
+
+#include "decode_options.h"
+#include "query_stats.h"
+
+// Result building shared by the SELECT NIFs (defined in select.cpp).
+//
+// A whole result is collected in a ResultBuffer, which keeps the non-empty
+// blocks as received and only turns them into terms once the query has
+// finished. Terms are built from the last block to the first, so each
+// block's values are consed straight onto the final lists: there is never a
+// native vector of terms for the whole result alongside the lists built from
+// it, and each block is freed as soon as it has been converted. The
+// collectors below wrap a buffer for use as Select callbacks, and a streamed
+// block is converted through a buffer of its own.
+
+// The per-column decoder all of them share: appends one term per row of
+// `col` to `out`, nil for rows that `nulls` marks as NULL
+void append_column_terms(
+    ErlNifEnv *env,
+    const clickhouse::ColumnRef &col,
+    const clickhouse::ColumnNullable *nulls,
+    const DecodeOptions &opts,
+    std::vector<ERL_NIF_TERM> &out);
+
+// Which term a buffered result becomes
+enum class ResultShape {
+  Columns,  // %{column_name => [values]}
+  Rows,     // [%{column_name => value}]
+  Tuples,   // {[column_name], [{values}]}, values in column order
+};
+
+// The blocks of a result, converted back to front. The accumulator passed
+// between calls is a tuple of one list per column (Columns) or the list of
+// rows (Rows, Tuples), so a conversion can be split across NIF calls.
+struct ResultBuffer {
+  ResultShape shape;
+  DecodeOptions opts;
+  std::vector<clickhouse::Block> blocks;
+  std::vector<std::string> column_names;
+  // Atoms of column_names, made once per result. Atoms are valid in any env.
+  std::vector<ERL_NIF_TERM> key_atoms;
+  // Where decode times and term sizes are recorded, if anywhere
+  QueryStats *stats = nullptr;
+
+  ResultBuffer(ResultShape shape, const DecodeOptions &opts, QueryStats *stats = nullptr)
+      : shape(shape), opts(opts), stats(stats) {}
+
+  void operator()(const clickhouse::Block &block) {
+    if (block.GetRowCount() == 0) {
+      return;
+    }
+
+    if (blocks.empty()) {
+      for (size_t c = 0; c < block.GetColumnCount(); c++) {
+        column_names.push_back(block.GetColumnName(c));
+      }
+    }
+
+    // Copying a Block shares its columns
+    blocks.push_back(block);
+  }
+
+  // The column name atoms, in column order
+  const std::vector<ERL_NIF_TERM> &column_keys(ErlNifEnv *env);
+
+  // Accumulator for a result with no rows converted yet
+  ERL_NIF_TERM initial_acc(ErlNifEnv *env) const;
+
+  // Cons the values of the last buffered block onto `acc` and drop the block
+  ERL_NIF_TERM consume_last(ErlNifEnv *env, ERL_NIF_TERM acc);
+
+  // Turn the accumulator of a fully consumed buffer into the result
+  ERL_NIF_TERM finish(ErlNifEnv *env, ERL_NIF_TERM acc);
+
+  // Convert every buffered block in one go
+  ERL_NIF_TERM build(ErlNifEnv *env) {
+    ERL_NIF_TERM acc = initial_acc(env);
+    while (!blocks.empty()) {
+      acc = consume_last(env, acc);
+    }
+    return finish(env, acc);
+  }
+};
+
+// Accumulates a whole result as %{column_name => [values]}
+struct ColumnarCollector {
+  ErlNifEnv *env;
+  ResultBuffer buffer;
+
+  ColumnarCollector(ErlNifEnv *env, const DecodeOptions &opts, QueryStats *stats = nullptr)
+      : env(env), buffer(ResultShape::Columns, opts, stats) {}
+
+  void operator()(const clickhouse::Block &block) { buffer(block); }
+
+  ERL_NIF_TERM result() { return buffer.build(env); }
+};
+
+// Accumulates a whole result as a list of row maps
+struct RowCollector {
+  ErlNifEnv *env;
+  ResultBuffer buffer;
+
+  RowCollector(ErlNifEnv *env, const DecodeOptions &opts, QueryStats *stats = nullptr)
+      : env(env), buffer(ResultShape::Rows, opts, stats) {}
+
+  void operator()(const clickhouse::Block &block) { buffer(block); }
+
+  ERL_NIF_TERM result() { return buffer.build(env); }
+};
+
+// Accumulates a whole result as the column names and a list of row tuples
+struct TupleCollector {
+  ErlNifEnv *env;
+  ResultBuffer buffer;
+
+  TupleCollector(ErlNifEnv *env, const DecodeOptions &opts, QueryStats *stats = nullptr)
+      : env(env), buffer(ResultShape::Tuples, opts, stats) {}
+
+  void operator()(const clickhouse::Block &block) { buffer(block); }
+
+  ERL_NIF_TERM result() { return buffer.build(env); }
+};
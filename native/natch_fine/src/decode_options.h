@@ -0,0 +1,22 @@
+#pragma once
+
+// Per-client options controlling how result columns are turned into terms.
+// Set with client_set_decode_options/2 and read by every SELECT path.
+struct DecodeOptions {
+  // Copy each String column of a block into one refcounted binary and
+  // return the values as sub-binaries of it, instead of allocating one
+  // binary per value. Any value kept alive keeps the whole block payload
+  // alive, so callers that retain a few values from a large result should
+  // :binary.copy/1 them.
+  bool sub_binary_strings = false;
+
+  // Return Enum8/Enum16 names as atoms instead of binaries. Enum names come
+  // from the column type, so the number of atoms created is bounded.
+  bool enum_atoms = false;
+
+  // Decode the columns of large blocks on up to this many threads (the
+  // calling one included) from the shared DecodePool. Each column is
+  // decoded into its own env and copied into the result, which loses the
+  // term sharing of LowCardinality/Enum values. 1 decodes serially.
+  unsigned decode_threads = 1;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "job_queue.h"
+
+// DecodePool - native threads shared by every client for decoding the
+// columns of a block in parallel (DecodeOptions::decode_threads)
+//
+// Threads are started on first use, up to one per hardware thread, and live
+// for the rest of the VM. run_parallel() hands tasks out from a shared
+// counter and the calling thread works through them as well, so a call
+// always makes progress even while every pool thread is busy with another
+// client's block.
+class DecodePool {
+public:
+  static DecodePool &instance() {
+    static DecodePool pool;
+    return pool;
+  }
+
+  // Run task(0) .. task(count - 1) on up to `parallelism` threads (the
+  // caller included) and wait for all of them. The first exception thrown
+  // by a task is rethrown once every task has finished.
+  void run_parallel(
+      size_t count,
+      size_t parallelism,
+      const std::function<void(size_t)> &task) {
+    if (count == 0) {
+      return;
+    }
+
+    auto batch = std::make_shared<Batch>(count, task);
+    size_t helpers = std::min(std::max<size_t>(parallelism, 1), count) - 1;
+    helpers = start_threads(helpers);
+
+    // A helper that only starts after the batch is done finds no task left
+    // and returns without touching `task`
+    for (size_t h = 0; h < helpers; h++) {
+      queue_->push([batch] { batch->work(); });
+    }
+
+    batch->work();
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done_cv.wait(lock, [&] { return batch->completed == count; });
+
+    if (batch->error) {
+      std::rethrow_exception(batch->error);
+    }
+  }
+
+private:
+  struct Batch {
+    const size_t count;
+    const std::function<void(size_t)> &task;
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    size_t completed = 0;
+    std::exception_ptr error;
+
+    Batch(size_t count, const std::function<void(size_t)> &task) : count(count), task(task) {}
+
+    void work() {
+      for (;;) {
+        size_t i = next.fetch_add(1);
+        if (i >= count) {
+          return;
+        }
+
+        std::exception_ptr task_error;
+        try {
+          task(i);
+        } catch (...) {
+          task_error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (task_error && !error) {
+          error = task_error;
+        }
+        if (++completed == count) {
+          done_cv.notify_all();
+        }
+      }
+    }
+  };
+
+  DecodePool() : queue_(std::make_shared<JobQueue>()) {
+    max_threads_ = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Start pool threads until there are `wanted` (capped at max_threads_);
+  // returns how many helpers can be used
+  size_t start_threads(size_t wanted) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wanted = std::min(wanted, max_threads_);
+    while (threads_ < wanted) {
+      std::thread(JobQueue::run, queue_).detach();
+      threads_++;
+    }
+    return wanted;
+  }
+
+  std::shared_ptr<JobQueue> queue_;
+  std::mutex mutex_;
+  size_t threads_ = 0;
+  size_t max_threads_;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// FIFO of jobs consumed by one or more native threads running JobQueue::run.
+// Used by the ClientResource worker thread (client_resource.h) and the
+// decode thread pool (decode_pool.h).
+struct JobQueue {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> jobs;
+  bool stopping = false;
+
+  void push(std::function<void()> job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobs.push_back(std::move(job));
+    }
+    cv.notify_one();
+  }
+
+  static void run(std::shared_ptr<JobQueue> queue) {
+    for (;;) {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        queue->cv.wait(lock, [&] { return queue->stopping || !queue->jobs.empty(); });
+
+        if (queue->jobs.empty()) {
+          return;  // Stopping and fully drained
+        }
+
+        job = std::move(queue->jobs.front());
+        queue->jobs.pop_front();
+      }
+      job();
+    }
+  }
+};
@@ -0,0 +1,197 @@
+// lazy.cpp - SELECT results kept as native blocks (select_lazy)
+//
+// client_select_lazy_async replies with the result blocks themselves, each
+// wrapped in a BlockResource, instead of terms. A column (or a range of its
+// rows) becomes terms only when block_column_terms or block_row_terms asks
+// for it, so columns the caller never reads are never decoded. The blocks
+// stay in native memory until the BEAM garbage collects the last reference
+// to them.
+//
+// Accessors decode on dirty CPU schedulers, like any other term building of
+// a full block.
+
+#include <fine.hpp>
+#include <clickhouse/client.h>
+#include <clickhouse/query.h>
+#include <clickhouse/block.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "async.h"
+#include "block_resource.h"
+#include "client_resource.h"
+#include "columnar.h"
+#include "query_control.h"
+#include "query_stats.h"
+
+using namespace clickhouse;
+
+namespace {
+
+// Collects the non-empty blocks of a result, and the schema from the header
+// block so that empty results still have their column names
+struct LazyCollector {
+  std::vector<Block> blocks;
+  std::vector<std::string> names;
+  std::vector<std::string> types;
+
+  void operator()(const Block &block) {
+    if (names.empty()) {
+      for (size_t c = 0; c < block.GetColumnCount(); c++) {
+        names.push_back(block.GetColumnName(c));
+        types.push_back(block[c]->Type()->GetName());
+      }
+    }
+    if (block.GetRowCount() > 0) {
+      blocks.push_back(block);
+    }
+  }
+};
+
+// {[{block, rows}], [column_name], [column_type]}. The collected blocks are
+// moved into their resources rather than copied.
+ERL_NIF_TERM make_lazy_result(ErlNifEnv *env, LazyCollector &collector, const DecodeOptions &opts) {
+  std::vector<ERL_NIF_TERM> blocks;
+  blocks.reserve(collector.blocks.size());
+  for (auto &block : collector.blocks) {
+    uint64_t rows = block.GetRowCount();
+    auto resource = fine::make_resource<BlockResource>(std::move(block), opts);
+    blocks.push_back(enif_make_tuple2(env, fine::encode(env, resource), enif_make_uint64(env, rows)));
+  }
+  collector.blocks.clear();
+
+  std::vector<ERL_NIF_TERM> names;
+  std::vector<ERL_NIF_TERM> types;
+  for (size_t c = 0; c < collector.names.size(); c++) {
+    names.push_back(enif_make_atom(env, collector.names[c].c_str()));
+    types.push_back(fine::encode(env, collector.types[c]));
+  }
+
+  return enif_make_tuple3(
+      env,
+      enif_make_list_from_array(env, blocks.data(), blocks.size()),
+      enif_make_list_from_array(env, names.data(), names.size()),
+      enif_make_list_from_array(env, types.data(), types.size()));
+}
+
+// Column `index` of the block, cut down to rows [offset, offset + count)
+ColumnRef column_range(const Block &block, uint64_t index, uint64_t offset, uint64_t count) {
+  if (index >= block.GetColumnCount()) {
+    throw std::invalid_argument("Column index out of range");
+  }
+  if (offset > block.GetRowCount() || count > block.GetRowCount() - offset) {
+    throw std::invalid_argument("Row range out of bounds");
+  }
+
+  ColumnRef col = block[index];
+  if (offset == 0 && count == block.GetRowCount()) {
+    return col;
+  }
+  // Slice copies only the requested rows
+  return col->Slice(offset, count);
+}
+
+} // namespace
+
+/// Lazy SELECT; replies {ref, {:ok, {{blocks, names, types}, stats}}}
+fine::Atom client_select_lazy_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    LazyCollector collector;
+    Query select(query);
+    select_controlled(c, select, *control, stats, collector);
+    ERL_NIF_TERM result;
+    {
+      ScopedTimer timer(stats.decode_ns);
+      result = make_lazy_result(msg_env, collector, opts);
+    }
+    return stats.with_result(msg_env, result);
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_lazy_async, 0);
+
+/// Parameterized lazy SELECT
+fine::Atom client_select_lazy_parameterized_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query,
+    fine::ResourcePtr<QueryControl> control,
+    ErlNifPid pid,
+    fine::Term ref) {
+  run_async(client, pid, ref, [query, control](ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    LazyCollector collector;
+    select_controlled(c, *query, *control, stats, collector);
+    ERL_NIF_TERM result;
+    {
+      ScopedTimer timer(stats.decode_ns);
+      result = make_lazy_result(msg_env, collector, opts);
+    }
+    return stats.with_result(msg_env, result);
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_lazy_parameterized_async, 0);
+
+/// The values of rows [offset, offset + count) of column `index`, as a list
+fine::Term block_column_terms(
+    ErlNifEnv *env,
+    fine::ResourcePtr<BlockResource> block_res,
+    uint64_t index,
+    uint64_t offset,
+    uint64_t count) {
+  auto col = column_range(*block_res->ptr, index, offset, count);
+
+  std::vector<ERL_NIF_TERM> terms;
+  terms.reserve(count);
+  append_column_terms(env, col, nullptr, block_res->decode_options, terms);
+  return enif_make_list_from_array(env, terms.data(), terms.size());
+}
+FINE_NIF(block_column_terms, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+/// Rows [offset, offset + count) as a list of maps holding only the columns
+/// in `indexes`
+fine::Term block_row_terms(
+    ErlNifEnv *env,
+    fine::ResourcePtr<BlockResource> block_res,
+    std::vector<uint64_t> indexes,
+    uint64_t offset,
+    uint64_t count) {
+  const Block &block = *block_res->ptr;
+  size_t width = indexes.size();
+
+  std::vector<ERL_NIF_TERM> keys;
+  std::vector<std::vector<ERL_NIF_TERM>> columns(width);
+  keys.reserve(width);
+  for (size_t i = 0; i < width; i++) {
+    auto col = column_range(block, indexes[i], offset, count);
+    keys.push_back(enif_make_atom(env, block.GetColumnName(indexes[i]).c_str()));
+    columns[i].reserve(count);
+    append_column_terms(env, col, nullptr, block_res->decode_options, columns[i]);
+  }
+
+  std::vector<ERL_NIF_TERM> rows;
+  std::vector<ERL_NIF_TERM> values(width);
+  rows.reserve(count);
+  for (size_t r = 0; r < count; r++) {
+    for (size_t i = 0; i < width; i++) {
+      values[i] = columns[i][r];
+    }
+    ERL_NIF_TERM row;
+    if (!enif_make_map_from_arrays(env, keys.data(), values.data(), width, &row)) {
+      throw std::invalid_argument("Duplicate column in row selection");
+    }
+    rows.push_back(row);
+  }
+  return enif_make_list_from_array(env, rows.data(), rows.size());
+}
+FINE_NIF(block_row_terms, ERL_NIF_DIRTY_JOB_CPU_BOUND);
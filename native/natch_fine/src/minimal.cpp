@@ -7,10 +7,12 @@
 #include <system_error>
 #include <map>
 
+#include "client_resource.h"
+
 using namespace clickhouse;
 
-// Declare Client as FINE resource
-FINE_RESOURCE(Client);
+// Declare the client wrapper (Client + lock + async worker) as FINE resource
+FINE_RESOURCE(ClientResource);
 
 // Helper to escape JSON strings
 std::string escape_json_string(const std::string& input) {
@@ -92,23 +94,41 @@ std::string get_optional_string(const std::string& value) {
   return value;
 }
 
+// Scheduling: every NIF here talks to the server over a socket (connect,
+// ping, query round-trips), so they are registered as dirty I/O NIFs.
+// Blocking on a normal scheduler would stall every process queued behind it.
+
 // Create a ClickHouse client with full options
 // Args: host, port, database (nil/empty for none), user (nil/empty for none),
-//       password (nil/empty for none), compression_enabled, ssl_enabled,
+//       password (nil/empty for none), compression (:none, :lz4 or :zstd,
+//       true/false meaning :lz4/:none), ssl_enabled,
 //       connect_timeout_ms, recv_timeout_ms, send_timeout_ms
 // Note: FINE converts Elixir nil to empty string for string params
-fine::ResourcePtr<Client> client_create(
+fine::ResourcePtr<ClientResource> client_create(
     ErlNifEnv *env,
     std::string host,
     uint64_t port,
     std::string database,
     std::string user,
     std::string password,
-    bool compression,
+    fine::Atom compression,
     bool ssl,
     uint64_t connect_timeout,
     uint64_t recv_timeout,
     uint64_t send_timeout) {
+  // The codec of data the client sends (INSERT blocks); what the server
+  // sends back is chosen per query (see QueryControl)
+  CompressionMethod method;
+  if (compression == fine::Atom("lz4") || compression == fine::Atom("true")) {
+    method = CompressionMethod::LZ4;
+  } else if (compression == fine::Atom("zstd")) {
+    method = CompressionMethod::ZSTD;
+  } else if (compression == fine::Atom("none") || compression == fine::Atom("false")) {
+    method = CompressionMethod::None;
+  } else {
+    throw std::invalid_argument("Unknown compression, expected :none, :lz4 or :zstd");
+  }
+
   try {
     ClientOptions opts;
     opts.SetHost(host);
@@ -126,9 +146,7 @@ fine::ResourcePtr<Client> client_create(
       opts.SetPassword(password);
     }
 
-    if (compression) {
-      opts.SetCompressionMethod(CompressionMethod::LZ4);
-    }
+    opts.SetCompressionMethod(method);
 
     if (ssl) {
       // Enable SSL with default settings:
@@ -146,78 +164,95 @@ fine::ResourcePtr<Client> client_create(
     opts.SetConnectionRecvTimeout(std::chrono::milliseconds(recv_timeout));
     opts.SetConnectionSendTimeout(std::chrono::milliseconds(send_timeout));
 
-    return fine::make_resource<Client>(opts);
+    return fine::make_resource<ClientResource>(opts);
   } catch (const std::exception& e) {
     // Use generic encoder to extract rich error information
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(client_create, 0);
+FINE_NIF(client_create, ERL_NIF_DIRTY_JOB_IO_BOUND);
 
 // Simple client creation (for PoC compatibility)
-fine::ResourcePtr<Client> create_client(ErlNifEnv *env) {
-  return client_create(env, "localhost", 9000, "", "", "", false, false, 5000, 0, 0);
+fine::ResourcePtr<ClientResource> create_client(ErlNifEnv *env) {
+  return client_create(env, "localhost", 9000, "", "", "", fine::Atom("none"), false, 5000, 0, 0);
 }
-FINE_NIF(create_client, 0);
+FINE_NIF(create_client, ERL_NIF_DIRTY_JOB_IO_BOUND);
 
 // Ping the ClickHouse server
-std::string client_ping(ErlNifEnv *env, fine::ResourcePtr<Client> client) {
+std::string client_ping(ErlNifEnv *env, fine::ResourcePtr<ClientResource> client) {
   try {
-    client->Ping();
+    client->locked()->Ping();
     return "pong";
   } catch (const std::exception& e) {
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(client_ping, 0);
+FINE_NIF(client_ping, ERL_NIF_DIRTY_JOB_IO_BOUND);
 
 // Alias for backwards compatibility with PoC
-std::string ping(ErlNifEnv *env, fine::ResourcePtr<Client> client) {
+std::string ping(ErlNifEnv *env, fine::ResourcePtr<ClientResource> client) {
   return client_ping(env, client);
 }
-FINE_NIF(ping, 0);
+FINE_NIF(ping, ERL_NIF_DIRTY_JOB_IO_BOUND);
 
 // Execute a query (DDL/DML without results)
 // Returns :ok atom on success
 fine::Atom client_execute(
     ErlNifEnv *env,
-    fine::ResourcePtr<Client> client,
+    fine::ResourcePtr<ClientResource> client,
     std::string sql) {
   try {
-    client->Execute(sql);
+    client->locked()->Execute(sql);
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(client_execute, 0);
+FINE_NIF(client_execute, ERL_NIF_DIRTY_JOB_IO_BOUND);
 
 // Execute parameterized query
 // Returns :ok atom on success
 fine::Atom client_execute_parameterized(
     ErlNifEnv *env,
-    fine::ResourcePtr<Client> client,
+    fine::ResourcePtr<ClientResource> client,
     fine::ResourcePtr<Query> query) {
   try {
-    client->Execute(*query);
+    client->locked()->Execute(*query);
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(client_execute_parameterized, 0);
+FINE_NIF(client_execute_parameterized, ERL_NIF_DIRTY_JOB_IO_BOUND);
 
 // Reset connection
 // Returns :ok atom on success
-fine::Atom client_reset_connection(ErlNifEnv *env, fine::ResourcePtr<Client> client) {
+fine::Atom client_reset_connection(ErlNifEnv *env, fine::ResourcePtr<ClientResource> client) {
   try {
-    client->ResetConnection();
+    client->locked()->ResetConnection();
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(encode_clickhouse_error(e));
   }
 }
-FINE_NIF(client_reset_connection, 0);
+FINE_NIF(client_reset_connection, ERL_NIF_DIRTY_JOB_IO_BOUND);
+
+// Set how SELECT results are decoded (see decode_options.h)
+// Waits for a running query through the client lock
+// Returns :ok atom
+fine::Atom client_set_decode_options(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    bool sub_binary_strings,
+    bool enum_atoms,
+    uint64_t decode_threads) {
+  auto session = client->locked();
+  session.options().sub_binary_strings = sub_binary_strings;
+  session.options().enum_atoms = enum_atoms;
+  session.options().decode_threads = static_cast<unsigned>(decode_threads);
+  return fine::Atom("ok");
+}
+FINE_NIF(client_set_decode_options, ERL_NIF_DIRTY_JOB_IO_BOUND);
 
 // Initialize the NIF module
 FINE_INIT("Elixir.Natch.Native");
@@ -0,0 +1,108 @@
+// native_format.cpp - Blocks parsed from ClickHouse Native format data
+//
+// block_from_native turns a binary in the Native format (what
+// `SELECT ... FORMAT Native` returns over HTTP, or clickhouse-local writes)
+// into a Block with clickhouse-cpp's own column deserializers, the
+// Column::Load the client runs on every result block it receives. The block
+// is then inserted like any other (client_insert, client_insert_async), so
+// the data goes from the producer's bytes to the wire without ever being
+// Erlang terms.
+//
+// The data is a sequence of blocks, each
+//
+//   varint column_count, varint row_count,
+//   column_count x (string name, string type, column data)
+//
+// where the column data is empty for a block of no rows. Blocks after the
+// first are appended onto its columns, so the whole binary becomes one
+// Block and one INSERT.
+
+#include <fine.hpp>
+#include <clickhouse/block.h>
+#include <clickhouse/base/input.h>
+#include <clickhouse/base/wire_format.h>
+#include <clickhouse/columns/factory.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "block_resource.h"
+#include "error_encoding.h"
+
+using namespace clickhouse;
+
+namespace {
+
+[[noreturn]] void truncated() {
+  throw std::runtime_error("Native data is truncated");
+}
+
+} // namespace
+
+/// Parse Native format data into a block for INSERT
+fine::ResourcePtr<BlockResource> block_from_native(ErlNifEnv *env, fine::Term data) {
+  ErlNifBinary bin;
+  if (!enif_inspect_binary(env, data, &bin)) {
+    throw std::invalid_argument("Native data must be a binary");
+  }
+
+  try {
+    ArrayInput input(bin.data, bin.size);
+    std::vector<std::string> names;
+    std::vector<ColumnRef> columns;
+
+    while (!input.Exhausted()) {
+      uint64_t column_count, row_count;
+      if (!WireFormat::ReadUInt64(input, &column_count) ||
+          !WireFormat::ReadUInt64(input, &row_count)) {
+        truncated();
+      }
+      bool first = names.empty();
+      if (!first && column_count != names.size()) {
+        throw std::runtime_error("Native block has " + std::to_string(column_count) +
+                                 " columns, the first block has " + std::to_string(names.size()));
+      }
+
+      for (size_t c = 0; c < column_count; c++) {
+        std::string name, type;
+        if (!WireFormat::ReadString(input, &name) || !WireFormat::ReadString(input, &type)) {
+          truncated();
+        }
+
+        ColumnRef col = CreateColumnByType(type);
+        if (!col) {
+          throw std::runtime_error("Unsupported column type in Native data: " + type);
+        }
+        if (row_count > 0 && !col->Load(&input, row_count)) {
+          truncated();
+        }
+
+        if (first) {
+          names.push_back(name);
+          columns.push_back(col);
+        } else if (name != names[c] ||
+                   col->GetType().GetName() != columns[c]->GetType().GetName()) {
+          throw std::runtime_error("Native block column " + name + " " + type +
+                                   " differs from the first block's " + names[c] + " " +
+                                   columns[c]->GetType().GetName());
+        } else {
+          columns[c]->Append(col);
+        }
+      }
+    }
+
+    if (names.empty()) {
+      throw std::runtime_error("Native data holds no blocks");
+    }
+
+    auto block = std::make_shared<Block>();
+    for (size_t c = 0; c < names.size(); c++) {
+      block->AppendColumn(names[c], columns[c]);
+    }
+    return fine::make_resource<BlockResource>(block);
+  } catch (const std::exception &e) {
+    throw std::runtime_error(encode_clickhouse_error(e));
+  }
+}
+FINE_NIF(block_from_native, ERL_NIF_DIRTY_JOB_CPU_BOUND);
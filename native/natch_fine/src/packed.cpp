@@ -0,0 +1,280 @@
+// packed.cpp - SELECT results as packed column buffers (see packed.h)
+//
+// Every column is sized from the row counts of all blocks first, then its
+// blocks are copied into one buffer each, so a column costs one allocation
+// per buffer and no per-value terms. Fixed-width columns whose storage
+// already matches the packed layout are copied with memcpy.
+
+#include <fine.hpp>
+#include <clickhouse/block.h>
+#include <clickhouse/columns/column.h>
+#include <clickhouse/columns/numeric.h>
+#include <clickhouse/columns/string.h>
+#include <clickhouse/columns/date.h>
+#include <clickhouse/columns/nullable.h>
+#include <clickhouse/columns/lowcardinality.h>
+#include <clickhouse/types/types.h>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "packed.h"
+
+using namespace clickhouse;
+
+namespace {
+
+// Copy a ColumnVector whose values are stored as-is
+template <typename ColumnT>
+void pack_vector(PackedColumn &packed, const std::vector<ColumnRef> &parts, const char *type) {
+  using T = typename ColumnT::ValueType;
+
+  packed.type = type;
+  packed.data = OwnedBinary(packed.rows * sizeof(T));
+
+  unsigned char *out = packed.data.data();
+  for (const auto &part : parts) {
+    auto &values = part->As<ColumnT>()->GetWritableData();
+    std::memcpy(out, values.data(), values.size() * sizeof(T));
+    out += values.size() * sizeof(T);
+  }
+}
+
+// Convert each value with `value(col, i)` into an Out, for columns whose
+// storage differs from the packed layout (Date, DateTime, ...)
+template <typename ColumnT, typename Out, typename Value>
+void pack_converted(
+    PackedColumn &packed,
+    const std::vector<ColumnRef> &parts,
+    const char *type,
+    Value value) {
+  packed.type = type;
+  packed.data = OwnedBinary(packed.rows * sizeof(Out));
+
+  auto *out = reinterpret_cast<Out *>(packed.data.data());
+  for (const auto &part : parts) {
+    const auto &col = *part->As<ColumnT>();
+    for (size_t i = 0; i < col.Size(); i++) {
+      *out++ = static_cast<Out>(value(col, i));
+    }
+  }
+}
+
+// Fill data and offsets from `rows` string_views produced by `each`, which
+// calls its argument once per row in order
+template <typename ForEach>
+void pack_strings(PackedColumn &packed, ForEach each) {
+  size_t total = 0;
+  each([&](std::string_view value) { total += value.size(); });
+
+  packed.type = "string";
+  packed.data = OwnedBinary(total);
+  packed.offsets = OwnedBinary((packed.rows + 1) * sizeof(int64_t));
+
+  unsigned char *out = packed.data.data();
+  auto *offsets = reinterpret_cast<int64_t *>(packed.offsets.data());
+  int64_t offset = 0;
+  *offsets++ = 0;
+
+  each([&](std::string_view value) {
+    std::memcpy(out + offset, value.data(), value.size());
+    offset += value.size();
+    *offsets++ = offset;
+  });
+}
+
+OwnedBinary make_validity(size_t rows) {
+  OwnedBinary validity((rows + 7) / 8);
+  std::memset(validity.data(), 0, validity.size());
+  return validity;
+}
+
+void mark_valid(OwnedBinary &validity, size_t row) {
+  validity.data()[row / 8] |= static_cast<unsigned char>(1u << (row % 8));
+}
+
+// LowCardinality(String) and LowCardinality(Nullable(String)) are unpacked
+// into plain strings; validity is only kept if a null was seen
+void pack_lowcardinality(PackedColumn &packed, const std::vector<ColumnRef> &parts) {
+  OwnedBinary validity = make_validity(packed.rows);
+  bool has_nulls = false;
+
+  pack_strings(packed, [&](auto &&emit) {
+    size_t row = 0;
+    for (const auto &part : parts) {
+      const auto &col = *part->As<ColumnLowCardinality>();
+      for (size_t i = 0; i < col.Size(); i++, row++) {
+        auto item = col.GetItem(i);
+        if (item.type == Type::Void) {
+          has_nulls = true;
+          emit(std::string_view());
+        } else if (item.type == Type::String) {
+          mark_valid(validity, row);
+          emit(item.get<std::string_view>());
+        } else {
+          throw std::runtime_error("Unsupported LowCardinality inner type");
+        }
+      }
+    }
+  });
+
+  if (has_nulls) {
+    packed.validity = std::move(validity);
+  }
+}
+
+void pack_values(PackedColumn &packed, const std::vector<ColumnRef> &parts) {
+  const auto &type = *parts[0]->Type();
+
+  switch (type.GetCode()) {
+  case Type::UInt64:
+    return pack_vector<ColumnUInt64>(packed, parts, "uint64");
+  case Type::UInt32:
+    return pack_vector<ColumnUInt32>(packed, parts, "uint32");
+  case Type::UInt16:
+    return pack_vector<ColumnUInt16>(packed, parts, "uint16");
+  case Type::UInt8:
+    return pack_vector<ColumnUInt8>(packed, parts, type.GetName() == "Bool" ? "bool" : "uint8");
+  case Type::Int64:
+    return pack_vector<ColumnInt64>(packed, parts, "int64");
+  case Type::Int32:
+    return pack_vector<ColumnInt32>(packed, parts, "int32");
+  case Type::Int16:
+    return pack_vector<ColumnInt16>(packed, parts, "int16");
+  case Type::Int8:
+    return pack_vector<ColumnInt8>(packed, parts, "int8");
+  case Type::Float64:
+    return pack_vector<ColumnFloat64>(packed, parts, "float64");
+  case Type::Float32:
+    return pack_vector<ColumnFloat32>(packed, parts, "float32");
+
+  // Temporal columns are widened to Arrow's date32 (int32 days) and
+  // timestamp (int64) layouts
+  case Type::Date:
+    return pack_converted<ColumnDate, int32_t>(
+        packed, parts, "date", [](const ColumnDate &col, size_t i) { return col.RawAt(i); });
+  case Type::Date32:
+    return pack_converted<ColumnDate32, int32_t>(
+        packed, parts, "date", [](const ColumnDate32 &col, size_t i) { return col.RawAt(i); });
+  case Type::DateTime:
+    return pack_converted<ColumnDateTime, int64_t>(
+        packed, parts, "datetime", [](const ColumnDateTime &col, size_t i) {
+          return col.RawAt(i);
+        });
+  case Type::DateTime64:
+    packed.precision = static_cast<int>(parts[0]->As<ColumnDateTime64>()->GetPrecision());
+    return pack_converted<ColumnDateTime64, int64_t>(
+        packed, parts, "datetime64", [](const ColumnDateTime64 &col, size_t i) {
+          return col.At(i);
+        });
+
+  case Type::String:
+    return pack_strings(packed, [&](auto &&emit) {
+      for (const auto &part : parts) {
+        const auto &col = *part->As<ColumnString>();
+        for (size_t i = 0; i < col.Size(); i++) {
+          emit(col.At(i));
+        }
+      }
+    });
+  case Type::LowCardinality:
+    return pack_lowcardinality(packed, parts);
+
+  default:
+    throw std::runtime_error("Unsupported column type for packed results: " + type.GetName());
+  }
+}
+
+PackedColumn pack_column(
+    const std::string &name,
+    const std::vector<clickhouse::Block> &blocks,
+    size_t index) {
+  std::vector<ColumnRef> parts;
+  size_t rows = 0;
+  parts.reserve(blocks.size());
+  for (const auto &block : blocks) {
+    parts.push_back(block[index]);
+    rows += block.GetRowCount();
+  }
+
+  return pack_parts(name, std::move(parts), rows);
+}
+
+}  // namespace
+
+PackedColumn pack_parts(std::string name, std::vector<ColumnRef> parts, size_t rows) {
+  PackedColumn packed;
+  packed.name = std::move(name);
+  packed.rows = rows;
+
+  // Nullable columns pack their nested values and a validity bitmap
+  if (parts[0]->Type()->GetCode() == Type::Nullable) {
+    packed.validity = make_validity(packed.rows);
+    size_t row = 0;
+    for (auto &part : parts) {
+      auto nullable = part->As<ColumnNullable>();
+      for (size_t i = 0; i < nullable->Size(); i++, row++) {
+        if (!nullable->IsNull(i)) {
+          mark_valid(packed.validity, row);
+        }
+      }
+      part = nullable->Nested();
+    }
+  }
+
+  pack_values(packed, parts);
+  return packed;
+}
+
+std::vector<PackedColumn> pack_blocks(const std::vector<clickhouse::Block> &blocks) {
+  std::vector<PackedColumn> columns;
+  if (blocks.empty()) {
+    return columns;
+  }
+
+  const auto &first = blocks.front();
+  columns.reserve(first.GetColumnCount());
+  for (size_t c = 0; c < first.GetColumnCount(); c++) {
+    columns.push_back(pack_column(first.GetColumnName(c), blocks, c));
+  }
+  return columns;
+}
+
+ERL_NIF_TERM make_packed_result(ErlNifEnv *env, std::vector<PackedColumn> &columns) {
+  std::vector<ERL_NIF_TERM> names, values;
+  names.reserve(columns.size());
+  values.reserve(columns.size());
+
+  for (auto &col : columns) {
+    std::vector<ERL_NIF_TERM> keys{enif_make_atom(env, "type"), enif_make_atom(env, "data")};
+    std::vector<ERL_NIF_TERM> fields{enif_make_atom(env, col.type), col.data.release(env)};
+
+    if (col.offsets) {
+      keys.push_back(enif_make_atom(env, "offsets"));
+      fields.push_back(col.offsets.release(env));
+    }
+    if (col.validity) {
+      keys.push_back(enif_make_atom(env, "validity"));
+      fields.push_back(col.validity.release(env));
+    }
+    if (col.precision >= 0) {
+      keys.push_back(enif_make_atom(env, "precision"));
+      fields.push_back(enif_make_int(env, col.precision));
+    }
+
+    ERL_NIF_TERM fields_map;
+    enif_make_map_from_arrays(env, keys.data(), fields.data(), keys.size(), &fields_map);
+
+    names.push_back(enif_make_atom_len(env, col.name.data(), col.name.size()));
+    values.push_back(fields_map);
+  }
+
+  ERL_NIF_TERM result;
+  if (!enif_make_map_from_arrays(env, names.data(), values.data(), names.size(), &result)) {
+    throw std::runtime_error("Duplicate column names in result");
+  }
+  return result;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <fine.hpp>
+#include <clickhouse/block.h>
+#include <clickhouse/columns/column.h>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Packed SELECT results (defined in packed.cpp)
+//
+// Instead of one term per value, each column of a result is copied into
+// contiguous native-endian buffers spanning all of its blocks, in the layout
+// Arrow uses:
+//
+//   data      fixed-width values, or the concatenated bytes of strings
+//   offsets   strings only: rows + 1 int64 offsets into data
+//   validity  nullable columns only: one bit per row, least significant bit
+//             first, set for rows that are not null
+//
+// Null rows keep the nested column's default value in data.
+
+// An enif binary owned until it is turned into a term
+class OwnedBinary {
+public:
+  OwnedBinary() = default;
+
+  explicit OwnedBinary(size_t size) {
+    if (!enif_alloc_binary(size, &bin_)) {
+      throw std::bad_alloc();
+    }
+    owned_ = true;
+  }
+
+  ~OwnedBinary() {
+    if (owned_) {
+      enif_release_binary(&bin_);
+    }
+  }
+
+  OwnedBinary(OwnedBinary &&other) noexcept : bin_(other.bin_), owned_(other.owned_) {
+    other.owned_ = false;
+  }
+
+  OwnedBinary &operator=(OwnedBinary &&other) noexcept {
+    std::swap(bin_, other.bin_);
+    std::swap(owned_, other.owned_);
+    return *this;
+  }
+
+  OwnedBinary(const OwnedBinary &) = delete;
+  OwnedBinary &operator=(const OwnedBinary &) = delete;
+
+  explicit operator bool() const { return owned_; }
+  unsigned char *data() { return bin_.data; }
+  const unsigned char *data() const { return bin_.data; }
+  size_t size() const { return owned_ ? bin_.size : 0; }
+
+  // Hand the binary over to `env`
+  ERL_NIF_TERM release(ErlNifEnv *env) {
+    owned_ = false;
+    return enif_make_binary(env, &bin_);
+  }
+
+private:
+  ErlNifBinary bin_{};
+  bool owned_ = false;
+};
+
+// One result column as packed buffers
+struct PackedColumn {
+  std::string name;
+  const char *type = nullptr;  // Natch type name: "uint64", "string", "date", ...
+  size_t rows = 0;
+  int precision = -1;  // Sub-second digits of datetime64
+  OwnedBinary data;
+  OwnedBinary offsets;
+  OwnedBinary validity;
+};
+
+// Collects the non-empty blocks of a result for pack_blocks
+struct PackedCollector {
+  std::vector<clickhouse::Block> blocks;
+
+  void operator()(const clickhouse::Block &block) {
+    if (block.GetRowCount() > 0) {
+      blocks.push_back(block);
+    }
+  }
+};
+
+// Pack one column from its per-block parts (holding `rows` values in total).
+// Throws for column types without a packed layout.
+PackedColumn pack_parts(std::string name, std::vector<clickhouse::ColumnRef> parts, size_t rows);
+
+// Pack every column of `blocks` (which share one schema). Throws for column
+// types without a packed layout.
+std::vector<PackedColumn> pack_blocks(const std::vector<clickhouse::Block> &blocks);
+
+// %{column_name => %{type: atom, data: binary, ...}} for packed columns,
+// handing their buffers over to `env`
+ERL_NIF_TERM make_packed_result(ErlNifEnv *env, std::vector<PackedColumn> &columns);
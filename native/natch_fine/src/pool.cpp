@@ -0,0 +1,354 @@
+// pool.cpp - Native connection pool
+//
+// A PoolResource holds N client resources in fixed slots. Slots are
+// partitioned by scheduler (slot i belongs to partition i % partitions), and
+// the caller passes its scheduler id so checkouts from different schedulers
+// usually touch different slots. Checkout is lock-free: a slot is claimed by
+// a compare-and-swap on its claim token, first in the caller's own partition
+// and then by stealing from the others.
+//
+// Connections that failed are flagged on checkin and reset lazily: the next
+// checkout reports needs_reset and the caller runs client_reset_connection
+// (a dirty NIF) before using the client. pool_health_check pings idle slots
+// and reclaims slots whose owner process died without checking in, and
+// cancels the query the owner left running (see pool_watch).
+//
+// Each claim takes a fresh token, and a slot is only reclaimed by a CAS from
+// the token its dead owner was seen with, so a slot that was checked in and
+// claimed again in the meantime is left alone.
+//
+// A caller that finds every slot busy registers with pool_wait, tries once
+// more and otherwise waits for a :natch_pool_checkin message: each checkin
+// sends one to the longest waiting process. The waiter count is checked
+// after a release behind a fence that pairs with pool_wait's, so either the
+// checkin sees the new waiter or the waiter's retry sees the free slot.
+
+#include <fine.hpp>
+#include <clickhouse/client.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "client_resource.h"
+#include "query_control.h"
+
+using namespace clickhouse;
+
+struct PoolSlot {
+  // Held by the health check while it reclaims the slot
+  static constexpr uint64_t kReclaiming = UINT64_MAX;
+
+  fine::ResourcePtr<ClientResource> client;
+  std::atomic<bool> needs_reset{false};
+
+  // 0 while free, else the token of the claim holding the slot
+  std::atomic<uint64_t> token{0};
+  std::atomic<uint64_t> next_token{0};
+
+  // The process holding the claim owner_token, and the query it runs
+  std::mutex owner_mutex;
+  uint64_t owner_token = 0;
+  ErlNifPid owner;
+  std::optional<fine::ResourcePtr<QueryControl>> control;
+
+  explicit PoolSlot(fine::ResourcePtr<ClientResource> c) : client(c) {}
+
+  bool is_free() const { return token.load(std::memory_order_relaxed) == 0; }
+
+  // Returns the claim's token, or 0 if the slot is taken
+  uint64_t try_claim() {
+    uint64_t claim = next_token.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint64_t expected = 0;
+    return token.compare_exchange_strong(expected, claim, std::memory_order_acquire) ? claim : 0;
+  }
+
+  void set_owner(ErlNifEnv *env, uint64_t claim) {
+    std::lock_guard<std::mutex> lock(owner_mutex);
+    enif_self(env, &owner);
+    owner_token = claim;
+  }
+
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(owner_mutex);
+      owner_token = 0;
+      control.reset();
+    }
+    token.store(0, std::memory_order_release);
+  }
+
+  // Take over the slot if the process holding it has died. Cancels the
+  // query it left running, so the next claim doesn't wait behind it.
+  bool reclaim_if_dead(ErlNifEnv *env) {
+    uint64_t held = token.load(std::memory_order_acquire);
+    ErlNifPid dead;
+    std::optional<fine::ResourcePtr<QueryControl>> left_running;
+    {
+      std::lock_guard<std::mutex> lock(owner_mutex);
+      if (held == 0 || held == kReclaiming || owner_token != held) {
+        return false;
+      }
+      dead = owner;
+      left_running = control;
+    }
+
+    if (enif_is_process_alive(env, &dead) ||
+        !token.compare_exchange_strong(held, kReclaiming, std::memory_order_acq_rel)) {
+      return false;
+    }
+    if (left_running) {
+      (*left_running)->cancelled.store(true);
+    }
+    needs_reset.store(true, std::memory_order_relaxed);
+    release();
+    return true;
+  }
+};
+
+struct PoolResource {
+  // Slots hold atomics, so they are allocated individually and never move
+  std::vector<std::unique_ptr<PoolSlot>> slots;
+  size_t partitions;
+
+  // Processes waiting for a free slot, oldest first
+  std::mutex waiters_mutex;
+  std::deque<ErlNifPid> waiters;
+  std::atomic<size_t> waiter_count{0};
+
+  PoolResource(const std::vector<fine::ResourcePtr<ClientResource>> &clients, size_t parts)
+      : partitions(parts) {
+    slots.reserve(clients.size());
+    for (const auto &client : clients) {
+      slots.push_back(std::make_unique<PoolSlot>(client));
+    }
+  }
+
+  // Called after a slot is released: wakes the longest waiting process that
+  // is still alive
+  void notify(ErlNifEnv *env) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiter_count.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(waiters_mutex);
+    wake_one(env);
+  }
+
+  // Requires waiters_mutex
+  void wake_one(ErlNifEnv *env) {
+    while (!waiters.empty()) {
+      ErlNifPid pid = waiters.front();
+      waiters.pop_front();
+      waiter_count.fetch_sub(1, std::memory_order_relaxed);
+      if (enif_send(env, &pid, NULL, enif_make_atom(env, "natch_pool_checkin"))) {
+        return;
+      }
+    }
+  }
+};
+
+FINE_RESOURCE(PoolResource);
+
+// ============================================================================
+// Pool NIFs
+// ============================================================================
+
+/// Creates a pool from already connected clients
+///
+/// @param clients Client resources, one per slot
+/// @param partitions Number of checkout partitions (usually schedulers online)
+fine::ResourcePtr<PoolResource> pool_create(
+    ErlNifEnv *env,
+    std::vector<fine::ResourcePtr<ClientResource>> clients,
+    uint64_t partitions) {
+  if (clients.empty()) {
+    throw std::invalid_argument("Pool needs at least one client");
+  }
+  if (partitions == 0) {
+    throw std::invalid_argument("Pool needs at least one partition");
+  }
+  return fine::make_resource<PoolResource>(clients, partitions);
+}
+FINE_NIF(pool_create, 0);
+
+/// Claims a free slot, preferring the caller's scheduler partition
+///
+/// @return {index, client, needs_reset}, or nil when every slot is busy
+std::optional<std::tuple<uint64_t, fine::ResourcePtr<ClientResource>, bool>> pool_checkout(
+    ErlNifEnv *env,
+    fine::ResourcePtr<PoolResource> pool,
+    uint64_t scheduler_id) {
+  size_t slot_count = pool->slots.size();
+  size_t partitions = std::min(pool->partitions, slot_count);
+  size_t home = scheduler_id % partitions;
+
+  for (size_t p = 0; p < partitions; p++) {
+    size_t partition = (home + p) % partitions;
+
+    for (size_t i = partition; i < slot_count; i += partitions) {
+      PoolSlot &slot = *pool->slots[i];
+
+      uint64_t claim;
+      if (slot.is_free() && (claim = slot.try_claim()) != 0) {
+        slot.set_owner(env, claim);
+
+        bool needs_reset = slot.needs_reset.exchange(false, std::memory_order_acq_rel);
+        return std::make_tuple(static_cast<uint64_t>(i), slot.client, needs_reset);
+      }
+    }
+  }
+
+  return std::nullopt;
+}
+FINE_NIF(pool_checkout, 0);
+
+/// Returns a slot; unhealthy connections are reset on their next checkout
+fine::Atom pool_checkin(
+    ErlNifEnv *env,
+    fine::ResourcePtr<PoolResource> pool,
+    uint64_t index,
+    bool healthy) {
+  if (index >= pool->slots.size()) {
+    throw std::invalid_argument("Pool slot index out of range");
+  }
+
+  PoolSlot &slot = *pool->slots[index];
+  if (!healthy) {
+    slot.needs_reset.store(true, std::memory_order_relaxed);
+  }
+  slot.release();
+  pool->notify(env);
+  return fine::Atom("ok");
+}
+FINE_NIF(pool_checkin, 0);
+
+/// Records the control of the query the caller runs on its slot, so the
+/// health check can cancel it if the caller dies
+fine::Atom pool_watch(
+    ErlNifEnv *env,
+    fine::ResourcePtr<PoolResource> pool,
+    uint64_t index,
+    fine::ResourcePtr<QueryControl> control) {
+  if (index >= pool->slots.size()) {
+    throw std::invalid_argument("Pool slot index out of range");
+  }
+
+  PoolSlot &slot = *pool->slots[index];
+  ErlNifPid self;
+  enif_self(env, &self);
+
+  std::lock_guard<std::mutex> lock(slot.owner_mutex);
+  if (slot.owner_token != 0 && enif_compare_pids(&slot.owner, &self) == 0) {
+    slot.control = control;
+  }
+  return fine::Atom("ok");
+}
+FINE_NIF(pool_watch, 0);
+
+/// Registers the caller to receive :natch_pool_checkin at the next checkin.
+/// The caller must retry pool_checkout afterwards, as a slot may have been
+/// released just before.
+fine::Atom pool_wait(
+    ErlNifEnv *env,
+    fine::ResourcePtr<PoolResource> pool) {
+  ErlNifPid self;
+  enif_self(env, &self);
+  {
+    std::lock_guard<std::mutex> lock(pool->waiters_mutex);
+    pool->waiters.push_back(self);
+    pool->waiter_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return fine::Atom("ok");
+}
+FINE_NIF(pool_wait, 0);
+
+/// Withdraws the caller's pool_wait, for a caller that got a slot anyway or
+/// gave up
+///
+/// @return false if a checkin already woke the caller: the wake is passed on
+///   to the next waiter and the caller's :natch_pool_checkin message must be
+///   flushed
+bool pool_unwait(
+    ErlNifEnv *env,
+    fine::ResourcePtr<PoolResource> pool) {
+  ErlNifPid self;
+  enif_self(env, &self);
+
+  std::lock_guard<std::mutex> lock(pool->waiters_mutex);
+  auto &waiters = pool->waiters;
+  auto it = std::find_if(waiters.begin(), waiters.end(), [&](const ErlNifPid &pid) {
+    return enif_compare_pids(&pid, &self) == 0;
+  });
+  if (it != waiters.end()) {
+    waiters.erase(it);
+    pool->waiter_count.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  pool->wake_one(env);
+  return false;
+}
+FINE_NIF(pool_unwait, 0);
+
+/// Pings every idle connection, resetting the ones that fail, and reclaims
+/// slots held by dead processes
+///
+/// @return Number of connections that are still unhealthy
+uint64_t pool_health_check(
+    ErlNifEnv *env,
+    fine::ResourcePtr<PoolResource> pool) {
+  uint64_t unhealthy = 0;
+
+  for (auto &slot_ptr : pool->slots) {
+    PoolSlot &slot = *slot_ptr;
+
+    if (!slot.try_claim()) {
+      // The owner may have been killed mid-query; the client lock keeps the
+      // still-running job and the next user apart, and the reset cleans up
+      if (slot.reclaim_if_dead(env)) {
+        pool->notify(env);
+      }
+      continue;
+    }
+
+    bool healthy = true;
+    try {
+      if (slot.needs_reset.load(std::memory_order_relaxed)) {
+        slot.client->locked()->ResetConnection();
+      }
+      slot.client->locked()->Ping();
+    } catch (const std::exception &) {
+      try {
+        slot.client->locked()->ResetConnection();
+        slot.client->locked()->Ping();
+      } catch (const std::exception &) {
+        healthy = false;
+        unhealthy++;
+      }
+    }
+
+    slot.needs_reset.store(!healthy, std::memory_order_relaxed);
+    slot.release();
+    pool->notify(env);
+  }
+
+  return unhealthy;
+}
+FINE_NIF(pool_health_check, ERL_NIF_DIRTY_JOB_IO_BOUND);
+
+/// Number of slots in the pool
+uint64_t pool_size(
+    ErlNifEnv *env,
+    fine::ResourcePtr<PoolResource> pool) {
+  return pool->slots.size();
+}
+FINE_NIF(pool_size, 0);
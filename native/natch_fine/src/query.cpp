@@ -9,14 +9,36 @@
 
 #include <fine.hpp>
 #include <clickhouse/query.h>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 using namespace clickhouse;
 
 // Wrap Query as a FINE resource
 FINE_RESOURCE(Query);
 
+namespace {
+
+// Numbers are formatted with std::to_chars: no locale, no allocation beyond
+// the result, and floats in their shortest round-trip form (std::to_string
+// rounded them to six decimals)
+template <typename T>
+std::string to_chars_string(T value) {
+  char buf[64];
+  auto result = std::to_chars(buf, buf + sizeof(buf), value);
+  return std::string(buf, result.ptr);
+}
+
+}  // namespace
+
 // ============================================================================
 // Query Creation
 // ============================================================================
@@ -49,7 +71,7 @@ fine::Atom query_bind_uint64(
     std::string name,
     uint64_t value) {
   try {
-    query->SetParam(name, std::to_string(value));
+    query->SetParam(name, to_chars_string(value));
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(std::string("Failed to bind UInt64 parameter '") + name + "': " + e.what());
@@ -64,7 +86,7 @@ fine::Atom query_bind_int64(
     std::string name,
     int64_t value) {
   try {
-    query->SetParam(name, std::to_string(value));
+    query->SetParam(name, to_chars_string(value));
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(std::string("Failed to bind Int64 parameter '") + name + "': " + e.what());
@@ -79,7 +101,7 @@ fine::Atom query_bind_int32(
     std::string name,
     int64_t value) {
   try {
-    query->SetParam(name, std::to_string(value));
+    query->SetParam(name, to_chars_string(value));
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(std::string("Failed to bind Int32 parameter '") + name + "': " + e.what());
@@ -94,7 +116,7 @@ fine::Atom query_bind_uint32(
     std::string name,
     int64_t value) {
   try {
-    query->SetParam(name, std::to_string(value));
+    query->SetParam(name, to_chars_string(value));
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(std::string("Failed to bind UInt32 parameter '") + name + "': " + e.what());
@@ -113,7 +135,7 @@ fine::Atom query_bind_float64(
     std::string name,
     double value) {
   try {
-    query->SetParam(name, std::to_string(value));
+    query->SetParam(name, to_chars_string(value));
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(std::string("Failed to bind Float64 parameter '") + name + "': " + e.what());
@@ -130,7 +152,7 @@ fine::Atom query_bind_float32(
   try {
     // Convert to float precision then back to string
     float float_val = static_cast<float>(value);
-    query->SetParam(name, std::to_string(float_val));
+    query->SetParam(name, to_chars_string(float_val));
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(std::string("Failed to bind Float32 parameter '") + name + "': " + e.what());
@@ -168,7 +190,7 @@ fine::Atom query_bind_datetime(
     std::string name,
     int64_t timestamp) {
   try {
-    query->SetParam(name, std::to_string(timestamp));
+    query->SetParam(name, to_chars_string(timestamp));
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(std::string("Failed to bind DateTime parameter '") + name + "': " + e.what());
@@ -184,7 +206,7 @@ fine::Atom query_bind_date(
     std::string name,
     int64_t days) {
   try {
-    query->SetParam(name, std::to_string(days));
+    query->SetParam(name, to_chars_string(days));
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(std::string("Failed to bind Date parameter '") + name + "': " + e.what());
@@ -199,7 +221,7 @@ fine::Atom query_bind_datetime64(
     std::string name,
     int64_t microseconds) {
   try {
-    query->SetParam(name, std::to_string(microseconds));
+    query->SetParam(name, to_chars_string(microseconds));
     return fine::Atom("ok");
   } catch (const std::exception& e) {
     throw std::runtime_error(std::string("Failed to bind DateTime64 parameter '") + name + "': " + e.what());
@@ -225,3 +247,251 @@ fine::Atom query_bind_null(
   }
 }
 FINE_NIF(query_bind_null, 0);
+
+// ============================================================================
+// Query Templates
+// ============================================================================
+//
+// A template parses the placeholders of its SQL once into numbered slots.
+// Binding formats one value per slot into a slot-indexed vector and applies
+// it to a fresh copy of the template's unbound Query, so every binding is a
+// Query of its own: the template is never mutated, and a binding can be
+// executed (or cached) while the same template is bound again elsewhere.
+
+struct QueryTemplate {
+  Query base;                      // Unbound query each binding copies
+  std::vector<std::string> names;  // Parameter name of each slot
+  std::vector<std::string> types;  // ClickHouse type of each slot
+  std::vector<bool> float32;       // Float values are rounded to single precision
+
+  QueryTemplate(
+      const std::string &sql,
+      std::vector<std::pair<std::string, std::string>> slots)
+      : base(sql) {
+    for (auto &[name, type] : slots) {
+      float32.push_back(type == "Float32" || type == "Nullable(Float32)");
+      names.push_back(std::move(name));
+      types.push_back(std::move(type));
+    }
+  }
+};
+FINE_RESOURCE(QueryTemplate);
+
+namespace {
+
+std::string trim(std::string_view s) {
+  size_t start = s.find_first_not_of(" \t\n\r");
+  if (start == std::string_view::npos) {
+    return std::string();
+  }
+  size_t end = s.find_last_not_of(" \t\n\r");
+  return std::string(s.substr(start, end - start + 1));
+}
+
+// The {name:Type} placeholders of `sql` in order of first appearance.
+// Braces inside quoted literals and identifiers are not placeholders.
+std::vector<std::pair<std::string, std::string>> parse_placeholders(const std::string &sql) {
+  std::vector<std::pair<std::string, std::string>> slots;
+  std::unordered_set<std::string> seen;
+  size_t n = sql.size();
+
+  for (size_t i = 0; i < n; i++) {
+    char c = sql[i];
+    if (c == '\'' || c == '"' || c == '`') {
+      for (i++; i < n && sql[i] != c; i++) {
+        if (sql[i] == '\\') {
+          i++;
+        }
+      }
+      continue;
+    }
+    if (c != '{') {
+      continue;
+    }
+
+    size_t close = sql.find('}', i);
+    size_t colon = sql.find(':', i);
+    if (close == std::string::npos || colon == std::string::npos || colon > close) {
+      continue;
+    }
+
+    std::string name = trim(std::string_view(sql).substr(i + 1, colon - i - 1));
+    std::string type = trim(std::string_view(sql).substr(colon + 1, close - colon - 1));
+    if (!name.empty() && !type.empty() && seen.insert(name).second) {
+      slots.emplace_back(std::move(name), std::move(type));
+    }
+    i = close;
+  }
+
+  return slots;
+}
+
+// Text sent for a parameter value term: integers and floats are formatted
+// with std::to_chars (floats in their shortest round-trip form), binaries
+// are sent as-is and nil is NULL
+QueryParamValue format_param_value(ErlNifEnv *env, ERL_NIF_TERM term, bool float32) {
+  ErlNifSInt64 i;
+  if (enif_get_int64(env, term, &i)) {
+    return to_chars_string(static_cast<int64_t>(i));
+  }
+
+  ErlNifUInt64 u;
+  if (enif_get_uint64(env, term, &u)) {
+    return to_chars_string(static_cast<uint64_t>(u));
+  }
+
+  double d;
+  if (enif_get_double(env, term, &d)) {
+    return float32 ? to_chars_string(static_cast<float>(d)) : to_chars_string(d);
+  }
+
+  ErlNifBinary bin;
+  if (enif_inspect_binary(env, term, &bin)) {
+    return std::string(reinterpret_cast<const char *>(bin.data), bin.size);
+  }
+
+  char atom[4];
+  if (enif_get_atom(env, term, atom, sizeof(atom), ERL_NIF_LATIN1) &&
+      std::strcmp(atom, "nil") == 0) {
+    return QueryParamValue();
+  }
+
+  throw std::invalid_argument("unsupported value (expected an integer, float, binary or nil)");
+}
+
+}  // namespace
+
+/// Creates a template from SQL with {name:Type} placeholders
+///
+/// @return {template, query, [{name, type}]}: the Query is an unbound query
+///   of the same SQL, for binding by name
+std::tuple<
+    fine::ResourcePtr<QueryTemplate>,
+    fine::ResourcePtr<Query>,
+    std::vector<std::tuple<std::string, std::string>>>
+query_template_create(ErlNifEnv *env, std::string sql) {
+  auto tmpl = fine::make_resource<QueryTemplate>(sql, parse_placeholders(sql));
+  auto query = fine::make_resource<Query>(sql);
+
+  std::vector<std::tuple<std::string, std::string>> slots;
+  for (size_t slot = 0; slot < tmpl->names.size(); slot++) {
+    slots.emplace_back(tmpl->names[slot], tmpl->types[slot]);
+  }
+  return {tmpl, query, slots};
+}
+FINE_NIF(query_template_create, 0);
+
+/// Binds one value per slot, in slot order
+///
+/// Every value is formatted before any is applied, so a value that can't be
+/// bound leaves nothing half-bound behind.
+///
+/// @return A new Query: the template's unbound Query with the values bound
+fine::ResourcePtr<Query> query_template_bind(
+    ErlNifEnv *env,
+    fine::ResourcePtr<QueryTemplate> tmpl,
+    std::vector<fine::Term> values) {
+  if (values.size() != tmpl->names.size()) {
+    throw std::invalid_argument(
+        "Expected " + std::to_string(tmpl->names.size()) + " parameter values, got " +
+        std::to_string(values.size()));
+  }
+
+  std::vector<QueryParamValue> bound;
+  bound.reserve(values.size());
+  for (size_t slot = 0; slot < values.size(); slot++) {
+    try {
+      bound.push_back(format_param_value(env, values[slot], tmpl->float32[slot]));
+    } catch (const std::exception &e) {
+      throw std::invalid_argument(
+          "Failed to bind " + tmpl->types[slot] + " parameter '" + tmpl->names[slot] +
+          "': " + e.what());
+    }
+  }
+
+  auto query = fine::make_resource<Query>(tmpl->base);
+  for (size_t slot = 0; slot < bound.size(); slot++) {
+    query->SetParam(tmpl->names[slot], std::move(bound[slot]));
+  }
+  return query;
+}
+FINE_NIF(query_template_bind, 0);
+
+// ============================================================================
+// Batch Binding
+// ============================================================================
+
+namespace {
+
+std::string param_name(ErlNifEnv *env, ERL_NIF_TERM key) {
+  unsigned length;
+  if (enif_get_atom_length(env, key, &length, ERL_NIF_LATIN1)) {
+    std::string name(length + 1, '\0');
+    enif_get_atom(env, key, name.data(), length + 1, ERL_NIF_LATIN1);
+    name.resize(length);
+    return name;
+  }
+
+  ErlNifBinary bin;
+  if (enif_inspect_binary(env, key, &bin)) {
+    return std::string(reinterpret_cast<const char *>(bin.data), bin.size);
+  }
+
+  throw std::invalid_argument("Parameter names must be atoms or strings");
+}
+
+void bind_param(ErlNifEnv *env, Query &query, ERL_NIF_TERM key, ERL_NIF_TERM value) {
+  std::string name = param_name(env, key);
+  try {
+    query.SetParam(name, format_param_value(env, value, false));
+  } catch (const std::exception &e) {
+    throw std::invalid_argument("Failed to bind parameter '" + name + "': " + e.what());
+  }
+}
+
+}  // namespace
+
+/// Binds every parameter of a keyword list or map in one call
+///
+/// Names are atoms or strings. Values are integers, floats, binaries or nil
+/// (NULL), formatted as for query templates.
+fine::Atom query_bind_all(
+    ErlNifEnv *env,
+    fine::ResourcePtr<Query> query,
+    fine::Term params) {
+  if (enif_is_map(env, params)) {
+    ErlNifMapIterator it;
+    enif_map_iterator_create(env, params, &it, ERL_NIF_MAP_ITERATOR_FIRST);
+
+    try {
+      ERL_NIF_TERM key, value;
+      while (enif_map_iterator_get_pair(env, &it, &key, &value)) {
+        bind_param(env, *query, key, value);
+        enif_map_iterator_next(env, &it);
+      }
+    } catch (...) {
+      enif_map_iterator_destroy(env, &it);
+      throw;
+    }
+
+    enif_map_iterator_destroy(env, &it);
+    return fine::Atom("ok");
+  }
+
+  ERL_NIF_TERM list = params;
+  ERL_NIF_TERM head;
+  while (enif_get_list_cell(env, list, &head, &list)) {
+    int arity;
+    const ERL_NIF_TERM *pair;
+    if (!enif_get_tuple(env, head, &arity, &pair) || arity != 2) {
+      throw std::invalid_argument("Parameters must be {name, value} pairs");
+    }
+    bind_param(env, *query, pair[0], pair[1]);
+  }
+
+  if (!enif_is_empty_list(env, list)) {
+    throw std::invalid_argument("Parameters must be a keyword list or map");
+  }
+  return fine::Atom("ok");
+}
+FINE_NIF(query_bind_all, 0);
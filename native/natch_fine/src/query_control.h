@@ -0,0 +1,166 @@
+#pragma once
+
+#include <fine.hpp>
+#include <clickhouse/client.h>
+#include <clickhouse/query.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "query_stats.h"
+
+// Cancellation and deadlines of async queries
+//
+// The connection creates one QueryControl per query; any process holding it
+// can cancel the query, and it carries the query's deadline. clickhouse-cpp
+// has no way to write the Cancel packet while another thread is inside
+// Select, so the worker polls the control instead:
+//
+//   - when a data block arrives after the query should stop, the block
+//     callback returns false, clickhouse-cpp sends Cancel and drains the
+//     connection up to EndOfStream
+//   - when a progress packet arrives (the server sends one every
+//     interactive_delay, 100ms by default, while it is still working), the
+//     receive is aborted and the job resets the connection
+//
+// Either way the Client stays usable, the blocks collected so far are freed
+// without being converted to terms, and the caller gets
+// {:error, :cancelled} or {:error, :timeout}.
+//
+// The control also carries the codec the server should compress the query's
+// result with. The client only tells the server whether it accepts
+// compressed data; the codec and ZSTD level are query settings, so they can
+// change from one query to the next without reconnecting.
+
+struct QueryControl {
+  using clock = std::chrono::steady_clock;
+
+  std::atomic<bool> cancelled{false};
+  clock::time_point deadline;
+
+  // "lz4" or "zstd", empty to keep the server's network_compression_method
+  std::string network_codec;
+  uint64_t zstd_level;
+
+  // A timeout of 0 means no deadline
+  explicit QueryControl(uint64_t timeout_ms, std::string network_codec = "", uint64_t zstd_level = 0)
+      : deadline(timeout_ms == 0 ? clock::time_point::max()
+                                 : clock::now() + std::chrono::milliseconds(timeout_ms)),
+        network_codec(std::move(network_codec)), zstd_level(zstd_level) {}
+
+  bool expired() const { return clock::now() >= deadline; }
+  bool should_stop() const { return cancelled.load(std::memory_order_relaxed) || expired(); }
+
+  void apply_codec(clickhouse::Query &query) const {
+    if (network_codec.empty()) {
+      return;
+    }
+    query.SetSetting("network_compression_method", clickhouse::QuerySettingsField{network_codec, 0});
+    if (network_codec == "zstd") {
+      query.SetSetting("network_zstd_compression_level",
+                       clickhouse::QuerySettingsField{std::to_string(zstd_level), 0});
+    }
+  }
+};
+
+// Thrown by a job whose control stopped it
+class QueryStopped : public std::runtime_error {
+public:
+  QueryStopped(bool timed_out, bool interrupted)
+      : std::runtime_error(timed_out ? "Query deadline exceeded" : "Query cancelled"),
+        timed_out(timed_out), interrupted(interrupted) {}
+
+  // Stopped by the deadline rather than by cancel
+  bool timed_out;
+  // Aborted mid-receive, so the connection must be reset
+  bool interrupted;
+};
+
+inline std::string encode_query_stopped(const QueryStopped &e) {
+  return std::string("{\"type\":\"") + (e.timed_out ? "timeout" : "cancelled") +
+         "\",\"message\":\"" + e.what() + "\"}";
+}
+
+namespace query_control_detail {
+
+// Count the server's Progress and Profile packets into `stats`, aborting at
+// the first progress packet after `control` says stop
+inline void watch_packets(
+    clickhouse::Query &query,
+    const QueryControl &control,
+    QueryStats &stats) {
+  query.OnProgress([&control, &stats](const clickhouse::Progress &progress) {
+    stats.on_progress(progress);
+    if (control.should_stop()) {
+      throw QueryStopped(!control.cancelled.load(), true);
+    }
+  });
+  query.OnProfile([&stats](const clickhouse::Profile &profile) { stats.on_profile(profile); });
+}
+
+} // namespace query_control_detail
+
+// Run a SELECT, passing each block to `on_block` until `control` stops it.
+// An `on_block` returning bool can also end the query early by returning
+// false, which isn't an error unless `control` says stop by then.
+//
+// `query` is taken by value: the callbacks and codec settings go on this
+// run's own copy, never on a Query resource other jobs may be running.
+template <typename OnBlock>
+void select_controlled(
+    clickhouse::Client &client,
+    clickhouse::Query query,
+    const QueryControl &control,
+    QueryStats &stats,
+    OnBlock &&on_block) {
+  bool stopped = false;
+  control.apply_codec(query);
+  auto start = QueryStats::clock::now();
+
+  query.OnData(nullptr);
+  query.OnDataCancelable([&](const clickhouse::Block &block) {
+    if (control.should_stop()) {
+      stopped = true;
+      return false;
+    }
+    stats.on_block(block, start);
+    if constexpr (std::is_same_v<std::invoke_result_t<OnBlock &, const clickhouse::Block &>, bool>) {
+      if (!on_block(block)) {
+        stopped = control.should_stop();
+        return false;
+      }
+    } else {
+      on_block(block);
+    }
+    return true;
+  });
+  query_control_detail::watch_packets(query, control, stats);
+
+  {
+    ScopedTimer timer(stats.receive_ns);
+    client.Select(query);
+  }
+
+  if (stopped) {
+    throw QueryStopped(!control.cancelled.load(), false);
+  }
+}
+
+// Run DDL/DML until `control` stops it, on a copy of `query` like
+// select_controlled
+inline void execute_controlled(
+    clickhouse::Client &client,
+    clickhouse::Query query,
+    const QueryControl &control,
+    QueryStats &stats) {
+  query.OnData(nullptr);
+  control.apply_codec(query);
+  query_control_detail::watch_packets(query, control, stats);
+
+  ScopedTimer timer(stats.receive_ns);
+  client.Execute(query);
+}
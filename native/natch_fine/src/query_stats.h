@@ -0,0 +1,152 @@
+#pragma once
+
+#include <fine.hpp>
+#include <clickhouse/block.h>
+#include <clickhouse/query.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Counters of one query, filled in by the job running it and sent back with
+// its result (see async.cpp). Natch.Connection emits them as the
+// measurements of its [:natch, :query, :stop] telemetry event.
+//
+// The time inside Client::Select (receive_ns) covers server execution,
+// network receive, LZ4/ZSTD decompression and column parsing; clickhouse-cpp
+// doesn't expose where one ends and the next begins. first_block_ns, the
+// time until the first data block, approximates the server's share.
+// decode_ns is everything after the query finished: term construction for
+// row and column results, buffer packing for packed and Arrow results.
+struct QueryStats {
+  using clock = std::chrono::steady_clock;
+
+  uint64_t blocks = 0;
+  uint64_t rows = 0;
+
+  // Sums of the server's Progress packets
+  uint64_t progress_packets = 0;
+  uint64_t read_rows = 0;
+  uint64_t read_bytes = 0;
+  uint64_t written_rows = 0;
+  uint64_t written_bytes = 0;
+
+  // From the server's Profile packet; result_bytes is the uncompressed size
+  // of the result blocks
+  uint64_t profile_packets = 0;
+  uint64_t result_bytes = 0;
+  uint64_t rows_before_limit = 0;
+
+  uint64_t first_block_ns = 0;
+  uint64_t receive_ns = 0;
+  uint64_t decode_ns = 0;
+
+  // Estimated heap size of the result terms: list cells and maps plus boxed
+  // values (floats, binaries)
+  uint64_t term_bytes = 0;
+
+  // Term construction time per column type, e.g. "Nullable(String)"
+  std::map<std::string, uint64_t> decode_ns_by_type;
+
+  static uint64_t since(clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+  }
+
+  void on_progress(const clickhouse::Progress &progress) {
+    progress_packets++;
+    read_rows += progress.rows;
+    read_bytes += progress.bytes;
+    written_rows += progress.written_rows;
+    written_bytes += progress.written_bytes;
+  }
+
+  void on_profile(const clickhouse::Profile &profile) {
+    profile_packets++;
+    result_bytes += profile.bytes;
+    rows_before_limit = profile.rows_before_limit;
+  }
+
+  // Called for every data block, `start` being when the query was sent. The
+  // empty header block the server sends first isn't counted.
+  void on_block(const clickhouse::Block &block, clock::time_point start) {
+    if (block.GetRowCount() == 0) {
+      return;
+    }
+    if (blocks == 0) {
+      first_block_ns = since(start);
+    }
+    blocks++;
+    rows += block.GetRowCount();
+  }
+
+  // Fold in the counters of a query run alongside this one, on another
+  // connection (see cluster.cpp): totals add up, while receive_ns is the
+  // slowest receive and first_block_ns the earliest first block
+  void merge(const QueryStats &other) {
+    if (other.blocks > 0 && (blocks == 0 || other.first_block_ns < first_block_ns)) {
+      first_block_ns = other.first_block_ns;
+    }
+    blocks += other.blocks;
+    rows += other.rows;
+    progress_packets += other.progress_packets;
+    read_rows += other.read_rows;
+    read_bytes += other.read_bytes;
+    written_rows += other.written_rows;
+    written_bytes += other.written_bytes;
+    profile_packets += other.profile_packets;
+    result_bytes += other.result_bytes;
+    rows_before_limit += other.rows_before_limit;
+    receive_ns = std::max(receive_ns, other.receive_ns);
+  }
+
+  ERL_NIF_TERM to_term(ErlNifEnv *env) const {
+    ERL_NIF_TERM by_type = enif_make_new_map(env);
+    for (const auto &[type, ns] : decode_ns_by_type) {
+      enif_make_map_put(env, by_type, fine::encode(env, type), enif_make_uint64(env, ns), &by_type);
+    }
+
+    const std::pair<const char *, uint64_t> counters[] = {
+        {"blocks", blocks},
+        {"rows", rows},
+        {"progress_packets", progress_packets},
+        {"read_rows", read_rows},
+        {"read_bytes", read_bytes},
+        {"written_rows", written_rows},
+        {"written_bytes", written_bytes},
+        {"profile_packets", profile_packets},
+        {"result_bytes", result_bytes},
+        {"rows_before_limit", rows_before_limit},
+        {"first_block_ns", first_block_ns},
+        {"receive_ns", receive_ns},
+        {"decode_ns", decode_ns},
+        {"term_bytes", term_bytes},
+    };
+
+    ERL_NIF_TERM map = enif_make_new_map(env);
+    for (const auto &[key, value] : counters) {
+      enif_make_map_put(env, map, enif_make_atom(env, key), enif_make_uint64(env, value), &map);
+    }
+    enif_make_map_put(env, map, enif_make_atom(env, "decode_ns_by_type"), by_type, &map);
+    return map;
+  }
+
+  // {result, stats}, the reply of an instrumented job
+  ERL_NIF_TERM with_result(ErlNifEnv *env, ERL_NIF_TERM result) const {
+    return enif_make_tuple2(env, result, to_term(env));
+  }
+};
+
+// Adds the time from construction to destruction to `ns`
+class ScopedTimer {
+public:
+  explicit ScopedTimer(uint64_t &ns) : ns_(ns), start_(QueryStats::clock::now()) {}
+  ~ScopedTimer() { ns_ += QueryStats::since(start_); }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  uint64_t &ns_;
+  QueryStats::clock::time_point start_;
+};
@@ -18,1430 +18,809 @@
 #include <memory>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <unordered_map>
+
+#include "array_access.h"
+#include "client_resource.h"
+#include "columnar.h"
+#include "decode_pool.h"
+#include "term_scratch.h"
 
 using namespace clickhouse;
 
-// Forward declaration
-ERL_NIF_TERM column_to_elixir_list(ErlNifEnv *env, ColumnRef col);
-
-// Helper to format UUID to string (much faster than ostringstream)
-inline void format_uuid_to_buffer(const UUID& uuid, char* buffer) {
-  uint64_t high = uuid.first;
-  uint64_t low = uuid.second;
-  snprintf(buffer, 37,  // 36 chars + null terminator
-           "%08llx-%04llx-%04llx-%04llx-%012llx",
-           (unsigned long long)((high >> 32) & 0xFFFFFFFF),
-           (unsigned long long)((high >> 16) & 0xFFFF),
-           (unsigned long long)(high & 0xFFFF),
-           (unsigned long long)((low >> 48) & 0xFFFF),
-           (unsigned long long)(low & 0xFFFFFFFFFFFF));
+// Lowercase hex digits of every byte value, two characters per entry
+constexpr std::array<char, 512> kHexPairs = [] {
+  std::array<char, 512> table{};
+  const char *digits = "0123456789abcdef";
+  for (int i = 0; i < 256; i++) {
+    table[2 * i] = digits[i >> 4];
+    table[2 * i + 1] = digits[i & 15];
+  }
+  return table;
+}();
+
+// Write the 36 characters of a UUID's canonical form to `buffer`, one table
+// lookup per byte (snprintf parsed its format string for every value)
+inline void format_uuid_to_buffer(const UUID &uuid, char *buffer) {
+  // Bytes are taken most significant first, high half then low half, with
+  // dashes before bytes 4, 6, 8 and 10
+  uint64_t halves[2] = {uuid.first, uuid.second};
+  char *out = buffer;
+  for (int byte = 0; byte < 16; byte++) {
+    if (byte == 4 || byte == 6 || byte == 8 || byte == 10) {
+      *out++ = '-';
+    }
+    unsigned value = (halves[byte / 8] >> (56 - 8 * (byte % 8))) & 0xFF;
+    *out++ = kHexPairs[2 * value];
+    *out++ = kHexPairs[2 * value + 1];
+  }
 }
 
-// Helper to recursively convert a column to an Elixir list
-// This handles all column types including nested arrays
-ERL_NIF_TERM column_to_elixir_list(ErlNifEnv *env, ColumnRef col) {
-  size_t count = col->Size();
-  std::vector<ERL_NIF_TERM> values;
-  values.reserve(count);
-
-  // Optimized: Use Type::Code for O(1) type dispatch instead of cascade of As<T>() calls
-  Type::Code type_code = col->GetType().GetCode();
-
-  switch (type_code) {
-  case Type::UInt64: {
-    auto uint64_col = col->As<ColumnUInt64>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_uint64(env, uint64_col->At(i)));
-    }
-    break;
-  }
-  case Type::UInt32: {
-    auto uint32_col = col->As<ColumnUInt32>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_uint64(env, uint32_col->At(i)));
-    }
-    break;
-  }
-  case Type::UInt16: {
-    auto uint16_col = col->As<ColumnUInt16>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_uint64(env, uint16_col->At(i)));
-    }
-    break;
-  }
-  case Type::UInt8: {
-    auto uint8_col = col->As<ColumnUInt8>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_uint64(env, uint8_col->At(i)));
-    }
-    break;
-  }
-  case Type::Int64: {
-    auto int64_col = col->As<ColumnInt64>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_int64(env, int64_col->At(i)));
-    }
-    break;
-  }
-  case Type::Int32: {
-    auto int32_col = col->As<ColumnInt32>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_int64(env, int32_col->At(i)));
-    }
-    break;
-  }
-  case Type::Int16: {
-    auto int16_col = col->As<ColumnInt16>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_int64(env, int16_col->At(i)));
-    }
-    break;
-  }
-  case Type::Int8: {
-    auto int8_col = col->As<ColumnInt8>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_int64(env, int8_col->At(i)));
-    }
-    break;
-  }
-  case Type::Float64: {
-    auto float64_col = col->As<ColumnFloat64>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_double(env, float64_col->At(i)));
-    }
-    break;
-  }
-  case Type::Float32: {
-    auto float32_col = col->As<ColumnFloat32>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_double(env, float32_col->At(i)));
-    }
-    break;
-  }
-  case Type::String: {
-    auto string_col = col->As<ColumnString>();
+// Append one term per row of a String column, with nil for rows that
+// `nulls` marks as NULL. By default every value gets its own binary. With
+// opts.sub_binary_strings the column is copied once into a single binary and
+// each value is a sub-binary of it, replacing one allocation per row with
+// one per column per block.
+void append_string_terms(
+    ErlNifEnv *env,
+    const ColumnString &col,
+    const ColumnNullable *nulls,
+    const DecodeOptions &opts,
+    std::vector<ERL_NIF_TERM> &out) {
+  size_t count = col.Size();
+  ERL_NIF_TERM nil = enif_make_atom(env, "nil");
+
+  if (!opts.sub_binary_strings) {
     for (size_t i = 0; i < count; i++) {
-      std::string_view val_view = string_col->At(i);
+      if (nulls && nulls->IsNull(i)) {
+        out.push_back(nil);
+        continue;
+      }
+      std::string_view val_view = col.At(i);
       ErlNifBinary bin;
       enif_alloc_binary(val_view.size(), &bin);
       std::memcpy(bin.data, val_view.data(), val_view.size());
-      values.push_back(enif_make_binary(env, &bin));
+      out.push_back(enif_make_binary(env, &bin));
     }
-    break;
+    return;
   }
-  case Type::DateTime: {
-    auto datetime_col = col->As<ColumnDateTime>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_uint64(env, datetime_col->At(i)));
-    }
-    break;
-  }
-  case Type::DateTime64: {
-    auto datetime64_col = col->As<ColumnDateTime64>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_int64(env, datetime64_col->At(i)));
+
+  size_t total_size = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!(nulls && nulls->IsNull(i))) {
+      total_size += col.At(i).size();
     }
-    break;
   }
-  case Type::Date: {
-    auto date_col = col->As<ColumnDate>();
-    for (size_t i = 0; i < count; i++) {
-      values.push_back(enif_make_uint64(env, date_col->RawAt(i)));
+
+  ERL_NIF_TERM payload;
+  unsigned char *data = enif_make_new_binary(env, total_size, &payload);
+  size_t offset = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    if (nulls && nulls->IsNull(i)) {
+      out.push_back(nil);
+      continue;
     }
-    break;
+    std::string_view val_view = col.At(i);
+    std::memcpy(data + offset, val_view.data(), val_view.size());
+    out.push_back(enif_make_sub_binary(env, payload, offset, val_view.size()));
+    offset += val_view.size();
   }
-  case Type::UUID: {
-    auto uuid_col = col->As<ColumnUUID>();
-    for (size_t i = 0; i < count; i++) {
-      UUID uuid = uuid_col->At(i);
-      char uuid_buf[37];
-      format_uuid_to_buffer(uuid, uuid_buf);
-      ErlNifBinary bin;
-      enif_alloc_binary(36, &bin);
-      std::memcpy(bin.data, uuid_buf, 36);
-      values.push_back(enif_make_binary(env, &bin));
-    }
-    break;
+}
+
+// Binary term holding a copy of `value`
+ERL_NIF_TERM make_binary_term(ErlNifEnv *env, std::string_view value) {
+  ERL_NIF_TERM term;
+  unsigned char *data = enif_make_new_binary(env, value.size(), &term);
+  std::memcpy(data, value.data(), value.size());
+  return term;
+}
+
+// Enum names become atoms when requested. Names that can't be an atom
+// (longer than 255 bytes, or non-ASCII) stay binaries.
+ERL_NIF_TERM make_enum_term(ErlNifEnv *env, std::string_view name, const DecodeOptions &opts) {
+  auto is_ascii = [](char c) { return static_cast<unsigned char>(c) < 0x80; };
+  if (opts.enum_atoms && name.size() <= 255 && std::all_of(name.begin(), name.end(), is_ascii)) {
+    return enif_make_atom_len(env, name.data(), name.size());
   }
-  case Type::Decimal:
-  case Type::Decimal32:
-  case Type::Decimal64:
-  case Type::Decimal128: {
-    auto decimal_col = col->As<ColumnDecimal>();
-    for (size_t i = 0; i < count; i++) {
-      Int128 value = decimal_col->At(i);
-      int64_t scaled_value = static_cast<int64_t>(value);
-      values.push_back(enif_make_int64(env, scaled_value));
-    }
-    break;
+  return make_binary_term(env, name);
+}
+
+// Append one term per row of an Enum8/Enum16 column, with nil for rows that
+// `nulls` marks as NULL. Each distinct value is converted once per block and
+// its term is shared by every row holding it.
+template <typename EnumColumn>
+void append_enum_terms(
+    ErlNifEnv *env,
+    const EnumColumn &col,
+    const ColumnNullable *nulls,
+    const DecodeOptions &opts,
+    std::vector<ERL_NIF_TERM> &out) {
+  using Value = std::decay_t<decltype(col.At(0))>;
+  std::unordered_map<Value, ERL_NIF_TERM> terms;
+  ERL_NIF_TERM nil = enif_make_atom(env, "nil");
+  size_t count = col.Size();
+
+  for (size_t i = 0; i < count; i++) {
+    // The nested value of a NULL row isn't necessarily a valid enum value
+    if (nulls && nulls->IsNull(i)) {
+      out.push_back(nil);
+      continue;
+    }
+    Value value = col.At(i);
+    auto it = terms.find(value);
+    if (it == terms.end()) {
+      it = terms.emplace(value, make_enum_term(env, col.NameAt(i), opts)).first;
+    }
+    out.push_back(it->second);
   }
-  case Type::Array: {
-    auto array_col = col->As<ColumnArray>();
-    // Recursively handle nested arrays
-    for (size_t i = 0; i < count; i++) {
-      auto nested = array_col->GetAsColumn(i);
-      values.push_back(column_to_elixir_list(env, nested));
+}
+
+// Append one term per row of a LowCardinality(String) or
+// LowCardinality(Nullable(String)) column. Each distinct dictionary value is
+// converted once per block and its term is shared by every row holding it.
+// The dictionary index isn't exposed by ColumnLowCardinality, so values are
+// keyed by their string_view into the dictionary (valid for the block).
+void append_lowcardinality_terms(
+    ErlNifEnv *env,
+    const ColumnLowCardinality &col,
+    const DecodeOptions &opts,
+    std::vector<ERL_NIF_TERM> &out) {
+  std::unordered_map<std::string_view, ERL_NIF_TERM> terms;
+  ERL_NIF_TERM nil = enif_make_atom(env, "nil");
+  size_t count = col.Size();
+
+  for (size_t i = 0; i < count; i++) {
+    auto item = col.GetItem(i);
+
+    if (item.type == Type::String) {
+      auto val = item.get<std::string_view>();
+      auto it = terms.find(val);
+      if (it == terms.end()) {
+        it = terms.emplace(val, make_binary_term(env, val)).first;
+      }
+      out.push_back(it->second);
+    } else if (item.type == Type::Void) {
+      // Null value
+      out.push_back(nil);
+    } else {
+      throw std::runtime_error("Unsupported LowCardinality inner type");
     }
-    break;
   }
-  case Type::Tuple: {
-    auto tuple_col = col->As<ColumnTuple>();
-    // Handle tuple columns - return Elixir tuples
-    size_t tuple_size = tuple_col->TupleSize();
+}
 
-    // Optimized: Pre-convert each element column ONCE, then index directly
-    std::vector<std::vector<ERL_NIF_TERM>> element_columns;
-    element_columns.reserve(tuple_size);
+// Per-row term constructors for the fixed-width types. Each is instantiated
+// for the concrete column class, so the value access is inlined into the
+// row loop.
+struct UIntTerm {
+  template <typename ColumnT>
+  ERL_NIF_TERM operator()(ErlNifEnv *env, const ColumnT &col, size_t i) const {
+    return enif_make_uint64(env, col.At(i));
+  }
+};
 
-    for (size_t j = 0; j < tuple_size; j++) {
-      auto element_col = tuple_col->At(j);
-      // Convert entire element column to Elixir list, then extract to vector
-      ERL_NIF_TERM elem_list = column_to_elixir_list(env, element_col);
-      std::vector<ERL_NIF_TERM> elem_vec;
-      elem_vec.reserve(count);
-      ERL_NIF_TERM tail = elem_list;
-      for (size_t i = 0; i < count; i++) {
-        ERL_NIF_TERM head;
-        if (enif_get_list_cell(env, tail, &head, &tail)) {
-          elem_vec.push_back(head);
-        } else {
-          elem_vec.push_back(enif_make_atom(env, "error"));
-        }
-      }
-      element_columns.push_back(std::move(elem_vec));
-    }
+struct IntTerm {
+  template <typename ColumnT>
+  ERL_NIF_TERM operator()(ErlNifEnv *env, const ColumnT &col, size_t i) const {
+    return enif_make_int64(env, col.At(i));
+  }
+};
 
-    // Now build tuples by indexing pre-converted columns
-    for (size_t i = 0; i < count; i++) {
-      std::vector<ERL_NIF_TERM> tuple_elements;
-      tuple_elements.reserve(tuple_size);
-      for (size_t j = 0; j < tuple_size; j++) {
-        tuple_elements.push_back(element_columns[j][i]);
-      }
-      values.push_back(enif_make_tuple_from_array(env, tuple_elements.data(), tuple_elements.size()));
-    }
-    break;
+struct DoubleTerm {
+  template <typename ColumnT>
+  ERL_NIF_TERM operator()(ErlNifEnv *env, const ColumnT &col, size_t i) const {
+    return enif_make_double(env, col.At(i));
   }
-  case Type::Map: {
-    auto map_col = col->As<ColumnMap>();
-    // Handle map columns - return Elixir maps
-    // Map is stored as Array(Tuple(K, V)) where Tuple is columnar
-    for (size_t i = 0; i < count; i++) {
-      // Get the i-th map's tuples as a ColumnTuple
-      auto kv_tuples = map_col->GetAsColumn(i);
-
-      // This is a ColumnTuple with 2 columns: keys and values
-      if (auto tuple_col = kv_tuples->As<ColumnTuple>()) {
-        // Get the keys and values columns
-        auto keys_col = tuple_col->At(0);
-        auto values_col = tuple_col->At(1);
-
-        // The number of key-value pairs is the size of the keys/values columns
-        size_t map_size = keys_col->Size();
-
-        // Optimized: Convert columns to vectors directly, then build map in O(M)
-        std::vector<ERL_NIF_TERM> key_terms;
-        std::vector<ERL_NIF_TERM> value_terms;
-        key_terms.reserve(map_size);
-        value_terms.reserve(map_size);
-
-        // Convert keys column to vector
-        ERL_NIF_TERM keys_list = column_to_elixir_list(env, keys_col);
-        ERL_NIF_TERM key_tail = keys_list;
-        for (size_t j = 0; j < map_size; j++) {
-          ERL_NIF_TERM key;
-          if (enif_get_list_cell(env, key_tail, &key, &key_tail)) {
-            key_terms.push_back(key);
-          }
-        }
-
-        // Convert values column to vector
-        ERL_NIF_TERM values_list = column_to_elixir_list(env, values_col);
-        ERL_NIF_TERM value_tail = values_list;
-        for (size_t j = 0; j < map_size; j++) {
-          ERL_NIF_TERM value;
-          if (enif_get_list_cell(env, value_tail, &value, &value_tail)) {
-            value_terms.push_back(value);
-          }
-        }
-
-        // Build map in O(M) with enif_make_map_from_arrays
-        ERL_NIF_TERM elixir_map;
-        enif_make_map_from_arrays(env, key_terms.data(), value_terms.data(), map_size, &elixir_map);
-
-        values.push_back(elixir_map);
-      } else {
-        // Fallback for unexpected structure
-        values.push_back(enif_make_new_map(env));
-      }
-    }
-    break;
+};
+
+// Date is returned as days since the epoch
+struct DateTerm {
+  ERL_NIF_TERM operator()(ErlNifEnv *env, const ColumnDate &col, size_t i) const {
+    return enif_make_uint64(env, col.RawAt(i));
   }
-  case Type::Enum8: {
-    auto enum8_col = col->As<ColumnEnum8>();
-    // Handle Enum8 columns - return string names
-    for (size_t i = 0; i < count; i++) {
-      std::string_view name = enum8_col->NameAt(i);
-      ErlNifBinary bin;
-      enif_alloc_binary(name.size(), &bin);
-      std::memcpy(bin.data, name.data(), name.size());
-      values.push_back(enif_make_binary(env, &bin));
-    }
-    break;
+};
+
+// UUIDs are formatted straight into the binary
+struct UUIDTerm {
+  ERL_NIF_TERM operator()(ErlNifEnv *env, const ColumnUUID &col, size_t i) const {
+    ERL_NIF_TERM term;
+    unsigned char *data = enif_make_new_binary(env, 36, &term);
+    format_uuid_to_buffer(col.At(i), reinterpret_cast<char *>(data));
+    return term;
   }
-  case Type::Enum16: {
-    auto enum16_col = col->As<ColumnEnum16>();
-    // Handle Enum16 columns - return string names
-    for (size_t i = 0; i < count; i++) {
-      std::string_view name = enum16_col->NameAt(i);
-      ErlNifBinary bin;
-      enif_alloc_binary(name.size(), &bin);
-      std::memcpy(bin.data, name.data(), name.size());
-      values.push_back(enif_make_binary(env, &bin));
-    }
-    break;
+};
+
+// Decimals are returned as their scaled integer (assumes the value fits in
+// int64); Elixir converts back by dividing by 10^scale
+struct DecimalTerm {
+  ERL_NIF_TERM operator()(ErlNifEnv *env, const ColumnDecimal &col, size_t i) const {
+    Int128 value = col.At(i);
+    return enif_make_int64(env, static_cast<int64_t>(value));
   }
-  case Type::LowCardinality: {
-    auto lc_col = col->As<ColumnLowCardinality>();
-    // Handle LowCardinality columns - decode values from dictionary
-    // For each row, get the decoded value by calling GetItem
-    // GetItem internally looks up the dictionary index and returns the value
+};
+
+// Append one term per row of a fixed-width column, with nil for rows that
+// `nulls` marks as NULL
+template <typename ColumnT, typename MakeTerm>
+void append_fixed_terms(
+    ErlNifEnv *env,
+    const ColumnRef &col,
+    const ColumnNullable *nulls,
+    std::vector<ERL_NIF_TERM> &out,
+    MakeTerm make_term) {
+  const ColumnT &typed = *col->As<ColumnT>();
+  size_t count = typed.Size();
+
+  // Terms are written into place so the row loop has no capacity checks
+  size_t base = out.size();
+  out.resize(base + count);
+  ERL_NIF_TERM *dst = out.data() + base;
+
+  if (!nulls) {
     for (size_t i = 0; i < count; i++) {
-      auto item = lc_col->GetItem(i);
-
-      // Convert ItemView to Elixir term based on type
-      if (item.type == Type::String) {
-        auto val = item.get<std::string_view>();
-        ErlNifBinary bin;
-        enif_alloc_binary(val.size(), &bin);
-        std::memcpy(bin.data, val.data(), val.size());
-        values.push_back(enif_make_binary(env, &bin));
-      } else if (item.type == Type::Void) {
-        // Null value
-        values.push_back(enif_make_atom(env, "nil"));
-      } else {
-        // For other types, would need more handling
-        // For now, throw an error
-        throw std::runtime_error("Unsupported LowCardinality inner type");
-      }
+      dst[i] = make_term(env, typed, i);
     }
-    break;
-  }
-  case Type::Nullable: {
-    auto nullable_col = col->As<ColumnNullable>();
-    auto nested = nullable_col->Nested();
-
-    // Optimized: Check nested type ONCE outside loop, then direct extraction
-    if (auto uint64_col = nested->As<ColumnUInt64>()) {
-      for (size_t i = 0; i < count; i++) {
-        if (nullable_col->IsNull(i)) {
-          values.push_back(enif_make_atom(env, "nil"));
-        } else {
-          values.push_back(enif_make_uint64(env, uint64_col->At(i)));
-        }
-      }
-    } else if (auto int64_col = nested->As<ColumnInt64>()) {
-      for (size_t i = 0; i < count; i++) {
-        if (nullable_col->IsNull(i)) {
-          values.push_back(enif_make_atom(env, "nil"));
-        } else {
-          values.push_back(enif_make_int64(env, int64_col->At(i)));
-        }
-      }
-    } else if (auto float64_col = nested->As<ColumnFloat64>()) {
-      for (size_t i = 0; i < count; i++) {
-        if (nullable_col->IsNull(i)) {
-          values.push_back(enif_make_atom(env, "nil"));
-        } else {
-          values.push_back(enif_make_double(env, float64_col->At(i)));
-        }
-      }
-    } else if (auto string_col = nested->As<ColumnString>()) {
-      for (size_t i = 0; i < count; i++) {
-        if (nullable_col->IsNull(i)) {
-          values.push_back(enif_make_atom(env, "nil"));
-        } else {
-          std::string_view val_view = string_col->At(i);
-          ErlNifBinary bin;
-          enif_alloc_binary(val_view.size(), &bin);
-          std::memcpy(bin.data, val_view.data(), val_view.size());
-          values.push_back(enif_make_binary(env, &bin));
-        }
-      }
-    } else {
-      // Fallback for complex/uncommon types: use Slice approach
-      for (size_t i = 0; i < count; i++) {
-        if (nullable_col->IsNull(i)) {
-          values.push_back(enif_make_atom(env, "nil"));
-        } else {
-          auto single_value_col = nested->Slice(i, 1);
-          ERL_NIF_TERM elem_list = column_to_elixir_list(env, single_value_col);
-          ERL_NIF_TERM head, tail;
-          if (enif_get_list_cell(env, elem_list, &head, &tail)) {
-            values.push_back(head);
-          } else {
-            values.push_back(enif_make_atom(env, "error"));
-          }
-        }
-      }
-    }
-    break;
-  }
-  default:
-    // Unsupported or unknown type
-    throw std::runtime_error("Unsupported column type in column_to_elixir_list");
+    return;
   }
 
-  return enif_make_list_from_array(env, values.data(), values.size());
+  ERL_NIF_TERM nil = enif_make_atom(env, "nil");
+  for (size_t i = 0; i < count; i++) {
+    dst[i] = nulls->IsNull(i) ? nil : make_term(env, typed, i);
+  }
 }
 
-// Helper to convert Block to maps and append to output vector
-void block_to_maps_impl(ErlNifEnv *env, std::shared_ptr<Block> block, std::vector<ERL_NIF_TERM>& out_maps) {
-  size_t col_count = block->GetColumnCount();
-  size_t row_count = block->GetRowCount();
+// Blocks with fewer rows than this make UInt8/Int8 terms one by one
+constexpr size_t kByteTableMinRows = 512;
 
-  if (row_count == 0) {
-    return;  // Nothing to add
+// UInt8/Int8 (and Bool) columns look their terms up in a table of all 256
+// values, built once per block, instead of making one per row
+template <typename ColumnT>
+void append_byte_terms(
+    ErlNifEnv *env,
+    const ColumnRef &col,
+    const ColumnNullable *nulls,
+    std::vector<ERL_NIF_TERM> &out) {
+  using T = typename ColumnT::ValueType;
+  const ColumnT &typed = *col->As<ColumnT>();
+  size_t count = typed.Size();
+
+  if (count < kByteTableMinRows) {
+    if constexpr (std::is_signed_v<T>) {
+      return append_fixed_terms<ColumnT>(env, col, nulls, out, IntTerm{});
+    } else {
+      return append_fixed_terms<ColumnT>(env, col, nulls, out, UIntTerm{});
+    }
   }
 
-  // Extract column names and data
-  std::vector<std::string> col_names;
-  std::vector<std::vector<ERL_NIF_TERM>> col_data;
-
-  for (size_t c = 0; c < col_count; c++) {
-    col_names.push_back(block->GetColumnName(c));
+  std::array<ERL_NIF_TERM, 256> table;
+  for (unsigned v = 0; v < 256; v++) {
+    T value = static_cast<T>(v);
+    table[v] = std::is_signed_v<T> ? enif_make_int64(env, value) : enif_make_uint64(env, value);
+  }
 
-    ColumnRef col = (*block)[c];
-    std::vector<ERL_NIF_TERM> column_values;
-    column_values.reserve(row_count);
+  size_t base = out.size();
+  out.resize(base + count);
+  ERL_NIF_TERM *dst = out.data() + base;
+  ERL_NIF_TERM nil = enif_make_atom(env, "nil");
 
-    // Extract column data based on type
-    if (auto uint64_col = col->As<ColumnUInt64>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_uint64(env, uint64_col->At(i)));
-      }
-    } else if (auto uint32_col = col->As<ColumnUInt32>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_uint64(env, uint32_col->At(i)));
-      }
-    } else if (auto uint16_col = col->As<ColumnUInt16>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_uint64(env, uint16_col->At(i)));
-      }
-    } else if (auto uint8_col = col->As<ColumnUInt8>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_uint64(env, uint8_col->At(i)));
-      }
-    } else if (auto int64_col = col->As<ColumnInt64>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_int64(env, int64_col->At(i)));
-      }
-    } else if (auto int32_col = col->As<ColumnInt32>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_int64(env, int32_col->At(i)));
-      }
-    } else if (auto int16_col = col->As<ColumnInt16>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_int64(env, int16_col->At(i)));
-      }
-    } else if (auto int8_col = col->As<ColumnInt8>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_int64(env, int8_col->At(i)));
-      }
-    } else if (auto float64_col = col->As<ColumnFloat64>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_double(env, float64_col->At(i)));
-      }
-    } else if (auto float32_col = col->As<ColumnFloat32>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_double(env, float32_col->At(i)));
-      }
-    } else if (auto string_col = col->As<ColumnString>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        std::string_view val_view = string_col->At(i);
-        ErlNifBinary bin;
-        enif_alloc_binary(val_view.size(), &bin);
-        std::memcpy(bin.data, val_view.data(), val_view.size());
-        column_values.push_back(enif_make_binary(env, &bin));
-      }
-    } else if (auto datetime_col = col->As<ColumnDateTime>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_uint64(env, datetime_col->At(i)));
-      }
-    } else if (auto datetime64_col = col->As<ColumnDateTime64>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_int64(env, datetime64_col->At(i)));
-      }
-    } else if (auto date_col = col->As<ColumnDate>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        column_values.push_back(enif_make_uint64(env, date_col->RawAt(i)));
-      }
-    } else if (auto uuid_col = col->As<ColumnUUID>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        UUID uuid = uuid_col->At(i);
-        char uuid_buf[37];
-        format_uuid_to_buffer(uuid, uuid_buf);
-        ErlNifBinary bin;
-        enif_alloc_binary(36, &bin);
-        std::memcpy(bin.data, uuid_buf, 36);
-        column_values.push_back(enif_make_binary(env, &bin));
-      }
-    } else if (auto decimal_col = col->As<ColumnDecimal>()) {
-      for (size_t i = 0; i < row_count; i++) {
-        Int128 value = decimal_col->At(i);
-        // Convert Int128 to int64 for Elixir (assumes value fits in int64)
-        // Elixir will convert back to Decimal by dividing by 10^scale
-        int64_t scaled_value = static_cast<int64_t>(value);
-        column_values.push_back(enif_make_int64(env, scaled_value));
-      }
-    } else if (auto array_col = col->As<ColumnArray>()) {
-      // Handle array columns - recursively converts nested arrays to Elixir lists
-      for (size_t i = 0; i < row_count; i++) {
-        auto nested = array_col->GetAsColumn(i);
-        column_values.push_back(column_to_elixir_list(env, nested));
-      }
-    } else if (auto map_col = col->As<ColumnMap>()) {
-      // Handle map columns - use column_to_elixir_list for complex nested structure
-      for (size_t i = 0; i < row_count; i++) {
-        auto kv_tuples = map_col->GetAsColumn(i);
-
-        if (auto tuple_col = kv_tuples->As<ColumnTuple>()) {
-          auto keys_col = tuple_col->At(0);
-          auto values_col = tuple_col->At(1);
-          size_t map_size = keys_col->Size();
-
-          // Optimized: Convert columns to vectors directly, then build map in O(M)
-          std::vector<ERL_NIF_TERM> key_terms;
-          std::vector<ERL_NIF_TERM> value_terms;
-          key_terms.reserve(map_size);
-          value_terms.reserve(map_size);
-
-          // Convert keys column to vector
-          ERL_NIF_TERM keys_list = column_to_elixir_list(env, keys_col);
-          ERL_NIF_TERM key_tail = keys_list;
-          for (size_t j = 0; j < map_size; j++) {
-            ERL_NIF_TERM key;
-            if (enif_get_list_cell(env, key_tail, &key, &key_tail)) {
-              key_terms.push_back(key);
-            }
-          }
-
-          // Convert values column to vector
-          ERL_NIF_TERM values_list = column_to_elixir_list(env, values_col);
-          ERL_NIF_TERM value_tail = values_list;
-          for (size_t j = 0; j < map_size; j++) {
-            ERL_NIF_TERM value;
-            if (enif_get_list_cell(env, value_tail, &value, &value_tail)) {
-              value_terms.push_back(value);
-            }
-          }
-
-          // Build map in O(M) with enif_make_map_from_arrays
-          ERL_NIF_TERM elixir_map;
-          enif_make_map_from_arrays(env, key_terms.data(), value_terms.data(), map_size, &elixir_map);
-
-          column_values.push_back(elixir_map);
-        } else {
-          column_values.push_back(enif_make_new_map(env));
-        }
-      }
-    } else if (auto tuple_col = col->As<ColumnTuple>()) {
-      // Handle tuple columns - use column_to_elixir_list for complex logic
-      size_t tuple_size = tuple_col->TupleSize();
-
-      // Optimized: Pre-convert each element column ONCE, then index directly
-      std::vector<std::vector<ERL_NIF_TERM>> element_columns;
-      element_columns.reserve(tuple_size);
-
-      for (size_t j = 0; j < tuple_size; j++) {
-        auto element_col = tuple_col->At(j);
-        // Convert entire element column to Elixir list, then extract to vector
-        ERL_NIF_TERM elem_list = column_to_elixir_list(env, element_col);
-        std::vector<ERL_NIF_TERM> elem_vec;
-        elem_vec.reserve(row_count);
-        ERL_NIF_TERM tail = elem_list;
-        for (size_t i = 0; i < row_count; i++) {
-          ERL_NIF_TERM head;
-          if (enif_get_list_cell(env, tail, &head, &tail)) {
-            elem_vec.push_back(head);
-          } else {
-            elem_vec.push_back(enif_make_atom(env, "error"));
-          }
-        }
-        element_columns.push_back(std::move(elem_vec));
-      }
+  for (size_t i = 0; i < count; i++) {
+    ERL_NIF_TERM term = table[static_cast<uint8_t>(typed.At(i))];
+    dst[i] = nulls && nulls->IsNull(i) ? nil : term;
+  }
+}
 
-      // Now build tuples by indexing pre-converted columns
-      for (size_t i = 0; i < row_count; i++) {
-        std::vector<ERL_NIF_TERM> tuple_elements;
-        tuple_elements.reserve(tuple_size);
-        for (size_t j = 0; j < tuple_size; j++) {
-          tuple_elements.push_back(element_columns[j][i]);
-        }
-        column_values.push_back(enif_make_tuple_from_array(env, tuple_elements.data(), tuple_elements.size()));
-      }
-    } else if (auto enum8_col = col->As<ColumnEnum8>()) {
-      // Handle Enum8 columns
-      for (size_t i = 0; i < row_count; i++) {
-        std::string_view name = enum8_col->NameAt(i);
-        ErlNifBinary bin;
-        enif_alloc_binary(name.size(), &bin);
-        std::memcpy(bin.data, name.data(), name.size());
-        column_values.push_back(enif_make_binary(env, &bin));
-      }
-    } else if (auto enum16_col = col->As<ColumnEnum16>()) {
-      // Handle Enum16 columns
-      for (size_t i = 0; i < row_count; i++) {
-        std::string_view name = enum16_col->NameAt(i);
-        ErlNifBinary bin;
-        enif_alloc_binary(name.size(), &bin);
-        std::memcpy(bin.data, name.data(), name.size());
-        column_values.push_back(enif_make_binary(env, &bin));
-      }
-    } else if (auto lc_col = col->As<ColumnLowCardinality>()) {
-      // Handle LowCardinality columns
-      for (size_t i = 0; i < row_count; i++) {
-        auto item = lc_col->GetItem(i);
-        if (item.type == Type::String) {
-          auto val = item.get<std::string_view>();
-          ErlNifBinary bin;
-          enif_alloc_binary(val.size(), &bin);
-          std::memcpy(bin.data, val.data(), val.size());
-          column_values.push_back(enif_make_binary(env, &bin));
-        } else if (item.type == Type::Void) {
-          column_values.push_back(enif_make_atom(env, "nil"));
-        } else {
-          throw std::runtime_error("Unsupported LowCardinality inner type");
-        }
-      }
-    } else if (auto nullable_col = col->As<ColumnNullable>()) {
-      auto nested = nullable_col->Nested();
-
-      // Optimized: Check nested type ONCE outside loop, then direct extraction
-      if (auto uint64_col = nested->As<ColumnUInt64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          if (nullable_col->IsNull(i)) {
-            column_values.push_back(enif_make_atom(env, "nil"));
-          } else {
-            column_values.push_back(enif_make_uint64(env, uint64_col->At(i)));
-          }
-        }
-      } else if (auto int64_col = nested->As<ColumnInt64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          if (nullable_col->IsNull(i)) {
-            column_values.push_back(enif_make_atom(env, "nil"));
-          } else {
-            column_values.push_back(enif_make_int64(env, int64_col->At(i)));
-          }
-        }
-      } else if (auto float64_col = nested->As<ColumnFloat64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          if (nullable_col->IsNull(i)) {
-            column_values.push_back(enif_make_atom(env, "nil"));
-          } else {
-            column_values.push_back(enif_make_double(env, float64_col->At(i)));
-          }
-        }
-      } else if (auto string_col = nested->As<ColumnString>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          if (nullable_col->IsNull(i)) {
-            column_values.push_back(enif_make_atom(env, "nil"));
-          } else {
-            std::string_view val_view = string_col->At(i);
-            ErlNifBinary bin;
-            enif_alloc_binary(val_view.size(), &bin);
-            std::memcpy(bin.data, val_view.data(), val_view.size());
-            column_values.push_back(enif_make_binary(env, &bin));
-          }
-        }
-      } else {
-        // Fallback for complex/uncommon types: use Slice approach
-        for (size_t i = 0; i < row_count; i++) {
-          if (nullable_col->IsNull(i)) {
-            column_values.push_back(enif_make_atom(env, "nil"));
-          } else {
-            auto single_value_col = nested->Slice(i, 1);
-            ERL_NIF_TERM elem_list = column_to_elixir_list(env, single_value_col);
-            ERL_NIF_TERM head, tail;
-            if (enif_get_list_cell(env, elem_list, &head, &tail)) {
-              column_values.push_back(head);
-            } else {
-              column_values.push_back(enif_make_atom(env, "error"));
-            }
-          }
-        }
-      }
+// Tuples become Elixir tuples. Each element column is decoded once, then
+// the tuples are built by indexing the decoded elements.
+void append_tuple_terms(
+    ErlNifEnv *env,
+    const ColumnTuple &col,
+    const DecodeOptions &opts,
+    std::vector<ERL_NIF_TERM> &out) {
+  size_t count = col.Size();
+  size_t tuple_size = col.TupleSize();
+
+  std::vector<ScratchTerms> element_columns;
+  element_columns.reserve(tuple_size);
+  for (size_t j = 0; j < tuple_size; j++) {
+    element_columns.emplace_back(count);
+    append_column_terms(env, col.At(j), nullptr, opts, element_columns[j].terms);
+  }
+
+  ScratchTerms tuple_elements(tuple_size);
+  tuple_elements.terms.resize(tuple_size);
+  for (size_t i = 0; i < count; i++) {
+    for (size_t j = 0; j < tuple_size; j++) {
+      tuple_elements.terms[j] = element_columns[j].terms[i];
     }
+    out.push_back(enif_make_tuple_from_array(env, tuple_elements.terms.data(), tuple_size));
+  }
+}
 
-    col_data.push_back(column_values);
+// Maps become Elixir maps. A Map is stored as Array(Tuple(K, V)) where the
+// tuple is columnar, so each row's keys and values are decoded as columns
+// and the map is built in O(M) with enif_make_map_from_arrays.
+void append_map_terms(
+    ErlNifEnv *env,
+    const ColumnMap &col,
+    const DecodeOptions &opts,
+    std::vector<ERL_NIF_TERM> &out) {
+  size_t count = col.Size();
+  ScratchTerms keys;
+  ScratchTerms values;
+  std::vector<ERL_NIF_TERM> &key_terms = keys.terms;
+  std::vector<ERL_NIF_TERM> &value_terms = values.terms;
+
+  for (size_t i = 0; i < count; i++) {
+    auto tuple_col = col.GetAsColumn(i)->As<ColumnTuple>();
+    if (!tuple_col) {
+      // Fallback for unexpected structure
+      out.push_back(enif_make_new_map(env));
+      continue;
+    }
+
+    key_terms.clear();
+    value_terms.clear();
+    append_column_terms(env, tuple_col->At(0), nullptr, opts, key_terms);
+    append_column_terms(env, tuple_col->At(1), nullptr, opts, value_terms);
+
+    ERL_NIF_TERM elixir_map;
+    enif_make_map_from_arrays(
+        env, key_terms.data(), value_terms.data(), key_terms.size(), &elixir_map);
+    out.push_back(elixir_map);
   }
+}
 
-  // Pre-create column name atoms once (major optimization)
-  std::vector<ERL_NIF_TERM> key_atoms;
-  key_atoms.reserve(col_count);
-  for (size_t c = 0; c < col_count; c++) {
-    key_atoms.push_back(enif_make_atom(env, col_names[c].c_str()));
+// Arrays become lists. The flattened nested column is decoded once (so
+// Array(Array(T)) and Array(Nullable(T)) take the same path as any other
+// column) and each row's list is cut from the decoded terms by its offset.
+void append_array_terms(
+    ErlNifEnv *env,
+    ColumnArray &col,
+    const DecodeOptions &opts,
+    std::vector<ERL_NIF_TERM> &out) {
+  ColumnRef data = ArrayColumnAccess::data(col);
+  ScratchTerms elements(data->Size());
+  append_column_terms(env, data, nullptr, opts, elements.terms);
+
+  size_t count = col.Size();
+  for (size_t i = 0; i < count; i++) {
+    size_t start = ArrayColumnAccess::offset(col, i);
+    size_t size = ArrayColumnAccess::size(col, i);
+    out.push_back(enif_make_list_from_array(env, elements.terms.data() + start, size));
   }
+}
 
-  // Build maps in local vector first for better cache locality
-  std::vector<ERL_NIF_TERM> rows;
-  rows.reserve(row_count);
+// The column decoder behind every SELECT path: appends one term per row of
+// `col` to `out`, with nil for rows that `nulls` marks as NULL (set when
+// decoding the nested column of a Nullable). Row maps, columnar results and
+// streamed blocks differ only in how they assemble these per-column vectors,
+// so every type is handled here and nowhere else.
+void append_column_terms(
+    ErlNifEnv *env,
+    const ColumnRef &col,
+    const ColumnNullable *nulls,
+    const DecodeOptions &opts,
+    std::vector<ERL_NIF_TERM> &out) {
+  switch (col->GetType().GetCode()) {
+  case Type::UInt64:
+    return append_fixed_terms<ColumnUInt64>(env, col, nulls, out, UIntTerm{});
+  case Type::UInt32:
+    return append_fixed_terms<ColumnUInt32>(env, col, nulls, out, UIntTerm{});
+  case Type::UInt16:
+    return append_fixed_terms<ColumnUInt16>(env, col, nulls, out, UIntTerm{});
+  case Type::UInt8:
+    return append_byte_terms<ColumnUInt8>(env, col, nulls, out);
+  case Type::Int64:
+    return append_fixed_terms<ColumnInt64>(env, col, nulls, out, IntTerm{});
+  case Type::Int32:
+    return append_fixed_terms<ColumnInt32>(env, col, nulls, out, IntTerm{});
+  case Type::Int16:
+    return append_fixed_terms<ColumnInt16>(env, col, nulls, out, IntTerm{});
+  case Type::Int8:
+    return append_byte_terms<ColumnInt8>(env, col, nulls, out);
+  case Type::Float64:
+    return append_fixed_terms<ColumnFloat64>(env, col, nulls, out, DoubleTerm{});
+  case Type::Float32:
+    return append_fixed_terms<ColumnFloat32>(env, col, nulls, out, DoubleTerm{});
+  case Type::DateTime:
+    return append_fixed_terms<ColumnDateTime>(env, col, nulls, out, UIntTerm{});
+  case Type::DateTime64:
+    return append_fixed_terms<ColumnDateTime64>(env, col, nulls, out, IntTerm{});
+  case Type::Date:
+    return append_fixed_terms<ColumnDate>(env, col, nulls, out, DateTerm{});
+  case Type::UUID:
+    return append_fixed_terms<ColumnUUID>(env, col, nulls, out, UUIDTerm{});
+  case Type::Decimal:
+  case Type::Decimal32:
+  case Type::Decimal64:
+  case Type::Decimal128:
+    return append_fixed_terms<ColumnDecimal>(env, col, nulls, out, DecimalTerm{});
+  case Type::String:
+    return append_string_terms(env, *col->As<ColumnString>(), nulls, opts, out);
+  case Type::Enum8:
+    return append_enum_terms(env, *col->As<ColumnEnum8>(), nulls, opts, out);
+  case Type::Enum16:
+    return append_enum_terms(env, *col->As<ColumnEnum16>(), nulls, opts, out);
+  case Type::Nullable: {
+    auto nullable_col = col->As<ColumnNullable>();
+    return append_column_terms(env, nullable_col->Nested(), nullable_col.get(), opts, out);
+  }
+  // ClickHouse doesn't allow the types below inside Nullable, so they never
+  // see `nulls`
+  case Type::LowCardinality:
+    return append_lowcardinality_terms(env, *col->As<ColumnLowCardinality>(), opts, out);
+  case Type::Tuple:
+    return append_tuple_terms(env, *col->As<ColumnTuple>(), opts, out);
+  case Type::Map:
+    return append_map_terms(env, *col->As<ColumnMap>(), opts, out);
+  case Type::Array:
+    return append_array_terms(env, *col->As<ColumnArray>(), opts, out);
+  default:
+    throw std::runtime_error("Unsupported column type: " + col->GetType().GetName());
+  }
+}
 
-  // Build maps row by row, reusing the pre-created key atoms
-  for (size_t r = 0; r < row_count; r++) {
-    ERL_NIF_TERM values[col_count];
+// ============================================================================
+// Whole results
+// ============================================================================
 
-    for (size_t c = 0; c < col_count; c++) {
-      values[c] = col_data[c][r];
+const std::vector<ERL_NIF_TERM> &ResultBuffer::column_keys(ErlNifEnv *env) {
+  if (key_atoms.size() != column_names.size()) {
+    key_atoms.clear();
+    for (const auto &name : column_names) {
+      key_atoms.push_back(enif_make_atom(env, name.c_str()));
     }
+  }
+  return key_atoms;
+}
 
-    ERL_NIF_TERM map;
-    enif_make_map_from_arrays(env, key_atoms.data(), values, col_count, &map);
-    rows.push_back(map);
+ERL_NIF_TERM ResultBuffer::initial_acc(ErlNifEnv *env) const {
+  if (shape != ResultShape::Columns) {
+    return enif_make_list(env, 0);
   }
 
-  // Append all rows at once to output vector
-  out_maps.insert(out_maps.end(), rows.begin(), rows.end());
+  std::vector<ERL_NIF_TERM> lists(column_names.size(), enif_make_list(env, 0));
+  return enif_make_tuple_from_array(env, lists.data(), lists.size());
 }
 
-// Wrapper struct to return list of maps from FINE NIF
-struct SelectResult {
-  ERL_NIF_TERM maps;
-
-  SelectResult(ERL_NIF_TERM m) : maps(m) {}
+// Terms for every column of a block: column c's row_count values start at
+// values[c], pointing either into `storage` (decoded in the caller's env) or
+// into tuples copied from the decode threads' envs
+struct DecodedBlock {
+  std::vector<ScratchTerms> storage;
+  std::vector<const ERL_NIF_TERM *> values;
 };
 
-// FINE encoder/decoder for SelectResult
-namespace fine {
-  template <>
-  struct Encoder<SelectResult> {
-    static ERL_NIF_TERM encode(ErlNifEnv *env, const SelectResult &result) {
-      return result.maps;
-    }
-  };
-
-  template <>
-  struct Decoder<SelectResult> {
-    static bool decode(ErlNifEnv *env, ERL_NIF_TERM term, SelectResult &result) {
-      // This should never be called since SelectResult is only used for return values
-      return false;
+// Smaller blocks always decode serially; handing them to other threads
+// costs more than it saves
+constexpr size_t kParallelDecodeMinRows = 4096;
+
+// Largest tuple the VM can build
+constexpr size_t kMaxTupleArity = (1 << 24) - 1;
+
+// Heap bytes of one value of `col` beyond the word its term takes in a list
+// or map: boxed floats and binaries. An estimate for QueryStats.
+size_t boxed_value_bytes(const ColumnRef &col, size_t row_count) {
+  switch (col->GetType().GetCode()) {
+  case Type::Float64:
+  case Type::Float32:
+    return 16 * row_count;
+  case Type::UUID:
+    return 56 * row_count;
+  case Type::String: {
+    auto &strings = *col->As<ColumnString>();
+    size_t bytes = 16 * row_count;
+    for (size_t i = 0; i < row_count; i++) {
+      bytes += strings.At(i).size();
     }
-  };
+    return bytes;
+  }
+  case Type::Nullable:
+    return boxed_value_bytes(col->As<ColumnNullable>()->Nested(), row_count);
+  default:
+    return 0;
+  }
 }
 
-// Execute SELECT query and return list of maps
-SelectResult client_select(
-    ErlNifEnv *env,
-    fine::ResourcePtr<Client> client,
-    std::string query) {
-
-  // Collect all result maps immediately in the callback
-  std::vector<ERL_NIF_TERM> all_maps;
-
-  client->Select(query, [&](const Block &block) {
-    // Convert this block to maps and append directly to all_maps
-    auto block_ptr = std::make_shared<Block>(block);
-    block_to_maps_impl(env, block_ptr, all_maps);
-  });
-
-  // Build final list from all maps
-  if (all_maps.empty()) {
-    return SelectResult(enif_make_list(env, 0));
+void record_column_decode(QueryStats *stats, const ColumnRef &col, size_t row_count, uint64_t ns) {
+  if (stats) {
+    stats->decode_ns_by_type[col->GetType().GetName()] += ns;
+    stats->term_bytes += boxed_value_bytes(col, row_count);
   }
-
-  return SelectResult(enif_make_list_from_array(env, all_maps.data(), all_maps.size()));
 }
 
-FINE_NIF(client_select, 0);
-
-// Execute parameterized SELECT query and return list of maps
-SelectResult client_select_parameterized(
+// Decode each column of the block once, in parallel when opts.decode_threads
+// allows it. Per-column decode times go to `stats` when given.
+DecodedBlock decode_block(
     ErlNifEnv *env,
-    fine::ResourcePtr<Client> client,
-    fine::ResourcePtr<Query> query) {
-
-  // Collect all result maps immediately in the callback
-  std::vector<ERL_NIF_TERM> all_maps;
+    const Block &block,
+    const DecodeOptions &opts,
+    QueryStats *stats) {
+  size_t col_count = block.GetColumnCount();
+  size_t row_count = block.GetRowCount();
+
+  DecodedBlock decoded;
+  decoded.values.resize(col_count);
+
+  if (opts.decode_threads <= 1 || col_count < 2 || row_count < kParallelDecodeMinRows ||
+      row_count > kMaxTupleArity) {
+    decoded.storage.reserve(col_count);
+    for (size_t c = 0; c < col_count; c++) {
+      auto start = QueryStats::clock::now();
+      auto &terms = decoded.storage.emplace_back(row_count).terms;
+      append_column_terms(env, block[c], nullptr, opts, terms);
+      decoded.values[c] = terms.data();
+      record_column_decode(stats, block[c], row_count, QueryStats::since(start));
+    }
+    return decoded;
+  }
 
-  // Set callback on the Query object before calling Select
-  query->OnData([&](const Block &block) {
-    // Convert this block to maps and append directly to all_maps
-    auto block_ptr = std::make_shared<Block>(block);
-    block_to_maps_impl(env, block_ptr, all_maps);
-  });
+  // Terms can only be built in one env per thread, so each column gets its
+  // own process-independent env. Its values are packed into one tuple,
+  // which makes merging them into `env` a single enif_make_copy.
+  std::vector<ErlNifEnv *> col_envs(col_count, nullptr);
+  std::vector<ERL_NIF_TERM> tuples(col_count);
+  std::vector<uint64_t> col_ns(col_count, 0);
+  auto free_envs = [&] {
+    for (ErlNifEnv *col_env : col_envs) {
+      if (col_env) {
+        enif_free_env(col_env);
+      }
+    }
+  };
 
-  client->Select(*query);
+  try {
+    DecodePool::instance().run_parallel(col_count, opts.decode_threads, [&](size_t c) {
+      ScopedTimer timer(col_ns[c]);
+      col_envs[c] = enif_alloc_env();
+      ScratchTerms terms(row_count);
+      append_column_terms(col_envs[c], block[c], nullptr, opts, terms.terms);
+      tuples[c] = enif_make_tuple_from_array(col_envs[c], terms.terms.data(), row_count);
+    });
+  } catch (...) {
+    free_envs();
+    throw;
+  }
 
-  // Build final list from all maps
-  if (all_maps.empty()) {
-    return SelectResult(enif_make_list(env, 0));
+  for (size_t c = 0; c < col_count; c++) {
+    int arity;
+    enif_get_tuple(env, enif_make_copy(env, tuples[c]), &arity, &decoded.values[c]);
+    record_column_decode(stats, block[c], row_count, col_ns[c]);
   }
+  free_envs();
 
-  return SelectResult(enif_make_list_from_array(env, all_maps.data(), all_maps.size()));
+  return decoded;
 }
 
-FINE_NIF(client_select_parameterized, 0);
+ERL_NIF_TERM ResultBuffer::consume_last(ErlNifEnv *env, ERL_NIF_TERM acc) {
+  const Block &block = blocks.back();
+  size_t col_count = block.GetColumnCount();
+  size_t row_count = block.GetRowCount();
 
-// Wrapper struct to return columnar map from FINE NIF
-struct ColumnarResult {
-  ERL_NIF_TERM columns_map;
+  DecodedBlock decoded = decode_block(env, block, opts, stats);
+  const auto &col_data = decoded.values;
 
-  ColumnarResult(ERL_NIF_TERM m) : columns_map(m) {}
-};
-
-// FINE encoder/decoder for ColumnarResult
-namespace fine {
-  template <>
-  struct Encoder<ColumnarResult> {
-    static ERL_NIF_TERM encode(ErlNifEnv *env, const ColumnarResult &result) {
-      return result.columns_map;
-    }
-  };
-
-  template <>
-  struct Decoder<ColumnarResult> {
-    static bool decode(ErlNifEnv *env, ERL_NIF_TERM term, ColumnarResult &result) {
-      return false;  // Only used for return values
+  if (stats) {
+    // A list cell per value, or per row a list cell and a tuple, or a
+    // flatmap with its own keys tuple
+    size_t per_row = 16 * col_count;
+    if (shape == ResultShape::Rows) {
+      per_row = 8 * (2 + 3 + 2 * col_count + 1);
+    } else if (shape == ResultShape::Tuples) {
+      per_row = 8 * (2 + 1 + col_count);
     }
-  };
-}
-
-// Execute SELECT query and return columnar format: %{column_name => [values]}
-ColumnarResult client_select_cols(
-    ErlNifEnv *env,
-    fine::ResourcePtr<Client> client,
-    std::string query) {
-
-  // Pre-create column structure on first block (indexed vectors for O(1) access)
-  std::vector<std::string> col_names;
-  std::vector<ERL_NIF_TERM> key_atoms;
-  std::vector<std::vector<ERL_NIF_TERM>> all_columns;
-  bool first_block = true;
+    stats->term_bytes += per_row * row_count;
+  }
 
-  client->Select(query, [&](const Block &block) {
-    size_t col_count = block.GetColumnCount();
-    size_t row_count = block.GetRowCount();
+  ERL_NIF_TERM result;
 
-    if (row_count == 0) {
-      return;
+  if (shape != ResultShape::Columns) {
+    const auto &keys = column_keys(env);
+    if (keys.size() != col_count) {
+      throw std::runtime_error("Block column count differs from the first block");
     }
 
-    // Initialize column structure on first block
-    if (first_block) {
-      col_names.reserve(col_count);
-      key_atoms.reserve(col_count);
-      all_columns.reserve(col_count);
-
+    // Build rows from the last one up, consing each onto the rows so far
+    ScratchTerms values(col_count);
+    values.terms.resize(col_count);
+    result = acc;
+    for (size_t r = row_count; r-- > 0;) {
       for (size_t c = 0; c < col_count; c++) {
-        std::string col_name = block.GetColumnName(c);
-        col_names.push_back(col_name);
-        key_atoms.push_back(enif_make_atom(env, col_name.c_str()));
-
-        // Estimate capacity: assume 10 blocks total (heuristic)
-        std::vector<ERL_NIF_TERM> col_vec;
-        col_vec.reserve(row_count * 10);
-        all_columns.push_back(std::move(col_vec));
+        values.terms[c] = col_data[c][r];
       }
 
-      first_block = false;
+      ERL_NIF_TERM row;
+      if (shape == ResultShape::Tuples) {
+        row = enif_make_tuple_from_array(env, values.terms.data(), col_count);
+      } else {
+        enif_make_map_from_arrays(env, keys.data(), values.terms.data(), col_count, &row);
+      }
+      result = enif_make_list_cell(env, row, result);
+    }
+  } else {
+    int arity;
+    const ERL_NIF_TERM *acc_lists;
+    if (!enif_get_tuple(env, acc, &arity, &acc_lists) ||
+        static_cast<size_t>(arity) != col_count) {
+      throw std::runtime_error("Block column count differs from the first block");
     }
 
-    // Extract each column's data using index-based access
+    ScratchTerms scratch(col_count);
+    std::vector<ERL_NIF_TERM> &lists = scratch.terms;
+    lists.assign(acc_lists, acc_lists + arity);
     for (size_t c = 0; c < col_count; c++) {
-      ColumnRef col = block[c];
-      std::vector<ERL_NIF_TERM> column_values;
-      column_values.reserve(row_count);
-
-      // Extract column data based on type (reuse logic from block_to_maps_impl)
-      if (auto uint64_col = col->As<ColumnUInt64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, uint64_col->At(i)));
-        }
-      } else if (auto uint32_col = col->As<ColumnUInt32>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, uint32_col->At(i)));
-        }
-      } else if (auto uint16_col = col->As<ColumnUInt16>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, uint16_col->At(i)));
-        }
-      } else if (auto uint8_col = col->As<ColumnUInt8>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, uint8_col->At(i)));
-        }
-      } else if (auto int64_col = col->As<ColumnInt64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, int64_col->At(i)));
-        }
-      } else if (auto int32_col = col->As<ColumnInt32>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, int32_col->At(i)));
-        }
-      } else if (auto int16_col = col->As<ColumnInt16>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, int16_col->At(i)));
-        }
-      } else if (auto int8_col = col->As<ColumnInt8>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, int8_col->At(i)));
-        }
-      } else if (auto float64_col = col->As<ColumnFloat64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_double(env, float64_col->At(i)));
-        }
-      } else if (auto float32_col = col->As<ColumnFloat32>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_double(env, float32_col->At(i)));
-        }
-      } else if (auto string_col = col->As<ColumnString>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          std::string_view val_view = string_col->At(i);
-          ErlNifBinary bin;
-          enif_alloc_binary(val_view.size(), &bin);
-          std::memcpy(bin.data, val_view.data(), val_view.size());
-          column_values.push_back(enif_make_binary(env, &bin));
-        }
-      } else if (auto datetime_col = col->As<ColumnDateTime>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, datetime_col->At(i)));
-        }
-      } else if (auto datetime64_col = col->As<ColumnDateTime64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, datetime64_col->At(i)));
-        }
-      } else if (auto date_col = col->As<ColumnDate>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, date_col->RawAt(i)));
-        }
-      } else if (auto uuid_col = col->As<ColumnUUID>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          UUID uuid = uuid_col->At(i);
-          char uuid_buf[37];
-          format_uuid_to_buffer(uuid, uuid_buf);
-          ErlNifBinary bin;
-          enif_alloc_binary(36, &bin);
-          std::memcpy(bin.data, uuid_buf, 36);
-          column_values.push_back(enif_make_binary(env, &bin));
-        }
-      } else if (auto decimal_col = col->As<ColumnDecimal>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          Int128 value = decimal_col->At(i);
-          int64_t scaled_value = static_cast<int64_t>(value);
-          column_values.push_back(enif_make_int64(env, scaled_value));
-        }
-      } else if (auto array_col = col->As<ColumnArray>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          auto nested = array_col->GetAsColumn(i);
-          column_values.push_back(column_to_elixir_list(env, nested));
-        }
-      } else if (auto map_col = col->As<ColumnMap>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          auto kv_tuples = map_col->GetAsColumn(i);
-          if (auto tuple_col = kv_tuples->As<ColumnTuple>()) {
-            auto keys_col = tuple_col->At(0);
-            auto values_col = tuple_col->At(1);
-            size_t map_size = keys_col->Size();
-
-            // Optimized: Convert columns to vectors directly, then build map in O(M)
-            std::vector<ERL_NIF_TERM> key_terms;
-            std::vector<ERL_NIF_TERM> value_terms;
-            key_terms.reserve(map_size);
-            value_terms.reserve(map_size);
-
-            // Convert keys column to vector
-            ERL_NIF_TERM keys_list = column_to_elixir_list(env, keys_col);
-            ERL_NIF_TERM key_tail = keys_list;
-            for (size_t j = 0; j < map_size; j++) {
-              ERL_NIF_TERM key;
-              if (enif_get_list_cell(env, key_tail, &key, &key_tail)) {
-                key_terms.push_back(key);
-              }
-            }
-
-            // Convert values column to vector
-            ERL_NIF_TERM values_list = column_to_elixir_list(env, values_col);
-            ERL_NIF_TERM value_tail = values_list;
-            for (size_t j = 0; j < map_size; j++) {
-              ERL_NIF_TERM value;
-              if (enif_get_list_cell(env, value_tail, &value, &value_tail)) {
-                value_terms.push_back(value);
-              }
-            }
-
-            // Build map in O(M) with enif_make_map_from_arrays
-            ERL_NIF_TERM elixir_map;
-            enif_make_map_from_arrays(env, key_terms.data(), value_terms.data(), map_size, &elixir_map);
-
-            column_values.push_back(elixir_map);
-          } else {
-            column_values.push_back(enif_make_new_map(env));
-          }
-        }
-      } else if (auto tuple_col = col->As<ColumnTuple>()) {
-        size_t tuple_size = tuple_col->TupleSize();
-
-        // Optimized: Pre-convert each element column ONCE, then index directly
-        std::vector<std::vector<ERL_NIF_TERM>> element_columns;
-        element_columns.reserve(tuple_size);
-
-        for (size_t j = 0; j < tuple_size; j++) {
-          auto element_col = tuple_col->At(j);
-          // Convert entire element column to Elixir list, then extract to vector
-          ERL_NIF_TERM elem_list = column_to_elixir_list(env, element_col);
-          std::vector<ERL_NIF_TERM> elem_vec;
-          elem_vec.reserve(row_count);
-          ERL_NIF_TERM tail = elem_list;
-          for (size_t i = 0; i < row_count; i++) {
-            ERL_NIF_TERM head;
-            if (enif_get_list_cell(env, tail, &head, &tail)) {
-              elem_vec.push_back(head);
-            } else {
-              elem_vec.push_back(enif_make_atom(env, "error"));
-            }
-          }
-          element_columns.push_back(std::move(elem_vec));
-        }
-
-        // Now build tuples by indexing pre-converted columns
-        for (size_t i = 0; i < row_count; i++) {
-          std::vector<ERL_NIF_TERM> tuple_elements;
-          tuple_elements.reserve(tuple_size);
-          for (size_t j = 0; j < tuple_size; j++) {
-            tuple_elements.push_back(element_columns[j][i]);
-          }
-          column_values.push_back(enif_make_tuple_from_array(env, tuple_elements.data(), tuple_elements.size()));
-        }
-      } else if (auto enum8_col = col->As<ColumnEnum8>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          std::string_view name = enum8_col->NameAt(i);
-          ErlNifBinary bin;
-          enif_alloc_binary(name.size(), &bin);
-          std::memcpy(bin.data, name.data(), name.size());
-          column_values.push_back(enif_make_binary(env, &bin));
-        }
-      } else if (auto enum16_col = col->As<ColumnEnum16>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          std::string_view name = enum16_col->NameAt(i);
-          ErlNifBinary bin;
-          enif_alloc_binary(name.size(), &bin);
-          std::memcpy(bin.data, name.data(), name.size());
-          column_values.push_back(enif_make_binary(env, &bin));
-        }
-      } else if (auto lc_col = col->As<ColumnLowCardinality>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          auto item = lc_col->GetItem(i);
-          if (item.type == Type::String) {
-            auto val = item.get<std::string_view>();
-            ErlNifBinary bin;
-            enif_alloc_binary(val.size(), &bin);
-            std::memcpy(bin.data, val.data(), val.size());
-            column_values.push_back(enif_make_binary(env, &bin));
-          } else if (item.type == Type::Void) {
-            column_values.push_back(enif_make_atom(env, "nil"));
-          } else {
-            throw std::runtime_error("Unsupported LowCardinality inner type");
-          }
-        }
-      } else if (auto nullable_col = col->As<ColumnNullable>()) {
-        auto nested = nullable_col->Nested();
-
-        // Optimized: Check nested type ONCE outside loop, then direct extraction
-        if (auto uint64_col = nested->As<ColumnUInt64>()) {
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              column_values.push_back(enif_make_uint64(env, uint64_col->At(i)));
-            }
-          }
-        } else if (auto int64_col = nested->As<ColumnInt64>()) {
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              column_values.push_back(enif_make_int64(env, int64_col->At(i)));
-            }
-          }
-        } else if (auto float64_col = nested->As<ColumnFloat64>()) {
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              column_values.push_back(enif_make_double(env, float64_col->At(i)));
-            }
-          }
-        } else if (auto string_col = nested->As<ColumnString>()) {
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              std::string_view val_view = string_col->At(i);
-              ErlNifBinary bin;
-              enif_alloc_binary(val_view.size(), &bin);
-              std::memcpy(bin.data, val_view.data(), val_view.size());
-              column_values.push_back(enif_make_binary(env, &bin));
-            }
-          }
-        } else {
-          // Fallback for complex/uncommon types: use Slice approach
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              auto single_value_col = nested->Slice(i, 1);
-              ERL_NIF_TERM elem_list = column_to_elixir_list(env, single_value_col);
-              ERL_NIF_TERM head, tail;
-              if (enif_get_list_cell(env, elem_list, &head, &tail)) {
-                column_values.push_back(head);
-              } else {
-                column_values.push_back(enif_make_atom(env, "error"));
-              }
-            }
-          }
-        }
+      const ERL_NIF_TERM *column_values = col_data[c];
+      for (size_t r = row_count; r-- > 0;) {
+        lists[c] = enif_make_list_cell(env, column_values[r], lists[c]);
       }
-
-      // Append this block's column values to accumulated data (indexed access - O(1))
-      all_columns[c].insert(
-        all_columns[c].end(),
-        column_values.begin(),
-        column_values.end()
-      );
     }
-  });
+    result = enif_make_tuple_from_array(env, lists.data(), lists.size());
+  }
 
-  // Build Elixir map: %{column_name => [values]}
-  // Atoms already created during first block processing
-  size_t num_columns = all_columns.size();
-  std::vector<ERL_NIF_TERM> values;
-  values.reserve(num_columns);
+  blocks.pop_back();
+  return result;
+}
+
+ERL_NIF_TERM ResultBuffer::finish(ErlNifEnv *env, ERL_NIF_TERM acc) {
+  if (shape == ResultShape::Rows) {
+    return acc;
+  }
 
-  for (size_t c = 0; c < num_columns; c++) {
-    values.push_back(enif_make_list_from_array(env, all_columns[c].data(), all_columns[c].size()));
+  const auto &keys = column_keys(env);
+  if (shape == ResultShape::Tuples) {
+    ERL_NIF_TERM names = enif_make_list_from_array(env, keys.data(), keys.size());
+    return enif_make_tuple2(env, names, acc);
   }
 
+  int arity;
+  const ERL_NIF_TERM *lists;
+  enif_get_tuple(env, acc, &arity, &lists);
+
   ERL_NIF_TERM columns_map;
-  enif_make_map_from_arrays(env, key_atoms.data(), values.data(), num_columns, &columns_map);
+  enif_make_map_from_arrays(env, keys.data(), lists, arity, &columns_map);
+  return columns_map;
+}
 
-  return ColumnarResult(columns_map);
+FINE_RESOURCE(ResultBuffer);
+
+// Raise %RuntimeError{message: message}, like FINE does for exceptions
+// thrown from a FINE_NIF. Continuations scheduled with enif_schedule_nif run
+// outside FINE's wrapper, so they raise through this instead.
+ERL_NIF_TERM raise_runtime_error(ErlNifEnv *env, const char *message) {
+  ERL_NIF_TERM keys[] = {
+      enif_make_atom(env, "__struct__"),
+      enif_make_atom(env, "__exception__"),
+      enif_make_atom(env, "message")};
+  ERL_NIF_TERM values[] = {
+      enif_make_atom(env, "Elixir.RuntimeError"),
+      enif_make_atom(env, "true"),
+      make_binary_term(env, message)};
+
+  ERL_NIF_TERM exception;
+  enif_make_map_from_arrays(env, keys, values, 3, &exception);
+  return enif_raise_exception(env, exception);
 }
 
-FINE_NIF(client_select_cols, 0);
+ERL_NIF_TERM build_result_step(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]);
 
-// Execute parameterized SELECT query and return columnar format
-ColumnarResult client_select_cols_parameterized(
+// Turn a buffered result into its term. A result of one block is converted
+// directly; larger ones are converted one block per build_result_step call,
+// each rescheduled on a dirty CPU scheduler, so the conversion yields between
+// blocks. The accumulator is carried in the continuation's arguments, which
+// keeps it valid (and visible to the GC) between calls.
+ERL_NIF_TERM build_result(
     ErlNifEnv *env,
-    fine::ResourcePtr<Client> client,
-    fine::ResourcePtr<Query> query) {
-
-  // Pre-create column structure on first block (indexed vectors for O(1) access)
-  std::vector<std::string> col_names;
-  std::vector<ERL_NIF_TERM> key_atoms;
-  std::vector<std::vector<ERL_NIF_TERM>> all_columns;
-  bool first_block = true;
-
-  // Set callback on the Query object before calling Select
-  query->OnData([&](const Block &block) {
-    size_t col_count = block.GetColumnCount();
-    size_t row_count = block.GetRowCount();
-
-    if (row_count == 0) {
-      return;
+    fine::ResourcePtr<ResultBuffer> buffer,
+    ERL_NIF_TERM acc) {
+  if (buffer->blocks.size() <= 1) {
+    while (!buffer->blocks.empty()) {
+      acc = buffer->consume_last(env, acc);
     }
+    return buffer->finish(env, acc);
+  }
 
-    // Initialize column structure on first block
-    if (first_block) {
-      col_names.reserve(col_count);
-      key_atoms.reserve(col_count);
-      all_columns.reserve(col_count);
+  ERL_NIF_TERM args[] = {fine::encode(env, buffer), acc};
+  return enif_schedule_nif(
+      env, "build_result_step", ERL_NIF_DIRTY_JOB_CPU_BOUND, build_result_step, 2, args);
+}
 
-      for (size_t c = 0; c < col_count; c++) {
-        std::string col_name = block.GetColumnName(c);
-        col_names.push_back(col_name);
-        key_atoms.push_back(enif_make_atom(env, col_name.c_str()));
-
-        // Estimate capacity: assume 10 blocks total (heuristic)
-        std::vector<ERL_NIF_TERM> col_vec;
-        col_vec.reserve(row_count * 10);
-        all_columns.push_back(std::move(col_vec));
-      }
+ERL_NIF_TERM build_result_step(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  try {
+    auto buffer = fine::decode<fine::ResourcePtr<ResultBuffer>>(env, argv[0]);
+    ERL_NIF_TERM acc = buffer->consume_last(env, argv[1]);
+    return build_result(env, buffer, acc);
+  } catch (const std::exception &e) {
+    return raise_runtime_error(env, e.what());
+  }
+}
 
-      first_block = false;
-    }
+// Run a SELECT into a fresh buffer and build its result. `select` receives
+// the locked client and the Select callback; the client is unlocked again
+// before the result is built.
+template <typename SelectFn>
+fine::Term select_into_buffer(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> &client,
+    ResultShape shape,
+    SelectFn select) {
+  auto buffer = fine::make_resource<ResultBuffer>(shape, DecodeOptions{});
+  {
+    auto session = client->locked();
+    buffer->opts = session.options();
+    select(session, [&](const Block &block) { (*buffer)(block); });
+  }
+  return fine::Term(build_result(env, buffer, buffer->initial_acc(env)));
+}
 
-    // Extract each column's data using index-based access
-    for (size_t c = 0; c < col_count; c++) {
-      ColumnRef col = block[c];
-      std::vector<ERL_NIF_TERM> column_values;
-      column_values.reserve(row_count);
-
-      // Extract column data based on type (reuse logic from client_select_cols)
-      if (auto uint64_col = col->As<ColumnUInt64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, uint64_col->At(i)));
-        }
-      } else if (auto uint32_col = col->As<ColumnUInt32>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, uint32_col->At(i)));
-        }
-      } else if (auto uint16_col = col->As<ColumnUInt16>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, uint16_col->At(i)));
-        }
-      } else if (auto uint8_col = col->As<ColumnUInt8>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, uint8_col->At(i)));
-        }
-      } else if (auto int64_col = col->As<ColumnInt64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, int64_col->At(i)));
-        }
-      } else if (auto int32_col = col->As<ColumnInt32>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, int32_col->At(i)));
-        }
-      } else if (auto int16_col = col->As<ColumnInt16>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, int16_col->At(i)));
-        }
-      } else if (auto int8_col = col->As<ColumnInt8>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, int8_col->At(i)));
-        }
-      } else if (auto float64_col = col->As<ColumnFloat64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_double(env, float64_col->At(i)));
-        }
-      } else if (auto float32_col = col->As<ColumnFloat32>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_double(env, float32_col->At(i)));
-        }
-      } else if (auto string_col = col->As<ColumnString>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          std::string_view val_view = string_col->At(i);
-          ErlNifBinary bin;
-          enif_alloc_binary(val_view.size(), &bin);
-          std::memcpy(bin.data, val_view.data(), val_view.size());
-          column_values.push_back(enif_make_binary(env, &bin));
-        }
-      } else if (auto datetime_col = col->As<ColumnDateTime>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, datetime_col->At(i)));
-        }
-      } else if (auto datetime64_col = col->As<ColumnDateTime64>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_int64(env, datetime64_col->At(i)));
-        }
-      } else if (auto date_col = col->As<ColumnDate>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          column_values.push_back(enif_make_uint64(env, date_col->RawAt(i)));
-        }
-      } else if (auto uuid_col = col->As<ColumnUUID>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          UUID uuid = uuid_col->At(i);
-          char uuid_buf[37];
-          format_uuid_to_buffer(uuid, uuid_buf);
-          ErlNifBinary bin;
-          enif_alloc_binary(36, &bin);
-          std::memcpy(bin.data, uuid_buf, 36);
-          column_values.push_back(enif_make_binary(env, &bin));
-        }
-      } else if (auto decimal_col = col->As<ColumnDecimal>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          Int128 value = decimal_col->At(i);
-          int64_t scaled_value = static_cast<int64_t>(value);
-          column_values.push_back(enif_make_int64(env, scaled_value));
-        }
-      } else if (auto array_col = col->As<ColumnArray>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          auto nested = array_col->GetAsColumn(i);
-          column_values.push_back(column_to_elixir_list(env, nested));
-        }
-      } else if (auto map_col = col->As<ColumnMap>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          auto kv_tuples = map_col->GetAsColumn(i);
-          if (auto tuple_col = kv_tuples->As<ColumnTuple>()) {
-            auto keys_col = tuple_col->At(0);
-            auto values_col = tuple_col->At(1);
-            size_t map_size = keys_col->Size();
-
-            std::vector<ERL_NIF_TERM> key_terms;
-            std::vector<ERL_NIF_TERM> value_terms;
-            key_terms.reserve(map_size);
-            value_terms.reserve(map_size);
-
-            ERL_NIF_TERM keys_list = column_to_elixir_list(env, keys_col);
-            ERL_NIF_TERM key_tail = keys_list;
-            for (size_t j = 0; j < map_size; j++) {
-              ERL_NIF_TERM key;
-              if (enif_get_list_cell(env, key_tail, &key, &key_tail)) {
-                key_terms.push_back(key);
-              }
-            }
-
-            ERL_NIF_TERM values_list = column_to_elixir_list(env, values_col);
-            ERL_NIF_TERM value_tail = values_list;
-            for (size_t j = 0; j < map_size; j++) {
-              ERL_NIF_TERM value;
-              if (enif_get_list_cell(env, value_tail, &value, &value_tail)) {
-                value_terms.push_back(value);
-              }
-            }
-
-            ERL_NIF_TERM elixir_map;
-            enif_make_map_from_arrays(env, key_terms.data(), value_terms.data(), map_size, &elixir_map);
-
-            column_values.push_back(elixir_map);
-          } else {
-            column_values.push_back(enif_make_new_map(env));
-          }
-        }
-      } else if (auto tuple_col = col->As<ColumnTuple>()) {
-        size_t tuple_size = tuple_col->TupleSize();
-
-        std::vector<std::vector<ERL_NIF_TERM>> element_columns;
-        element_columns.reserve(tuple_size);
-
-        for (size_t j = 0; j < tuple_size; j++) {
-          auto element_col = tuple_col->At(j);
-          ERL_NIF_TERM elem_list = column_to_elixir_list(env, element_col);
-          std::vector<ERL_NIF_TERM> elem_vec;
-          elem_vec.reserve(row_count);
-          ERL_NIF_TERM tail = elem_list;
-          for (size_t i = 0; i < row_count; i++) {
-            ERL_NIF_TERM head;
-            if (enif_get_list_cell(env, tail, &head, &tail)) {
-              elem_vec.push_back(head);
-            } else {
-              elem_vec.push_back(enif_make_atom(env, "error"));
-            }
-          }
-          element_columns.push_back(std::move(elem_vec));
-        }
-
-        for (size_t i = 0; i < row_count; i++) {
-          std::vector<ERL_NIF_TERM> tuple_elements;
-          tuple_elements.reserve(tuple_size);
-          for (size_t j = 0; j < tuple_size; j++) {
-            tuple_elements.push_back(element_columns[j][i]);
-          }
-          column_values.push_back(enif_make_tuple_from_array(env, tuple_elements.data(), tuple_elements.size()));
-        }
-      } else if (auto enum8_col = col->As<ColumnEnum8>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          std::string_view name = enum8_col->NameAt(i);
-          ErlNifBinary bin;
-          enif_alloc_binary(name.size(), &bin);
-          std::memcpy(bin.data, name.data(), name.size());
-          column_values.push_back(enif_make_binary(env, &bin));
-        }
-      } else if (auto enum16_col = col->As<ColumnEnum16>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          std::string_view name = enum16_col->NameAt(i);
-          ErlNifBinary bin;
-          enif_alloc_binary(name.size(), &bin);
-          std::memcpy(bin.data, name.data(), name.size());
-          column_values.push_back(enif_make_binary(env, &bin));
-        }
-      } else if (auto lc_col = col->As<ColumnLowCardinality>()) {
-        for (size_t i = 0; i < row_count; i++) {
-          auto item = lc_col->GetItem(i);
-          if (item.type == Type::String) {
-            auto val = item.get<std::string_view>();
-            ErlNifBinary bin;
-            enif_alloc_binary(val.size(), &bin);
-            std::memcpy(bin.data, val.data(), val.size());
-            column_values.push_back(enif_make_binary(env, &bin));
-          } else if (item.type == Type::Void) {
-            column_values.push_back(enif_make_atom(env, "nil"));
-          } else {
-            throw std::runtime_error("Unsupported LowCardinality inner type");
-          }
-        }
-      } else if (auto nullable_col = col->As<ColumnNullable>()) {
-        auto nested = nullable_col->Nested();
-
-        if (auto uint64_col = nested->As<ColumnUInt64>()) {
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              column_values.push_back(enif_make_uint64(env, uint64_col->At(i)));
-            }
-          }
-        } else if (auto int64_col = nested->As<ColumnInt64>()) {
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              column_values.push_back(enif_make_int64(env, int64_col->At(i)));
-            }
-          }
-        } else if (auto float64_col = nested->As<ColumnFloat64>()) {
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              column_values.push_back(enif_make_double(env, float64_col->At(i)));
-            }
-          }
-        } else if (auto string_col = nested->As<ColumnString>()) {
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              std::string_view val_view = string_col->At(i);
-              ErlNifBinary bin;
-              enif_alloc_binary(val_view.size(), &bin);
-              std::memcpy(bin.data, val_view.data(), val_view.size());
-              column_values.push_back(enif_make_binary(env, &bin));
-            }
-          }
-        } else {
-          // Fallback for complex/uncommon types
-          for (size_t i = 0; i < row_count; i++) {
-            if (nullable_col->IsNull(i)) {
-              column_values.push_back(enif_make_atom(env, "nil"));
-            } else {
-              auto single_value_col = nested->Slice(i, 1);
-              ERL_NIF_TERM elem_list = column_to_elixir_list(env, single_value_col);
-              ERL_NIF_TERM head, tail;
-              if (enif_get_list_cell(env, elem_list, &head, &tail)) {
-                column_values.push_back(head);
-              } else {
-                column_values.push_back(enif_make_atom(env, "error"));
-              }
-            }
-          }
-        }
-      }
+// All SELECT NIFs block in client->Select for the duration of the query, so
+// they are registered on dirty I/O schedulers. Terms are built once the
+// query has finished, yielding between blocks (see build_result).
 
-      // Append this block's column values to accumulated data
-      all_columns[c].insert(
-        all_columns[c].end(),
-        column_values.begin(),
-        column_values.end()
-      );
-    }
+// Execute SELECT query and return list of maps
+fine::Term client_select(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string query) {
+  return select_into_buffer(env, client, ResultShape::Rows, [&](auto &session, auto on_block) {
+    session->Select(query, on_block);
   });
-  // Execute the query with the configured callback
-  client->Select(*query);
-
+}
 
-  // Build Elixir map: %{column_name => [values]}
-  size_t num_columns = all_columns.size();
-  std::vector<ERL_NIF_TERM> values;
-  values.reserve(num_columns);
+FINE_NIF(client_select, ERL_NIF_DIRTY_JOB_IO_BOUND);
 
-  for (size_t c = 0; c < num_columns; c++) {
-    values.push_back(enif_make_list_from_array(env, all_columns[c].data(), all_columns[c].size()));
-  }
+// Execute parameterized SELECT query and return list of maps
+fine::Term client_select_parameterized(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query) {
+  return select_into_buffer(env, client, ResultShape::Rows, [&](auto &session, auto on_block) {
+    // Set callback on the Query object before calling Select, and don't
+    // leave it behind pointing at this call's buffer
+    query->OnData(on_block);
+    try {
+      session->Select(*query);
+    } catch (...) {
+      query->OnData(nullptr);
+      throw;
+    }
+    query->OnData(nullptr);
+  });
+}
 
-  ERL_NIF_TERM columns_map;
-  enif_make_map_from_arrays(env, key_atoms.data(), values.data(), num_columns, &columns_map);
+FINE_NIF(client_select_parameterized, ERL_NIF_DIRTY_JOB_IO_BOUND);
 
-  return ColumnarResult(columns_map);
+// Execute SELECT query and return columnar format: %{column_name => [values]}
+fine::Term client_select_cols(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string query) {
+  return select_into_buffer(env, client, ResultShape::Columns, [&](auto &session, auto on_block) {
+    session->Select(query, on_block);
+  });
 }
 
-FINE_NIF(client_select_cols_parameterized, 0);
+FINE_NIF(client_select_cols, ERL_NIF_DIRTY_JOB_IO_BOUND);
+
+// Execute parameterized SELECT query and return columnar format
+fine::Term client_select_cols_parameterized(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query) {
+  return select_into_buffer(env, client, ResultShape::Columns, [&](auto &session, auto on_block) {
+    // Set callback on the Query object before calling Select, and don't
+    // leave it behind pointing at this call's buffer
+    query->OnData(on_block);
+    try {
+      session->Select(*query);
+    } catch (...) {
+      query->OnData(nullptr);
+      throw;
+    }
+    query->OnData(nullptr);
+  });
+}
 
+FINE_NIF(client_select_cols_parameterized, ERL_NIF_DIRTY_JOB_IO_BOUND);
@@ -0,0 +1,404 @@
+// stream.cpp - Streaming SELECT support
+//
+// Instead of accumulating the whole result, every Block the server sends is
+// converted to %{column_name => [values]} and delivered to a consumer process
+// as its own message:
+//
+//   {tag, {:block, columns_map}}
+//
+// The query runs on the client's worker thread like any other async job (see
+// async.h), under a QueryControl for its deadline and cancellation, and
+// replies {ref, {:ok, {:ok | :cancelled, stats}}} once the last block has
+// been sent.
+//
+// Backpressure is credit based. A StreamResource starts with `window` credits;
+// sending a block consumes one and the consumer returns it with stream_ack/1
+// after it has processed the block. When credits run out the SELECT callback
+// blocks (on the worker thread), which stops reading from the socket and
+// lets TCP flow control push back on the server. Memory held by the consumer
+// is therefore bounded by window * block size instead of the result size.
+//
+// stream_cancel/1 (or the consumer exiting) makes the next callback return
+// false, which cancels the query server-side and leaves the connection usable.
+
+#include <fine.hpp>
+#include <clickhouse/client.h>
+#include <clickhouse/query.h>
+#include <clickhouse/block.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async.h"
+#include "client_resource.h"
+#include "columnar.h"
+#include "query_control.h"
+#include "query_stats.h"
+
+using namespace clickhouse;
+
+// Credit window shared between the streaming SELECT and the consumer
+struct StreamResource {
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint64_t credits;
+  // Received blocks that may wait to be converted (see PrefetchSender); 0
+  // converts each block in the Select callback
+  uint64_t prefetch;
+  bool cancelled = false;
+
+  StreamResource(uint64_t window, uint64_t prefetch) : credits(window), prefetch(prefetch) {}
+
+  // Block until a credit is available. Returns false if the stream was
+  // cancelled, the consumer process has exited or `control` says stop.
+  // `env` must be process independent (enif_is_process_alive), as this runs
+  // on native threads.
+  bool acquire(ErlNifEnv *env, ErlNifPid *consumer, const QueryControl &control) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (credits == 0 && !cancelled) {
+      // Wake up periodically so a consumer that died without cancelling, or
+      // the query's deadline, doesn't leave the connection blocked forever
+      if (cv.wait_for(lock, std::chrono::milliseconds(100)) == std::cv_status::timeout) {
+        if (!enif_is_process_alive(env, consumer)) {
+          cancelled = true;
+        } else if (control.should_stop()) {
+          return false;
+        }
+      }
+    }
+
+    if (cancelled) {
+      return false;
+    }
+
+    credits--;
+    return true;
+  }
+
+  void release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    credits++;
+    cv.notify_one();
+  }
+
+  void cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+    cv.notify_one();
+  }
+
+  bool is_cancelled() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cancelled;
+  }
+};
+
+FINE_RESOURCE(StreamResource);
+
+// ============================================================================
+// Stream Control
+// ============================================================================
+
+/// Creates a stream with `window` blocks allowed in flight before acks, and
+/// up to `prefetch` received blocks waiting to be converted
+fine::ResourcePtr<StreamResource> stream_create(
+    ErlNifEnv *env,
+    uint64_t window,
+    uint64_t prefetch) {
+  if (window == 0) {
+    throw std::invalid_argument("Stream window must be at least 1");
+  }
+  return fine::make_resource<StreamResource>(window, prefetch);
+}
+FINE_NIF(stream_create, 0);
+
+/// Returns one credit after the consumer has processed a block
+fine::Atom stream_ack(
+    ErlNifEnv *env,
+    fine::ResourcePtr<StreamResource> stream) {
+  stream->release();
+  return fine::Atom("ok");
+}
+FINE_NIF(stream_ack, 0);
+
+/// Stops the stream; the running SELECT is cancelled at the next block
+fine::Atom stream_cancel(
+    ErlNifEnv *env,
+    fine::ResourcePtr<StreamResource> stream) {
+  stream->cancel();
+  return fine::Atom("ok");
+}
+FINE_NIF(stream_cancel, 0);
+
+// ============================================================================
+// Streaming SELECT
+// ============================================================================
+
+// Converts each block into its own message and sends it to the consumer,
+// through a ResultBuffer like a whole result: decode threads, scratch term
+// storage and decode stats apply per block. Returns false to cancel the query. Runs on the worker thread or a
+// PrefetchSender thread, never a scheduler, hence the NULL caller env of
+// enif_send.
+class BlockSender {
+public:
+  BlockSender(
+      StreamResource &stream,
+      const QueryControl &control,
+      ErlNifPid consumer,
+      ERL_NIF_TERM tag,
+      const DecodeOptions &opts,
+      QueryStats &stats)
+      : opts_(opts),
+        stats_(stats),
+        stream_(stream),
+        control_(control),
+        consumer_(consumer),
+        msg_env_(enif_alloc_env()),
+        tag_env_(enif_alloc_env()) {
+    tag_ = enif_make_copy(tag_env_, tag);
+  }
+
+  ~BlockSender() {
+    enif_free_env(msg_env_);
+    enif_free_env(tag_env_);
+  }
+
+  bool operator()(const Block &block) {
+    if (block.GetRowCount() == 0) {
+      return !stream_.is_cancelled();
+    }
+
+    if (!stream_.acquire(tag_env_, &consumer_, control_)) {
+      return false;
+    }
+
+    ResultBuffer buffer(ResultShape::Columns, opts_, &stats_);
+    buffer(block);
+
+    ERL_NIF_TERM payload =
+        enif_make_tuple2(msg_env_, enif_make_atom(msg_env_, "block"), buffer.build(msg_env_));
+    ERL_NIF_TERM msg = enif_make_tuple2(msg_env_, enif_make_copy(msg_env_, tag_), payload);
+
+    // enif_send invalidates msg_env's terms; it is cleared for the next block
+    bool sent = enif_send(NULL, &consumer_, msg_env_, msg);
+    enif_clear_env(msg_env_);
+
+    if (!sent) {
+      stream_.cancel();
+    }
+    return sent;
+  }
+
+private:
+  DecodeOptions opts_;
+  QueryStats &stats_;
+  StreamResource &stream_;
+  const QueryControl &control_;
+  ErlNifPid consumer_;
+  ErlNifEnv *msg_env_;
+  ErlNifEnv *tag_env_;
+  ERL_NIF_TERM tag_;
+};
+
+// Runs a BlockSender on a thread of its own, so that the query's thread
+// goes back to receiving and decompressing block N+1 while block N is
+// converted and sent: the server's send and our decode overlap instead of
+// taking turns. Received blocks wait in a queue of at most `depth`; the
+// Select callback waits while it is full, so memory stays bounded however
+// slow the consumer is (the stream's window still applies to sent blocks).
+class PrefetchSender {
+public:
+  PrefetchSender(BlockSender &sender, StreamResource &stream, size_t depth)
+      : sender_(sender), stream_(stream), depth_(depth), thread_([this] { run(); }) {}
+
+  // Reached without finish() when the query failed: drop the queued blocks,
+  // and cancel the stream so a sender waiting for credits returns
+  ~PrefetchSender() {
+    bool abort;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      abort = !exited_;
+      aborted_ = true;
+      cv_.notify_all();
+    }
+    if (abort) {
+      stream_.cancel();
+    }
+    thread_.join();
+  }
+
+  PrefetchSender(const PrefetchSender &) = delete;
+  PrefetchSender &operator=(const PrefetchSender &) = delete;
+
+  // Select callback: queue the block, waiting for room. Returns false to
+  // cancel the query once the sender has stopped.
+  bool operator()(const Block &block) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return queue_.size() < depth_ || stopped_; });
+    if (stopped_) {
+      return false;
+    }
+    // Copying a Block shares its columns
+    queue_.push_back(block);
+    cv_.notify_all();
+    return true;
+  }
+
+  // Wait until every queued block has been sent, rethrowing what the sender
+  // threw
+  void finish() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    closed_ = true;
+    cv_.notify_all();
+    cv_.wait(lock, [&] { return exited_; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+private:
+  void run() {
+    for (;;) {
+      Block block;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return !queue_.empty() || closed_ || aborted_; });
+        if (aborted_ || queue_.empty()) {
+          break;
+        }
+        block = std::move(queue_.front());
+        queue_.pop_front();
+        cv_.notify_all();
+      }
+
+      bool sent = false;
+      try {
+        sent = sender_(block);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+      }
+      if (!sent) {
+        break;
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+    exited_ = true;
+    queue_.clear();
+    cv_.notify_all();
+  }
+
+  BlockSender &sender_;
+  StreamResource &stream_;
+  size_t depth_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Block> queue_;
+  bool closed_ = false;   // No more blocks, exit once drained
+  bool aborted_ = false;  // Exit now
+  bool stopped_ = false;  // The sender takes no more blocks
+  bool exited_ = false;
+  std::exception_ptr error_;
+
+  // Last, so it starts once everything above is initialized
+  std::thread thread_;
+};
+
+// Run a streaming SELECT until `control` stops it, converting each block in
+// the Select callback or handing it to a PrefetchSender
+void stream_controlled(
+    Client &client,
+    const Query &query,
+    const QueryControl &control,
+    QueryStats &stats,
+    StreamResource &stream,
+    ErlNifPid consumer,
+    ERL_NIF_TERM tag,
+    const DecodeOptions &opts) {
+  BlockSender sender(stream, control, consumer, tag, opts, stats);
+  if (stream.prefetch == 0) {
+    select_controlled(client, query, control, stats, [&](const Block &block) {
+      return sender(block);
+    });
+    return;
+  }
+
+  PrefetchSender prefetch(sender, stream, stream.prefetch);
+  select_controlled(client, query, control, stats, [&](const Block &block) {
+    return prefetch(block);
+  });
+  prefetch.finish();
+}
+
+// The stream's tag, kept in an env of its own until the job runs
+struct StreamTag {
+  ErlNifEnv *env;
+  ERL_NIF_TERM term;
+
+  explicit StreamTag(ERL_NIF_TERM tag) : env(enif_alloc_env()) { term = enif_make_copy(env, tag); }
+  ~StreamTag() { enif_free_env(env); }
+
+  StreamTag(const StreamTag &) = delete;
+  StreamTag &operator=(const StreamTag &) = delete;
+};
+
+/// Streaming SELECT on the client's worker thread: sends each block as
+/// {tag, {:block, columns_map}} to `consumer` and replies
+/// {ref, {:ok, {:ok | :cancelled, stats}}}, :cancelled when the consumer
+/// stopped the stream early. enif_send queues each block on the consumer
+/// before the reply is sent, so the status the connection forwards on the
+/// reply always arrives after the last block.
+fine::Atom client_select_cols_stream_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    std::string query,
+    fine::ResourcePtr<QueryControl> control,
+    fine::ResourcePtr<StreamResource> stream,
+    ErlNifPid consumer,
+    fine::Term tag,
+    ErlNifPid pid,
+    fine::Term ref) {
+  auto stream_tag = std::make_shared<StreamTag>(tag);
+  run_async(client, pid, ref, [query, control, stream, consumer, stream_tag](
+                                  ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    Query select(query);
+    stream_controlled(c, select, *control, stats, *stream, consumer, stream_tag->term, opts);
+    return stats.with_result(msg_env, enif_make_atom(msg_env, stream->is_cancelled() ? "cancelled" : "ok"));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_cols_stream_async, 0);
+
+/// Parameterized variant of client_select_cols_stream_async
+fine::Atom client_select_cols_stream_parameterized_async(
+    ErlNifEnv *env,
+    fine::ResourcePtr<ClientResource> client,
+    fine::ResourcePtr<Query> query,
+    fine::ResourcePtr<QueryControl> control,
+    fine::ResourcePtr<StreamResource> stream,
+    ErlNifPid consumer,
+    fine::Term tag,
+    ErlNifPid pid,
+    fine::Term ref) {
+  auto stream_tag = std::make_shared<StreamTag>(tag);
+  run_async(client, pid, ref, [query, control, stream, consumer, stream_tag](
+                                  ErlNifEnv *msg_env, Client &c, const DecodeOptions &opts) {
+    QueryStats stats;
+    stream_controlled(c, *query, *control, stats, *stream, consumer, stream_tag->term, opts);
+    return stats.with_result(msg_env, enif_make_atom(msg_env, stream->is_cancelled() ? "cancelled" : "ok"));
+  });
+  return fine::Atom("ok");
+}
+FINE_NIF(client_select_cols_stream_parameterized_async, 0);
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <fine.hpp>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// TermScratch - reusable term vectors for decoding blocks
+//
+// Decoding a block needs a vector of terms per column, and per nested level
+// of Array, Tuple and Map columns, that only lives until the block's lists
+// or maps are built. Each thread that decodes (dirty schedulers, client
+// workers, DecodePool threads) keeps the vectors it has finished with and
+// hands them out again, so after the first block of a query those vectors
+// come back with their capacity and the decode loop stops calling malloc.
+//
+// What a thread keeps is bounded: at most kMaxVectors vectors and
+// kMaxRetainedBytes of capacity. Anything beyond that is freed on release,
+// so one huge result doesn't pin its scratch memory for the life of the VM.
+class TermScratch {
+public:
+  static constexpr size_t kMaxVectors = 64;
+  static constexpr size_t kMaxRetainedBytes = 8 * 1024 * 1024;
+
+  static TermScratch &local() {
+    thread_local TermScratch scratch;
+    return scratch;
+  }
+
+  // An empty vector with room for at least `capacity` terms, reusing a kept
+  // one when possible (the first large enough, else the most recent)
+  std::vector<ERL_NIF_TERM> take(size_t capacity) {
+    std::vector<ERL_NIF_TERM> terms;
+    if (!free_.empty()) {
+      size_t pick = free_.size() - 1;
+      for (size_t i = 0; i < free_.size(); i++) {
+        if (free_[i].capacity() >= capacity) {
+          pick = i;
+          break;
+        }
+      }
+      terms = std::move(free_[pick]);
+      free_[pick] = std::move(free_.back());
+      free_.pop_back();
+      retained_bytes_ -= bytes(terms);
+    }
+    terms.clear();
+    terms.reserve(capacity);
+    return terms;
+  }
+
+  // Keep `terms` for reuse, or free it if this thread already keeps enough
+  void give(std::vector<ERL_NIF_TERM> &&terms) {
+    size_t size = bytes(terms);
+    if (size == 0 || free_.size() >= kMaxVectors ||
+        retained_bytes_ + size > kMaxRetainedBytes) {
+      return;
+    }
+    retained_bytes_ += size;
+    free_.push_back(std::move(terms));
+  }
+
+private:
+  static size_t bytes(const std::vector<ERL_NIF_TERM> &terms) {
+    return terms.capacity() * sizeof(ERL_NIF_TERM);
+  }
+
+  std::vector<std::vector<ERL_NIF_TERM>> free_;
+  size_t retained_bytes_ = 0;
+};
+
+// A vector of terms borrowed from the current thread's TermScratch and given
+// back when it goes out of scope. Must be released on the thread that took
+// it, which holds for every decode path (parallel column decodes take their
+// vectors on the pool thread that runs them).
+struct ScratchTerms {
+  std::vector<ERL_NIF_TERM> terms;
+
+  explicit ScratchTerms(size_t capacity = 0) : terms(TermScratch::local().take(capacity)) {}
+  ~ScratchTerms() { TermScratch::local().give(std::move(terms)); }
+
+  ScratchTerms(ScratchTerms &&) = default;
+  ScratchTerms(const ScratchTerms &) = delete;
+  ScratchTerms &operator=(const ScratchTerms &) = delete;
+};
@@ -0,0 +1,108 @@
+defmodule Natch.ArrowSelectTest do
+  use ExUnit.Case, async: true
+
+  @schema 1
+  @dictionary_batch 2
+  @record_batch 3
+
+  setup do
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+
+    on_exit(fn ->
+      if Process.alive?(conn), do: Process.exit(conn, :normal)
+    end)
+
+    {:ok, conn: conn}
+  end
+
+  # Split an IPC stream into {header_type, metadata, body} messages
+  defp messages(<<0xFFFFFFFF::little-32, 0::little-32>>), do: []
+
+  defp messages(<<0xFFFFFFFF::little-32, size::little-32, rest::binary>>) do
+    assert rem(size, 8) == 0
+    <<meta::binary-size(size), rest::binary>> = rest
+    <<body::binary-size(message_field(meta, 3, 64)), rest::binary>> = rest
+    [{message_field(meta, 1, 8), meta, body} | messages(rest)]
+  end
+
+  # Read scalar field `id` of the flatbuffer's root table (the Message)
+  defp message_field(meta, id, bits) do
+    <<root::little-32, _::binary>> = meta
+    <<_::binary-size(root), to_vtable::little-signed-32, _::binary>> = meta
+    <<_::binary-size(root - to_vtable + 4 + 2 * id), at::little-16, _::binary>> = meta
+    <<_::binary-size(root + at), value::little-size(bits), _::binary>> = meta
+    value
+  end
+
+  defp types(ipc), do: ipc |> messages() |> Enum.map(&elem(&1, 0))
+
+  defp contains?(body, part), do: :binary.match(body, part) != :nomatch
+
+  test "writes numeric columns from many blocks as one record batch", %{conn: conn} do
+    sql = """
+    SELECT number AS n, toInt16(number) - 100 AS i, number / 2 AS f
+    FROM numbers(5000) ORDER BY n SETTINGS max_block_size = 1000
+    """
+
+    assert {:ok, ipc} = Natch.select_arrow(conn, sql)
+    assert [{@schema, schema, _}, {@record_batch, _, body}] = messages(ipc)
+
+    for name <- ["n", "i", "f"], do: assert(contains?(schema, name))
+    assert contains?(body, for(n <- 0..4999, into: <<>>, do: <<n::native-64>>))
+    assert contains?(body, for(n <- 0..4999, into: <<>>, do: <<n - 100::native-signed-16>>))
+    assert contains?(body, for(n <- 0..4999, into: <<>>, do: <<n / 2::native-float-64>>))
+  end
+
+  test "writes strings, nullable values and arrays", %{conn: conn} do
+    sql = """
+    SELECT toString(number) AS s,
+           if(number % 3 = 0, NULL, number) AS nn,
+           [number, number * 10] AS arr
+    FROM numbers(4) ORDER BY number
+    """
+
+    assert {:ok, ipc} = Natch.select_arrow(conn, sql)
+    assert [{@schema, _, _}, {@record_batch, _, body}] = messages(ipc)
+
+    assert contains?(body, "0123")
+    # Validity of nn: rows 1 and 2 are set, row 0 and row 3 are null
+    assert contains?(body, <<0b0110, 0::56>>)
+    # List offsets and elements of arr
+    assert contains?(body, for(n <- [0, 2, 4, 6, 8], into: <<>>, do: <<n::native-signed-64>>))
+    elements = [0, 0, 1, 10, 2, 20, 3, 30]
+    assert contains?(body, for(n <- elements, into: <<>>, do: <<n::native-64>>))
+  end
+
+  test "writes LowCardinality columns as dictionaries", %{conn: conn} do
+    sql = """
+    SELECT toLowCardinality(if(number % 2 = 0, 'even', 'odd')) AS lc
+    FROM numbers(6) ORDER BY number SETTINGS max_block_size = 2
+    """
+
+    assert {:ok, ipc} = Natch.select_arrow(conn, sql)
+
+    assert [{@schema, _, _}, {@dictionary_batch, _, dictionary}, {@record_batch, _, body}] =
+             messages(ipc)
+
+    assert contains?(dictionary, "evenodd")
+    assert contains?(body, for(i <- [0, 1, 0, 1, 0, 1], into: <<>>, do: <<i::native-signed-32>>))
+  end
+
+  test "keeps the schema of empty results", %{conn: conn} do
+    assert {:ok, ipc} = Natch.select_arrow(conn, "SELECT 1 AS x WHERE 0")
+    assert [{@schema, schema, _}, {@record_batch, _, _}] = messages(ipc)
+    assert contains?(schema, "x")
+  end
+
+  test "rejects column types without an Arrow mapping", %{conn: conn} do
+    assert {:error, _} = Natch.select_arrow(conn, "SELECT generateUUIDv4() AS u")
+    assert {:ok, _} = Natch.select_arrow(conn, "SELECT 1 AS x")
+  end
+
+  test "runs parameterized queries", %{conn: conn} do
+    query = Natch.Query.new("SELECT {n:UInt32} AS n") |> Natch.Query.bind(:n, 7)
+
+    assert {:ok, ipc} = Natch.select_arrow(conn, query)
+    assert types(ipc) == [@schema, @record_batch]
+  end
+end
@@ -0,0 +1,191 @@
+defmodule Natch.AsyncTest do
+  use ExUnit.Case, async: true
+
+  alias Natch.Query
+
+  setup do
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+
+    on_exit(fn ->
+      if Process.alive?(conn), do: Process.exit(conn, :normal)
+    end)
+
+    {:ok, conn: conn}
+  end
+
+  describe "select_cols_async/2" do
+    test "delivers the result as a message", %{conn: conn} do
+      {:ok, ref} = Natch.select_cols_async(conn, "SELECT number AS n FROM numbers(3)")
+
+      assert_receive {^ref, {:ok, %{n: [0, 1, 2]}}}, 5_000
+    end
+
+    test "works with parameterized queries", %{conn: conn} do
+      query =
+        Query.new("SELECT number AS n FROM numbers(10) WHERE number < {max:UInt64}")
+        |> Query.bind(:max, 2)
+
+      {:ok, ref} = Natch.select_cols_async(conn, query)
+
+      assert {:ok, %{n: [0, 1]}} = Natch.await(ref)
+    end
+
+    test "delivers query errors", %{conn: conn} do
+      {:ok, ref} = Natch.select_cols_async(conn, "SELECT * FROM nonexistent_table")
+
+      assert {:error, %{type: "server"}} = Natch.await(ref)
+    end
+  end
+
+  describe "select_rows_async/2" do
+    test "delivers rows", %{conn: conn} do
+      {:ok, ref} = Natch.select_rows_async(conn, "SELECT 1 AS a, 'x' AS b")
+
+      assert {:ok, [%{a: 1, b: "x"}]} = Natch.await(ref)
+    end
+
+    test "results of queued queries arrive in order", %{conn: conn} do
+      refs =
+        for i <- 1..5 do
+          {:ok, ref} = Natch.select_rows_async(conn, "SELECT #{i} AS i")
+          ref
+        end
+
+      assert Enum.map(refs, &Natch.await/1) == Enum.map(1..5, &{:ok, [%{i: &1}]})
+    end
+  end
+
+  describe "await/2" do
+    test "times out" do
+      assert {:error, :timeout} = Natch.await(make_ref(), 10)
+    end
+  end
+
+  describe "connection mailbox" do
+    test "stays responsive while a query runs", %{conn: conn} do
+      {:ok, ref} = Natch.select_cols_async(conn, "SELECT sleep(1) AS s")
+
+      {micros, {:ok, _client}} = :timer.tc(fn -> Natch.Connection.get_client(conn) end)
+
+      assert micros < 500_000
+      assert {:ok, %{s: [0]}} = Natch.await(ref)
+    end
+
+    test "a reset queues behind a running query", %{conn: conn} do
+      {:ok, ref} = Natch.select_cols_async(conn, "SELECT sleep(1) AS s")
+      reset = Task.async(fn -> Natch.reset(conn) end)
+      Process.sleep(100)
+
+      {micros, {:ok, _client}} = :timer.tc(fn -> Natch.Connection.get_client(conn) end)
+
+      assert micros < 500_000
+      assert {:ok, %{s: [0]}} = Natch.await(ref)
+      assert :ok = Task.await(reset)
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "synchronous calls still work", %{conn: conn} do
+      assert :ok = Natch.ping(conn)
+      assert :ok = Natch.execute(conn, "SELECT 1")
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+      assert {:error, _} = Natch.select_cols(conn, "INVALID SQL SYNTAX")
+      assert :ok = Natch.ping(conn)
+    end
+  end
+
+  describe "cancellation and deadlines" do
+    # Runs for minutes unless stopped, reporting progress as it goes
+    @long_query "SELECT sum(number) AS s FROM numbers(100000000000)"
+
+    test "cancel/2 stops a running query", %{conn: conn} do
+      {:ok, ref} = Natch.select_cols_async(conn, @long_query)
+      Process.sleep(200)
+
+      assert :ok = Natch.cancel(conn, ref)
+      assert {:error, :cancelled} = Natch.await(ref, 10_000)
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "cancelling an unknown or finished query is a no-op", %{conn: conn} do
+      {:ok, ref} = Natch.select_cols_async(conn, "SELECT 1 AS x")
+      assert {:ok, %{x: [1]}} = Natch.await(ref)
+
+      assert :ok = Natch.cancel(conn, ref)
+      assert :ok = Natch.cancel(conn, make_ref())
+    end
+
+    test "await/3 cancels a query that times out and drops its result", %{conn: conn} do
+      {:ok, ref} = Natch.select_cols_async(conn, @long_query)
+
+      assert {:error, :timeout} = Natch.await(conn, ref, 200)
+      refute_received {^ref, _}
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "a query past its deadline returns :timeout", %{conn: conn} do
+      {:ok, ref} = Natch.select_rows_async(conn, @long_query, timeout: 300)
+
+      assert {:error, :timeout} = Natch.await(ref, 10_000)
+      assert {:ok, [%{x: 1}]} = Natch.select_rows(conn, "SELECT 1 AS x")
+    end
+
+    test ":query_timeout applies to synchronous queries" do
+      {:ok, conn} = Natch.start_link(host: "localhost", port: 9000, query_timeout: 300)
+
+      assert {:error, :timeout} = Natch.select_cols(conn, @long_query)
+      assert {:error, :timeout} = Natch.execute(conn, "SELECT count() FROM (#{@long_query})")
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+
+      GenServer.stop(conn)
+    end
+
+    test "invalid timeouts raise without crashing the connection", %{conn: conn} do
+      for timeout <- [0, -1, 1.5, :never] do
+        assert_raise ArgumentError, fn ->
+          Natch.select_cols_async(conn, "SELECT 1", timeout: timeout)
+        end
+      end
+
+      assert_raise ArgumentError, fn ->
+        conn |> Natch.stream_cols("SELECT 1", timeout: 0) |> Enum.to_list()
+      end
+
+      assert_raise ArgumentError, fn -> Natch.start_link(query_timeout: 0) end
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "queries of exited callers are cancelled", %{conn: conn} do
+      caller = spawn(fn -> Natch.select_cols(conn, @long_query) end)
+      Process.sleep(200)
+      Process.exit(caller, :kill)
+
+      {micros, result} = :timer.tc(fn -> Natch.select_cols(conn, "SELECT 1 AS x") end)
+
+      assert {:ok, %{x: [1]}} = result
+      assert micros < 10_000_000
+    end
+  end
+
+  test "queries on separate connections overlap" do
+    conns =
+      for _ <- 1..4 do
+        {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+        conn
+      end
+
+    {micros, results} =
+      :timer.tc(fn ->
+        conns
+        |> Enum.map(fn conn ->
+          {:ok, ref} = Natch.select_cols_async(conn, "SELECT sleep(0.5) AS s")
+          ref
+        end)
+        |> Enum.map(&Natch.await/1)
+      end)
+
+    assert Enum.all?(results, &match?({:ok, %{s: [0]}}, &1))
+    assert micros < 1_500_000
+
+    Enum.each(conns, &GenServer.stop/1)
+  end
+end
@@ -162,6 +162,27 @@ defmodule Natch.BlockTest do
       assert :ok = Natch.insert_cols(conn, "#{table}", columns, schema)
     end
 
+    test "can insert packed binary columns", %{conn: conn, table: table} do
+      Natch.execute(conn, """
+      CREATE TABLE #{table} (
+        id UInt64,
+        score Float32
+      ) ENGINE = Memory
+      """)
+
+      schema = [id: :uint64, score: :float32]
+
+      columns = %{
+        id: for(v <- 1..3, into: <<>>, do: <<v::little-unsigned-64>>),
+        score: <<0.5::little-float-32, 1.5::little-float-32, 2.5::little-float-32>>
+      }
+
+      assert :ok = Natch.insert_cols(conn, table, columns, schema)
+
+      assert {:ok, %{id: [1, 2, 3], score: [0.5, 1.5, 2.5]}} =
+               Natch.select_cols(conn, "SELECT id, score FROM #{table} ORDER BY id")
+    end
+
     test "can insert with all supported types", %{conn: conn, table: table} do
       # Create table
       Natch.execute(conn, """
@@ -395,6 +416,120 @@ defmodule Natch.BlockTest do
     end
   end
 
+  describe "Building blocks from rows" do
+    @row_schema [
+      id: :uint64,
+      small: :int8,
+      name: :string,
+      score: :float64,
+      active: :bool,
+      day: :date,
+      at: :datetime,
+      at64: :datetime64,
+      note: {:nullable, :string},
+      tags: {:array, :string}
+    ]
+
+    @rows [
+      %{
+        id: 1,
+        small: -3,
+        name: "Alice",
+        score: 1,
+        active: true,
+        day: ~D[2024-03-01],
+        at: ~U[2024-03-01 10:00:00Z],
+        at64: ~U[2024-03-01 10:00:00.123456Z],
+        note: nil,
+        tags: ["a"]
+      },
+      %{
+        id: 2,
+        small: 4,
+        name: "Bôb",
+        score: 2.5,
+        active: false,
+        day: 19_000,
+        at: DateTime.new!(~D[2024-03-01], ~T[12:00:00], "Etc/UTC"),
+        at64: 1_700_000_000_000_000,
+        note: "hi",
+        tags: []
+      }
+    ]
+
+    setup %{conn: conn, table: table} do
+      :ok =
+        Natch.execute(conn, """
+        CREATE TABLE #{table} (
+          id UInt64, small Int8, name String, score Float64, active Bool, day Date,
+          at DateTime, at64 DateTime64(6), note Nullable(String), tags Array(String)
+        ) ENGINE = Memory
+        """)
+
+      :ok
+    end
+
+    defp select_sorted(conn, table) do
+      {:ok, cols} = Natch.select_cols(conn, "SELECT * FROM #{table} ORDER BY id")
+      cols
+    end
+
+    test "inserts the same values as insert_cols", %{conn: conn, table: table} do
+      :ok = Natch.insert_rows(conn, table, @rows, @row_schema)
+      from_rows = select_sorted(conn, table)
+
+      :ok = Natch.execute(conn, "TRUNCATE TABLE #{table}")
+      columns = Natch.Conversion.rows_to_columns(@rows, @row_schema)
+      :ok = Natch.insert_cols(conn, table, columns, @row_schema)
+
+      assert from_rows == select_sorted(conn, table)
+      assert from_rows.id == [1, 2]
+      assert from_rows.note == [nil, "hi"]
+      assert from_rows.tags == [["a"], []]
+    end
+
+    test "accepts string keys and tuples", %{conn: conn, table: table} do
+      string_rows = Enum.map(@rows, &Map.new(&1, fn {k, v} -> {to_string(k), v} end))
+      :ok = Natch.insert_rows(conn, table, string_rows, @row_schema)
+      expected = select_sorted(conn, table)
+
+      :ok = Natch.execute(conn, "TRUNCATE TABLE #{table}")
+      names = Keyword.keys(@row_schema)
+      tuple_rows = Enum.map(@rows, fn row -> names |> Enum.map(&row[&1]) |> List.to_tuple() end)
+      :ok = Natch.insert_rows(conn, table, tuple_rows, @row_schema)
+
+      assert select_sorted(conn, table) == expected
+    end
+
+    test "accepts no rows" do
+      block = Block.build_block_from_rows([], id: :uint64, name: :string)
+      assert Native.block_row_count(block) == 0
+      assert Native.block_column_count(block) == 2
+    end
+
+    test "rejects invalid values" do
+      assert_raise RuntimeError, ~r/Invalid value for Int8 column small in row 1/, fn ->
+        Block.build_block_from_rows([%{small: 1}, %{small: 200}], small: :int8)
+      end
+
+      assert_raise RuntimeError, ~r/Invalid value for UInt64/, fn ->
+        Block.build_block_from_rows([%{id: -1}], id: :uint64)
+      end
+
+      assert_raise RuntimeError, ~r/Invalid value for DateTime/, fn ->
+        Block.build_block_from_rows([%{at: ~U[2150-01-01 00:00:00Z]}], at: :datetime)
+      end
+
+      assert_raise RuntimeError, ~r/Invalid value for Date/, fn ->
+        Block.build_block_from_rows([%{day: -1}], day: :date)
+      end
+
+      assert_raise RuntimeError, ~r/has no column id/, fn ->
+        Block.build_block_from_rows([%{id: 1}, %{other: 2}], id: :uint64)
+      end
+    end
+  end
+
   describe "Multiple sequential inserts" do
     test "can insert multiple batches", %{conn: conn, table: table} do
       # Create table
@@ -420,4 +555,72 @@ defmodule Natch.BlockTest do
       assert :ok = Natch.insert_cols(conn, "#{table}", columns3, schema)
     end
   end
+
+  describe "Pipelined insert stream" do
+    setup %{conn: conn, table: table} do
+      :ok = Natch.execute(conn, "CREATE TABLE #{table} (id UInt64, name String) ENGINE = Memory")
+      :ok
+    end
+
+    test "inserts every batch through one INSERT", %{conn: conn, table: table} do
+      schema = [id: :uint64, name: :string]
+
+      batches =
+        Stream.map(0..9, fn b ->
+          ids = Enum.to_list((b * 1000)..(b * 1000 + 999))
+          %{id: ids, name: Enum.map(ids, &"n#{&1}")}
+        end)
+
+      assert :ok = Natch.insert_stream(conn, table, batches, schema, window: 2)
+
+      assert {:ok, %{c: [10_000], s: [49_995_000]}} =
+               Natch.select_cols(conn, "SELECT count() AS c, sum(id) AS s FROM #{table}")
+    end
+
+    test "accepts an empty stream", %{conn: conn, table: table} do
+      assert :ok = Natch.insert_stream(conn, table, [], id: :uint64, name: :string)
+      assert {:ok, %{c: [0]}} = Natch.select_cols(conn, "SELECT count() AS c FROM #{table}")
+    end
+
+    test "returns batch errors and leaves the connection usable", %{conn: conn, table: table} do
+      schema = [id: :uint64, name: :string]
+      batches = [%{id: [1], name: ["a"]}, %{id: [-1], name: ["b"]}]
+
+      assert {:error, _} = Natch.insert_stream(conn, table, batches, schema)
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "waits for credits while the connection is busy", %{conn: conn, table: table} do
+      schema = [id: :uint64, name: :string]
+      {:ok, ref} = Natch.select_cols_async(conn, "SELECT sleep(1) AS s")
+      batches = for b <- 1..5, do: %{id: [b], name: ["n#{b}"]}
+
+      assert :ok = Natch.insert_stream(conn, table, batches, schema, window: 1)
+      assert {:ok, _} = Natch.await(ref)
+      assert {:ok, %{c: [5]}} = Natch.select_cols(conn, "SELECT count() AS c FROM #{table}")
+      refute_received _
+    end
+
+    test "abandons the INSERT at its :timeout", %{conn: conn, table: table} do
+      schema = [id: :uint64, name: :string]
+
+      batches =
+        Stream.map(1..10, fn b ->
+          Process.sleep(100)
+          %{id: [b], name: ["n#{b}"]}
+        end)
+
+      assert {:error, :timeout} = Natch.insert_stream(conn, table, batches, schema, timeout: 300)
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "returns server errors", %{conn: conn} do
+      batches = [%{id: [1], name: ["a"]}]
+
+      assert {:error, _} =
+               Natch.insert_stream(conn, "missing_table", batches, id: :uint64, name: :string)
+
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+  end
 end
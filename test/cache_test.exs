@@ -0,0 +1,111 @@
+defmodule Natch.CacheTest do
+  use ExUnit.Case, async: true
+
+  alias Natch.Cache
+  alias Natch.Query
+
+  setup do
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+    {:ok, cache} = Cache.start_link(conn: conn, ttl: 60_000)
+
+    on_exit(fn ->
+      if Process.alive?(conn), do: Process.exit(conn, :normal)
+    end)
+
+    {:ok, conn: conn, cache: cache}
+  end
+
+  # rand() differs between runs, so equal results mean the query ran once
+  @random "SELECT rand() AS r"
+
+  test "serves repeated queries from the cache", %{cache: cache} do
+    assert {:ok, %{r: [r]}} = Cache.select_cols(cache, @random)
+    assert {:ok, %{r: [^r]}} = Cache.select_cols(cache, @random)
+  end
+
+  test "keys results by format", %{cache: cache} do
+    assert {:ok, %{r: [r]}} = Cache.select_cols(cache, @random)
+    assert {:ok, [%{r: other}]} = Cache.select_rows(cache, @random)
+    assert other != r
+  end
+
+  test "keys results by bound parameters", %{cache: cache} do
+    query = Query.new("SELECT {n:UInt64} * 2 AS n")
+
+    assert {:ok, %{n: [2]}} = Cache.select_cols(cache, Query.bind(query, :n, 1))
+    assert {:ok, %{n: [4]}} = Cache.select_cols(cache, Query.bind(query, :n, 2))
+    assert {:ok, %{n: [2]}} = Cache.select_cols(cache, Query.bind(query, :n, 1))
+  end
+
+  test "collapses concurrent misses into one query", %{cache: cache} do
+    sql = "SELECT rand() AS r, sleep(0.2) AS s"
+
+    results =
+      1..20
+      |> Enum.map(fn _ -> Task.async(fn -> Cache.select_cols(cache, sql) end) end)
+      |> Task.await_many()
+
+    assert [{:ok, %{r: [_]}}] = Enum.uniq(results)
+  end
+
+  test "expires results after the TTL", %{conn: conn} do
+    {:ok, cache} = Cache.start_link(conn: conn, ttl: 50)
+
+    assert {:ok, %{r: [r]}} = Cache.select_cols(cache, @random)
+    Process.sleep(100)
+    assert {:ok, %{r: [other]}} = Cache.select_cols(cache, @random)
+    assert other != r
+  end
+
+  test "doesn't cache results above the memory cap", %{conn: conn} do
+    {:ok, cache} = Cache.start_link(conn: conn, max_bytes: 1_000)
+    sql = "SELECT rand() AS r FROM numbers(1000)"
+
+    assert {:ok, %{r: first}} = Cache.select_cols(cache, sql)
+    assert {:ok, %{r: second}} = Cache.select_cols(cache, sql)
+    assert first != second
+  end
+
+  test "evicts the oldest results to stay under the cap", %{conn: conn} do
+    {:ok, cache} = Cache.start_link(conn: conn, max_bytes: 60)
+
+    assert {:ok, %{r: [r]}} = Cache.select_cols(cache, "SELECT rand() AS r")
+    assert {:ok, _} = Cache.select_cols(cache, "SELECT rand() AS r, 1 AS a")
+    assert {:ok, _} = Cache.select_cols(cache, "SELECT rand() AS r, 2 AS b")
+
+    assert {:ok, %{r: [other]}} = Cache.select_cols(cache, "SELECT rand() AS r")
+    assert other != r
+  end
+
+  test "invalidate drops cached results", %{cache: cache} do
+    assert {:ok, %{r: [r]}} = Cache.select_cols(cache, @random)
+    assert :ok = Cache.invalidate(cache)
+    assert {:ok, %{r: [other]}} = Cache.select_cols(cache, @random)
+    assert other != r
+  end
+
+  test "answers waiting callers when the connection goes down" do
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+    Process.unlink(conn)
+    {:ok, cache} = Cache.start_link(conn: conn)
+
+    sql = "SELECT rand() AS r, sleep(2) AS s"
+    tasks = for _ <- 1..3, do: Task.async(fn -> Cache.select_cols(cache, sql) end)
+    Process.sleep(200)
+    Process.exit(conn, :kill)
+
+    for result <- Task.await_many(tasks) do
+      assert {:error, {:connection_down, :killed}} = result
+    end
+
+    assert {:error, {:connection_down, _}} = Cache.select_cols(cache, @random)
+    assert Process.alive?(cache)
+  end
+
+  test "returns errors without caching them", %{cache: cache} do
+    sql = "SELECT * FROM natch_cache_missing_table"
+
+    assert {:error, _} = Cache.select_cols(cache, sql)
+    assert {:error, _} = Cache.select_cols(cache, sql)
+  end
+end
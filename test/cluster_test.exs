@@ -0,0 +1,78 @@
+defmodule Natch.ClusterTest do
+  use ExUnit.Case, async: true
+
+  alias Natch.Cluster
+  alias Natch.Query
+
+  # Three "shards" on the local server: each runs the query on its own client
+  setup do
+    {:ok, cluster} = Cluster.start_link(hosts: ["localhost:9000", "localhost", [port: 9000]])
+    {:ok, cluster: cluster}
+  end
+
+  test "concatenates shard results in host order", %{cluster: cluster} do
+    sql = "SELECT number AS n, toString(number) AS s FROM numbers(3)"
+    assert {:ok, %{n: n, s: s}} = Cluster.select_cols(cluster, sql)
+
+    assert n == [0, 1, 2, 0, 1, 2, 0, 1, 2]
+    assert s == ~w(0 1 2 0 1 2 0 1 2)
+  end
+
+  test "merges sorted shard results by a sort key", %{cluster: cluster} do
+    sql = "SELECT number * 2 AS k, toString(number) AS v FROM numbers(4) ORDER BY k"
+
+    assert {:ok, %{k: k, v: v}} = Cluster.select_cols(cluster, sql, order_by: :k)
+    assert k == [0, 0, 0, 2, 2, 2, 4, 4, 4, 6, 6, 6]
+    assert v == ~w(0 0 0 1 1 1 2 2 2 3 3 3)
+  end
+
+  test "merges in descending order", %{cluster: cluster} do
+    sql = "SELECT number AS k FROM numbers(3) ORDER BY k DESC"
+
+    assert {:ok, %{k: [2, 2, 2, 1, 1, 1, 0, 0, 0]}} =
+             Cluster.select_cols(cluster, sql, order_by: {:k, :desc})
+  end
+
+  test "merges results spanning several blocks", %{cluster: cluster} do
+    sql = "SELECT number AS k FROM numbers(30000) ORDER BY k SETTINGS max_block_size = 7000"
+
+    assert {:ok, %{k: k}} = Cluster.select_cols(cluster, sql, order_by: :k)
+    assert length(k) == 90000
+    assert k == Enum.sort(k)
+  end
+
+  test "runs parameterized queries on every shard", %{cluster: cluster} do
+    query = Query.new("SELECT {n:UInt64} AS n") |> Query.bind(:n, 7)
+    assert {:ok, %{n: [7, 7, 7]}} = Cluster.select_cols(cluster, query)
+  end
+
+  test "runs shards concurrently", %{cluster: cluster} do
+    {micros, {:ok, _}} =
+      :timer.tc(fn -> Cluster.select_cols(cluster, "SELECT sleep(0.5) AS s") end)
+
+    assert micros < 1_400_000
+  end
+
+  test "returns the error of a failing shard", %{cluster: cluster} do
+    assert {:error, _} = Cluster.select_cols(cluster, "SELECT * FROM natch_cluster_missing_table")
+    assert {:ok, _} = Cluster.select_cols(cluster, "SELECT 1 AS x")
+  end
+
+  test "rejects sort keys that aren't result columns", %{cluster: cluster} do
+    assert {:error, _} = Cluster.select_cols(cluster, "SELECT 1 AS x", order_by: :y)
+  end
+
+  test "stops every shard at the deadline", %{cluster: cluster} do
+    sql = "SELECT sum(number) AS s FROM numbers(100000000000)"
+    assert {:error, :timeout} = Cluster.select_cols(cluster, sql, timeout: 300)
+    assert {:ok, %{x: [1, 1, 1]}} = Cluster.select_cols(cluster, "SELECT 1 AS x")
+  end
+
+  test "rejects invalid timeouts without crashing", %{cluster: cluster} do
+    assert_raise ArgumentError, fn -> Cluster.select_cols(cluster, "SELECT 1", timeout: 0) end
+    assert_raise ArgumentError, fn ->
+      Cluster.start_link(hosts: ["localhost"], query_timeout: -1)
+    end
+    assert {:ok, %{x: [1, 1, 1]}} = Cluster.select_cols(cluster, "SELECT 1 AS x")
+  end
+end
@@ -34,6 +34,20 @@ defmodule Natch.ColumnTest do
       assert is_reference(col.ref)
     end
 
+    test "can reserve storage for expected rows" do
+      col = Column.new(:uint64, reserve: 10_000)
+      assert Column.size(col) == 0
+
+      Column.append_bulk(col, Enum.to_list(1..10_000))
+      assert Column.size(col) == 10_000
+    end
+
+    test "can reserve nested columns" do
+      col = Column.new({:array, {:nullable, :string}}, reserve: 2)
+      assert :ok = Column.append_bulk(col, [["a", nil], []])
+      assert Column.size(col) == 2
+    end
+
     test "raises on unsupported type" do
       assert_raise ArgumentError, ~r/Unsupported column type/, fn ->
         Column.new(:invalid_type)
@@ -1145,4 +1159,46 @@ defmodule Natch.ColumnTest do
       end
     end
   end
+
+  describe "Packed binary append" do
+    test "appends packed little-endian integers" do
+      col = Column.new(:uint64)
+      packed = for v <- [1, 2, 3], into: <<>>, do: <<v::little-unsigned-64>>
+      assert :ok = Column.append_binary(col, packed)
+      assert Column.size(col) == 3
+    end
+
+    test "appends to columns that already hold values" do
+      col = Column.new(:int32)
+      Column.append_bulk(col, [1, 2])
+      assert :ok = Column.append_binary(col, <<-3::little-signed-32, 4::little-signed-32>>)
+      assert Column.size(col) == 4
+    end
+
+    test "appends packed floats and bools" do
+      float_col = Column.new(:float64)
+      assert :ok = Column.append_binary(float_col, <<1.5::little-float-64, 2.5::little-float-64>>)
+      assert Column.size(float_col) == 2
+
+      bool_col = Column.new(:bool)
+      assert :ok = Column.append_binary(bool_col, <<1, 0, 1>>)
+      assert Column.size(bool_col) == 3
+    end
+
+    test "raises on a size that isn't a multiple of the element size" do
+      col = Column.new(:uint32)
+
+      assert_raise ArgumentError, ~r/not a multiple of 4 bytes/, fn ->
+        Column.append_binary(col, <<1, 2, 3>>)
+      end
+    end
+
+    test "raises on non-numeric columns" do
+      col = Column.new(:string)
+
+      assert_raise ArgumentError, ~r/does not support :string/, fn ->
+        Column.append_binary(col, <<1>>)
+      end
+    end
+  end
 end
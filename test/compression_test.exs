@@ -0,0 +1,118 @@
+defmodule Natch.CompressionTest do
+  use ExUnit.Case, async: true
+
+  alias Natch.Compression
+
+  @large 2 * 1_048_576
+
+  setup do
+    table = "test_compression_#{System.unique_integer([:positive, :monotonic])}"
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+
+    Natch.execute(conn, "CREATE TABLE #{table} (id UInt64, name String) ENGINE = Memory")
+
+    on_exit(fn ->
+      if Process.alive?(conn) do
+        Natch.execute(conn, "DROP TABLE IF EXISTS #{table}")
+        Process.exit(conn, :normal)
+      end
+    end)
+
+    {:ok, table: table}
+  end
+
+  for option <- [:none, :lz4, :zstd, {:zstd, 6}, :adaptive, false] do
+    test "inserts and selects with compression: #{inspect(option)}", %{table: table} do
+      {:ok, conn} = Natch.start_link(host: "localhost", port: 9000, compression: unquote(option))
+
+      ids = Enum.to_list(1..10_000)
+      columns = %{id: ids, name: Enum.map(ids, &"name_#{&1}")}
+      assert :ok = Natch.insert(conn, table, columns, id: :uint64, name: :string)
+
+      sql = "SELECT id FROM #{table} ORDER BY id"
+      assert {:ok, %{id: ^ids}} = Natch.select_cols(conn, sql)
+
+      GenServer.stop(conn)
+    end
+  end
+
+  describe "new/1" do
+    test "maps options to the client codec" do
+      assert {:lz4, %Compression{mode: :fixed, codec: :lz4}} = Compression.new(true)
+      assert {:none, %Compression{codec: :none}} = Compression.new(false)
+      assert {:zstd, %Compression{codec: :zstd, level: 1}} = Compression.new(:zstd)
+      assert {:zstd, %Compression{level: 9}} = Compression.new({:zstd, 9})
+      assert {:lz4, %Compression{mode: :adaptive, level: 3}} = Compression.new({:adaptive, 3})
+    end
+
+    test "rejects unknown codecs and levels" do
+      assert_raise ArgumentError, fn -> Compression.new(:gzip) end
+      assert_raise ArgumentError, fn -> Compression.new({:zstd, 0}) end
+    end
+  end
+
+  describe "adaptive choice" do
+    test "measures LZ4, then ZSTD, then keeps the faster one" do
+      {_codec, policy} = Compression.new(:adaptive)
+      assert {:lz4, 0} = Compression.choose(policy)
+
+      slow = %{result_bytes: @large, receive_ns: 4_000_000, first_block_ns: 0}
+      policy = Compression.observe(policy, :lz4, slow)
+      assert {:zstd, 1} = Compression.choose(policy)
+
+      fast = %{result_bytes: @large, receive_ns: 1_000_000, first_block_ns: 0}
+      policy = Compression.observe(policy, :zstd, fast)
+      assert {:zstd, 1} = Compression.choose(policy)
+    end
+
+    test "measures the transfer after the first block, not the server's time" do
+      {_codec, policy} = Compression.new(:adaptive)
+
+      # ZSTD's query spent longer on the server before its first block, but
+      # transferred the result faster
+      lz4 = %{result_bytes: @large, receive_ns: 5_000_000, first_block_ns: 1_000_000}
+      zstd = %{result_bytes: @large, receive_ns: 9_000_000, first_block_ns: 7_000_000}
+
+      policy =
+        policy
+        |> Compression.observe(:lz4, lz4)
+        |> Compression.observe(:zstd, zstd)
+
+      assert {:zstd, 1} = Compression.choose(policy)
+    end
+
+    test "ignores small results" do
+      {_codec, policy} = Compression.new(:adaptive)
+      stats = %{result_bytes: 100, receive_ns: 1_000, first_block_ns: 0}
+      small = Compression.observe(policy, :lz4, stats)
+      assert small == policy
+    end
+
+    test "periodically probes the slower codec" do
+      {_codec, policy} = Compression.new(:adaptive)
+      fast = %{result_bytes: @large, receive_ns: 1_000_000, first_block_ns: 0}
+      slow = %{result_bytes: @large, receive_ns: 8_000_000, first_block_ns: 0}
+
+      policy =
+        policy
+        |> Compression.observe(:lz4, fast)
+        |> Compression.observe(:zstd, slow)
+
+      {choices, _policy} =
+        Enum.map_reduce(1..16, policy, fn _, policy ->
+          {codec, _level} = Compression.choose(policy)
+          {codec, Compression.observe(policy, codec, if(codec == :lz4, do: fast, else: slow))}
+        end)
+
+      assert :zstd in choices
+      assert Enum.count(choices, &(&1 == :lz4)) >= 14
+    end
+
+    test "fixed codecs ignore measurements" do
+      {_codec, policy} = Compression.new({:zstd, 4})
+      stats = %{result_bytes: @large, receive_ns: 1, first_block_ns: 0}
+      policy = Compression.observe(policy, :zstd, stats)
+      assert {:zstd, 4} = Compression.choose(policy)
+    end
+  end
+end
@@ -0,0 +1,151 @@
+defmodule Natch.DecodeOptionsTest do
+  use ExUnit.Case, async: true
+
+  @strings_sql """
+  SELECT
+    toString(number) AS s,
+    if(number % 3 = 0, NULL, concat('v', toString(number))) AS ns,
+    [toString(number), 'x'] AS arr
+  FROM numbers(1000)
+  ORDER BY number
+  """
+
+  setup do
+    {:ok, copy} = Natch.start_link(host: "localhost", port: 9000)
+    {:ok, sub} = Natch.start_link(host: "localhost", port: 9000, strings: :sub_binary)
+
+    on_exit(fn ->
+      for conn <- [copy, sub], Process.alive?(conn), do: Process.exit(conn, :normal)
+    end)
+
+    {:ok, copy: copy, sub: sub}
+  end
+
+  describe "strings: :sub_binary" do
+    test "returns the same columnar values as :copy", %{copy: copy, sub: sub} do
+      assert Natch.select_cols(sub, @strings_sql) == Natch.select_cols(copy, @strings_sql)
+    end
+
+    test "returns the same rows as :copy", %{copy: copy, sub: sub} do
+      assert Natch.select_rows(sub, @strings_sql) == Natch.select_rows(copy, @strings_sql)
+    end
+
+    test "values share one binary per column block", %{sub: sub} do
+      {:ok, %{s: [first | _] = strings}} = Natch.select_cols(sub, @strings_sql)
+
+      total = strings |> Enum.map(&byte_size/1) |> Enum.sum()
+      assert :binary.referenced_byte_size(first) == total
+    end
+
+    test "streams with sub-binaries", %{copy: copy, sub: sub} do
+      {:ok, %{s: expected}} = Natch.select_cols(copy, @strings_sql)
+
+      streamed = sub |> Natch.stream_cols(@strings_sql) |> Enum.flat_map(& &1.s)
+
+      assert streamed == expected
+    end
+
+    test "handles empty strings and empty results", %{sub: sub} do
+      assert {:ok, %{s: ["", "", ""]}} = Natch.select_cols(sub, "SELECT '' AS s FROM numbers(3)")
+      assert {:ok, %{}} = Natch.select_cols(sub, "SELECT '' AS s WHERE 0")
+    end
+  end
+
+  describe "dictionary columns" do
+    @dictionary_sql """
+    SELECT
+      toLowCardinality(toString(number % 3)) AS lc,
+      toLowCardinality(toNullable(if(number % 4 = 0, NULL, 'x'))) AS nlc,
+      CAST(number % 2 + 1, 'Enum8(\\'a\\' = 1, \\'b\\' = 2)') AS e8,
+      CAST(number % 2 + 1, 'Enum16(\\'c\\' = 1, \\'d\\' = 2)') AS e16
+    FROM numbers(8)
+    ORDER BY number
+    """
+
+    test "decode LowCardinality and Enum values", %{copy: copy} do
+      {:ok, cols} = Natch.select_cols(copy, @dictionary_sql)
+
+      assert cols.lc == ["0", "1", "2", "0", "1", "2", "0", "1"]
+      assert cols.nlc == [nil, "x", "x", "x", nil, "x", "x", "x"]
+      assert cols.e8 == ["a", "b", "a", "b", "a", "b", "a", "b"]
+      assert cols.e16 == ["c", "d", "c", "d", "c", "d", "c", "d"]
+    end
+
+    # Sharing only survives when the result is built in the calling process;
+    # copying it in a message (as Natch.Connection does) expands shared terms
+    test "rows with the same dictionary value share one term", %{copy: copy} do
+      {:ok, client} = Natch.Connection.get_client(copy)
+      cols = Natch.Native.client_select_cols(client, @dictionary_sql)
+      %{lc: [a | rest], e8: [e | erest]} = cols
+
+      assert :erts_debug.same(a, Enum.at(rest, 2))
+      assert :erts_debug.same(e, Enum.at(erest, 1))
+    end
+
+    test "enums: :atom returns Enum names as atoms" do
+      {:ok, conn} = Natch.start_link(host: "localhost", port: 9000, enums: :atom)
+
+      {:ok, cols} = Natch.select_cols(conn, @dictionary_sql)
+      assert cols.e8 == [:a, :b, :a, :b, :a, :b, :a, :b]
+      assert cols.e16 == [:c, :d, :c, :d, :c, :d, :c, :d]
+      assert hd(cols.lc) == "0"
+
+      {:ok, [row | _]} = Natch.select_rows(conn, @dictionary_sql)
+      assert row.e8 == :a
+
+      GenServer.stop(conn)
+    end
+  end
+
+  describe "decode_threads" do
+    @wide_sql """
+    SELECT
+      number AS n,
+      toInt32(number) - 5000 AS i,
+      number / 3 AS f,
+      toString(number) AS s,
+      if(number % 5 = 0, NULL, number) AS nn,
+      toLowCardinality(toString(number % 7)) AS lc,
+      [number, number + 1] AS arr,
+      toDate('2024-01-01') + number % 365 AS d
+    FROM numbers(20000)
+    ORDER BY number
+    """
+
+    test "returns the same results as serial decoding", %{copy: copy} do
+      {:ok, conn} = Natch.start_link(host: "localhost", port: 9000, decode_threads: 4)
+
+      assert Natch.select_cols(conn, @wide_sql) == Natch.select_cols(copy, @wide_sql)
+      assert Natch.select_rows(conn, @wide_sql) == Natch.select_rows(copy, @wide_sql)
+
+      GenServer.stop(conn)
+    end
+
+    test "reports decode errors from worker threads" do
+      {:ok, conn} = Natch.start_link(host: "localhost", port: 9000, decode_threads: 4)
+
+      sql = "SELECT number AS n, toInt128(number) AS big FROM numbers(5000)"
+      assert {:error, _} = Natch.select_cols(conn, sql)
+
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+
+      GenServer.stop(conn)
+    end
+
+    test "rejects non-positive thread counts" do
+      assert_raise ArgumentError, ~r/:decode_threads must be a positive integer/, fn ->
+        Natch.start_link(host: "localhost", port: 9000, decode_threads: 0)
+      end
+    end
+  end
+
+  test "rejects unknown string and enum modes" do
+    assert_raise ArgumentError, ~r/:strings must be :copy or :sub_binary, got: :bogus/, fn ->
+      Natch.start_link(host: "localhost", port: 9000, strings: :bogus)
+    end
+
+    assert_raise ArgumentError, ~r/:enums must be :string or :atom/, fn ->
+      Natch.Pool.start_link(host: "localhost", port: 9000, enums: "atom")
+    end
+  end
+end
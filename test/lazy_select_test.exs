@@ -0,0 +1,87 @@
+defmodule Natch.LazySelectTest do
+  use ExUnit.Case, async: true
+
+  alias Natch.LazyResult
+  alias Natch.Query
+
+  setup do
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+
+    on_exit(fn ->
+      if Process.alive?(conn), do: Process.exit(conn, :normal)
+    end)
+
+    {:ok, conn: conn}
+  end
+
+  @multi_block """
+  SELECT number AS n, toString(number) AS s, number % 3 = 0 ? NULL : number AS m
+  FROM numbers(25000)
+  SETTINGS max_block_size = 10000
+  """
+
+  test "returns the schema and row count without decoding", %{conn: conn} do
+    assert {:ok, %LazyResult{} = result} = Natch.select_lazy(conn, @multi_block)
+
+    assert result.columns == [:n, :s, :m]
+    assert result.types == ["UInt64", "String", "Nullable(UInt64)"]
+    assert result.rows == 25000
+    assert length(result.blocks) == 3
+  end
+
+  test "decodes single columns across blocks", %{conn: conn} do
+    {:ok, result} = Natch.select_lazy(conn, @multi_block)
+
+    assert LazyResult.column(result, :n) == Enum.to_list(0..24999)
+    assert LazyResult.column(result, :s, limit: 3) == ["0", "1", "2"]
+
+    assert LazyResult.column(result, :m, offset: 9998, limit: 4) ==
+             [9998, nil, 10000, 10001]
+  end
+
+  test "decodes several columns", %{conn: conn} do
+    {:ok, result} = Natch.select_lazy(conn, @multi_block)
+
+    assert %{n: [19999, 20000], s: ["19999", "20000"]} =
+             LazyResult.columns(result, [:n, :s], offset: 19999, limit: 2)
+  end
+
+  test "decodes rows with the requested columns", %{conn: conn} do
+    {:ok, result} = Natch.select_lazy(conn, @multi_block)
+
+    assert LazyResult.rows(result, columns: [:n, :m], offset: 9999, limit: 2) ==
+             [%{n: 9999, m: nil}, %{n: 10000, m: 10000}]
+
+    assert [%{n: 0, s: "0", m: nil}] = LazyResult.rows(result, limit: 1)
+  end
+
+  test "clamps ranges past the end", %{conn: conn} do
+    {:ok, result} = Natch.select_lazy(conn, @multi_block)
+
+    assert LazyResult.column(result, :n, offset: 24998, limit: 10) == [24998, 24999]
+    assert LazyResult.column(result, :n, offset: 30000) == []
+  end
+
+  test "raises for unknown columns", %{conn: conn} do
+    {:ok, result} = Natch.select_lazy(conn, "SELECT 1 AS a")
+    assert_raise ArgumentError, fn -> LazyResult.column(result, :b) end
+  end
+
+  test "keeps the schema of empty results", %{conn: conn} do
+    {:ok, result} = Natch.select_lazy(conn, "SELECT number AS n FROM numbers(0)")
+
+    assert %LazyResult{columns: [:n], rows: 0, blocks: []} = result
+    assert LazyResult.column(result, :n) == []
+  end
+
+  test "supports parameterized queries", %{conn: conn} do
+    query = Query.new("SELECT number AS n FROM numbers({count:UInt64})") |> Query.bind(:count, 5)
+
+    {:ok, result} = Natch.select_lazy(conn, query)
+    assert LazyResult.column(result, :n) == [0, 1, 2, 3, 4]
+  end
+
+  test "returns errors", %{conn: conn} do
+    assert {:error, _} = Natch.select_lazy(conn, "SELECT * FROM natch_lazy_missing_table")
+  end
+end
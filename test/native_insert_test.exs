@@ -0,0 +1,86 @@
+defmodule Natch.NativeInsertTest do
+  use ExUnit.Case, async: true
+
+  setup do
+    table = "test_native_#{System.unique_integer([:positive, :monotonic])}"
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+
+    :ok =
+      Natch.execute(conn, """
+      CREATE TABLE #{table} (id UInt64, name String, score Nullable(Float64))
+      ENGINE = Memory
+      """)
+
+    on_exit(fn ->
+      if Process.alive?(conn) do
+        try do
+          Natch.execute(conn, "DROP TABLE IF EXISTS #{table}")
+        catch
+          :exit, _ -> :ok
+        end
+
+        Process.exit(conn, :normal)
+      end
+    end)
+
+    {:ok, conn: conn, table: table}
+  end
+
+  # One Native format block of {id, name, score} rows
+  defp native_block(rows) do
+    ids = for {id, _, _} <- rows, into: <<>>, do: <<id::little-64>>
+    names = for {_, name, _} <- rows, into: <<>>, do: string(name)
+    nulls = for {_, _, score} <- rows, into: <<>>, do: <<if(score, do: 0, else: 1)>>
+    scores = for {_, _, score} <- rows, into: <<>>, do: <<(score || 0.0)::little-float-64>>
+
+    IO.iodata_to_binary([
+      varint(3),
+      varint(length(rows)),
+      [string("id"), string("UInt64"), ids],
+      [string("name"), string("String"), names],
+      [string("score"), string("Nullable(Float64)"), nulls, scores]
+    ])
+  end
+
+  defp string(value), do: [varint(byte_size(value)), value]
+
+  defp varint(n) when n < 128, do: <<n>>
+  defp varint(n), do: <<1::1, n::7, varint(div(n, 128))::binary>>
+
+  test "inserts a Native format block", %{conn: conn, table: table} do
+    data = native_block([{1, "a", 1.5}, {2, "b", nil}])
+
+    assert :ok = Natch.insert_native(conn, table, data)
+
+    assert {:ok, %{id: [1, 2], name: ["a", "b"], score: [1.5, nil]}} =
+             Natch.select_cols(conn, "SELECT * FROM #{table} ORDER BY id")
+  end
+
+  test "inserts several blocks as one", %{conn: conn, table: table} do
+    rows = for i <- 1..300, do: {i, String.duplicate("x", i), i / 2}
+    {first, rest} = Enum.split(rows, 200)
+    data = native_block(first) <> native_block([]) <> native_block(rest)
+
+    assert :ok = Natch.insert_native(conn, table, data)
+
+    {:ok, %{id: ids, name: names}} = Natch.select_cols(conn, "SELECT * FROM #{table} ORDER BY id")
+    assert ids == Enum.to_list(1..300)
+    assert Enum.at(names, 149) == String.duplicate("x", 150)
+  end
+
+  test "rejects truncated data", %{conn: conn, table: table} do
+    data = native_block([{1, "a", 1.5}])
+
+    truncated = binary_part(data, 0, byte_size(data) - 3)
+
+    assert {:error, _} = Natch.insert_native(conn, table, truncated)
+    assert {:error, _} = Natch.insert_native(conn, table, <<>>)
+    assert {:ok, %{id: []}} = Natch.select_cols(conn, "SELECT id FROM #{table}")
+  end
+
+  test "rejects blocks with different columns", %{conn: conn, table: table} do
+    other = IO.iodata_to_binary([varint(1), varint(1), string("id"), string("UInt32"), <<1::32>>])
+
+    assert {:error, _} = Natch.insert_native(conn, table, native_block([{1, "a", nil}]) <> other)
+  end
+end
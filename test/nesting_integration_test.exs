@@ -474,4 +474,23 @@ defmodule Natch.NestingIntegrationTest do
              ]
     end
   end
+
+  describe "Array decoding across rows" do
+    test "empty and varying-length arrays keep their row boundaries", %{conn: conn} do
+      sql = """
+      SELECT
+        range(number % 4) AS a,
+        arrayMap(x -> range(x), range(number % 3)) AS aa,
+        arrayMap(x -> if(x % 2 = 0, NULL, x), range(number % 4)) AS an
+      FROM numbers(6)
+      ORDER BY number
+      """
+
+      assert {:ok, cols} = Natch.select_cols(conn, sql)
+
+      assert cols.a == [[], [0], [0, 1], [0, 1, 2], [], [0]]
+      assert cols.aa == [[], [[]], [[], [0]], [], [[]], [[], [0]]]
+      assert cols.an == [[], [nil], [nil, 1], [nil, 1, nil], [], [nil]]
+    end
+  end
 end
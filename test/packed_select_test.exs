@@ -0,0 +1,104 @@
+defmodule Natch.PackedSelectTest do
+  use ExUnit.Case, async: true
+
+  setup do
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+
+    on_exit(fn ->
+      if Process.alive?(conn), do: Process.exit(conn, :normal)
+    end)
+
+    {:ok, conn: conn}
+  end
+
+  defp unpack(bin, size, :signed), do: for(<<v::native-signed-size(size) <- bin>>, do: v)
+  defp unpack(bin, size, :unsigned), do: for(<<v::native-unsigned-size(size) <- bin>>, do: v)
+
+  defp strings(%{data: data, offsets: offsets}) do
+    offsets = for <<offset::native-signed-64 <- offsets>>, do: offset
+
+    offsets
+    |> Enum.zip(tl(offsets))
+    |> Enum.map(fn {from, to} -> binary_part(data, from, to - from) end)
+  end
+
+  defp valid?(validity, row) do
+    <<_::binary-size(div(row, 8)), byte, _::binary>> = validity
+    Bitwise.band(byte, Bitwise.bsl(1, rem(row, 8))) != 0
+  end
+
+  test "packs numeric columns across blocks", %{conn: conn} do
+    sql = """
+    SELECT number AS n, toInt16(number) - 100 AS i, number / 2 AS f
+    FROM numbers(5000) ORDER BY n SETTINGS max_block_size = 1000
+    """
+
+    assert {:ok, %{n: n, i: i, f: f}} = Natch.select_packed(conn, sql)
+
+    assert n.type == :uint64
+    assert unpack(n.data, 64, :unsigned) == Enum.to_list(0..4999)
+    assert i.type == :int16
+    assert unpack(i.data, 16, :signed) == Enum.map(0..4999, &(&1 - 100))
+    assert f.type == :float64
+    assert for(<<x::native-float-64 <- f.data>>, do: x) == Enum.map(0..4999, &(&1 / 2))
+  end
+
+  test "widens temporal columns", %{conn: conn} do
+    sql = """
+    SELECT toDate('2024-01-02') AS d, toDateTime('2024-01-02 03:04:05', 'UTC') AS dt,
+           toDateTime64('2024-01-02 03:04:05.250', 3, 'UTC') AS dt64
+    """
+
+    assert {:ok, %{d: d, dt: dt, dt64: dt64}} = Natch.select_packed(conn, sql)
+
+    assert d.type == :date
+    assert <<days::native-signed-32>> = d.data
+    assert days == Date.diff(~D[2024-01-02], ~D[1970-01-01])
+
+    assert dt.type == :datetime
+    assert <<seconds::native-signed-64>> = dt.data
+    assert seconds == DateTime.to_unix(~U[2024-01-02 03:04:05Z])
+
+    assert %{type: :datetime64, precision: 3} = dt64
+    assert <<ticks::native-signed-64>> = dt64.data
+    assert ticks == DateTime.to_unix(~U[2024-01-02 03:04:05Z], :millisecond) + 250
+  end
+
+  test "packs strings with offsets and nullable validity", %{conn: conn} do
+    sql = """
+    SELECT toString(number) AS s,
+           if(number % 3 = 0, NULL, concat('v', toString(number))) AS ns,
+           toLowCardinality(toString(number % 2)) AS lc
+    FROM numbers(10) ORDER BY number
+    """
+
+    assert {:ok, %{s: s, ns: ns, lc: lc}} = Natch.select_packed(conn, sql)
+
+    assert s.type == :string
+    assert strings(s) == Enum.map(0..9, &to_string/1)
+    refute Map.has_key?(s, :validity)
+
+    assert ns.type == :string
+    assert Enum.map(0..9, &valid?(ns.validity, &1)) == Enum.map(0..9, &(rem(&1, 3) != 0))
+    assert Enum.at(strings(ns), 1) == "v1"
+    assert Enum.at(strings(ns), 0) == ""
+
+    assert strings(lc) == Enum.map(0..9, &to_string(rem(&1, 2)))
+  end
+
+  test "returns an empty map for empty results", %{conn: conn} do
+    assert {:ok, %{}} = Natch.select_packed(conn, "SELECT 1 AS x WHERE 0")
+  end
+
+  test "rejects column types without a packed layout", %{conn: conn} do
+    assert {:error, _} = Natch.select_packed(conn, "SELECT [1, 2] AS arr")
+    assert {:ok, %{x: _}} = Natch.select_packed(conn, "SELECT 1 AS x")
+  end
+
+  test "runs parameterized queries", %{conn: conn} do
+    query = Natch.Query.new("SELECT {n:UInt32} AS n") |> Natch.Query.bind(:n, 7)
+
+    assert {:ok, %{n: %{type: :uint32, data: <<7::native-32>>}}} =
+             Natch.select_packed(conn, query)
+  end
+end
@@ -142,6 +142,113 @@ defmodule Natch.ParameterizedQueryTest do
     end
   end
 
+  describe "Query.bind_all/2" do
+    test "binds every parameter in one call", %{conn: conn} do
+      sql = """
+      SELECT {a:UInt64} AS a, {b:Int64} AS b, {f:Float64} AS f, {s:String} AS s,
+             {n:Nullable(String)} AS n, {d:Date} AS d, {dt:DateTime} AS dt
+      """
+
+      params = [
+        a: 18_446_744_073_709_551_615,
+        b: -42,
+        f: 0.1,
+        s: "x",
+        n: nil,
+        d: ~D[2024-01-02],
+        dt: ~U[2024-01-02 03:04:05Z]
+      ]
+
+      query = Query.new(sql) |> Query.bind_all(params)
+      assert query.params == Map.new(params)
+
+      assert {:ok, [row]} = Natch.select_rows(conn, query)
+      assert row.a == 18_446_744_073_709_551_615
+      assert row.b == -42
+      assert row.f == 0.1
+      assert row.n == nil
+      assert row.d == Date.diff(~D[2024-01-02], ~D[1970-01-01])
+      assert row.dt == DateTime.to_unix(~U[2024-01-02 03:04:05Z])
+    end
+
+    test "accepts maps with string keys", %{conn: conn} do
+      query = Query.new("SELECT {id:UInt64} AS id") |> Query.bind_all(%{"id" => 7})
+      assert {:ok, [%{id: 7}]} = Natch.select_rows(conn, query)
+    end
+
+    test "rejects unsupported values" do
+      assert_raise ArgumentError, fn ->
+        Query.new("SELECT {x:UInt64}") |> Query.bind_all(x: :atom)
+      end
+    end
+  end
+
+  describe "Query templates" do
+    test "parses slots in order of first appearance" do
+      query =
+        Query.prepare("""
+        SELECT {id:UInt64} AS a, '{skip:String}' AS s, { ratio : Nullable(Float32) } AS r,
+               {id:UInt64} AS b
+        """)
+
+      assert query.slots == [id: "UInt64", ratio: "Nullable(Float32)"]
+    end
+
+    test "binds by slot and rebinds", %{conn: conn} do
+      query =
+        Query.prepare(
+          "SELECT name, age FROM param_query_test WHERE id = {id:UInt64} AND age > {min:Int32}"
+        )
+
+      assert {:ok, [%{name: "Alice"}]} = Natch.select_rows(conn, Query.bind_slots(query, {1, 20}))
+      assert {:ok, [%{name: "Bob"}]} = Natch.select_rows(conn, Query.bind_slots(query, [2, -5]))
+      assert {:ok, []} = Natch.select_rows(conn, Query.bind_slots(query, {3, 40}))
+    end
+
+    test "each binding is a query of its own", %{conn: conn} do
+      query = Query.prepare("SELECT {n:UInt64} AS n")
+      first = Query.bind_slots(query, {1})
+      second = Query.bind_slots(query, {2})
+
+      assert {:ok, [%{n: 1}]} = Natch.select_rows(conn, first)
+      assert {:ok, [%{n: 2}]} = Natch.select_rows(conn, second)
+
+      results =
+        1..20
+        |> Task.async_stream(fn n ->
+          Natch.select_rows(conn, Query.bind_slots(query, {n}))
+        end)
+        |> Enum.map(fn {:ok, {:ok, [%{n: n}]}} -> n end)
+
+      assert results == Enum.to_list(1..20)
+    end
+
+    test "binds floats, strings, dates, datetimes and NULL", %{conn: conn} do
+      query =
+        Query.prepare("""
+        SELECT {f:Float64} AS f, {f32:Float32} AS f32, {s:String} AS s, {d:Date} AS d,
+               {dt:DateTime} AS dt, {n:Nullable(String)} AS n
+        """)
+
+      values = {0.1, 0.5, "it's", ~D[2024-01-02], ~U[2024-01-02 03:04:05Z], nil}
+      assert {:ok, [row]} = Natch.select_rows(conn, Query.bind_slots(query, values))
+
+      assert row.f == 0.1
+      assert row.f32 == 0.5
+      assert row.s == "it's"
+      assert row.n == nil
+      assert row.d == Date.diff(~D[2024-01-02], ~D[1970-01-01])
+      assert row.dt == DateTime.to_unix(~U[2024-01-02 03:04:05Z])
+    end
+
+    test "rejects the wrong number of values or unsupported values" do
+      query = Query.prepare("SELECT {a:UInt64} AS a")
+
+      assert_raise ArgumentError, fn -> Query.bind_slots(query, {1, 2}) end
+      assert_raise ArgumentError, fn -> Query.bind_slots(query, [:atom]) end
+    end
+  end
+
   describe "Parameterized INSERT" do
     test "INSERT with parameters", %{conn: conn} do
       query =
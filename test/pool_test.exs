@@ -0,0 +1,149 @@
+defmodule Natch.PoolTest do
+  use ExUnit.Case, async: true
+
+  alias Natch.Pool
+  alias Natch.Query
+
+  setup do
+    {:ok, pool} = Pool.start_link(host: "localhost", port: 9000, size: 2)
+
+    on_exit(fn ->
+      if Process.alive?(pool), do: Process.exit(pool, :normal)
+    end)
+
+    {:ok, pool: pool}
+  end
+
+  test "runs queries", %{pool: pool} do
+    assert {:ok, %{x: [1]}} = Pool.select_cols(pool, "SELECT 1 AS x")
+    assert {:ok, [%{x: 1}]} = Pool.select_rows(pool, "SELECT 1 AS x")
+    assert :ok = Pool.execute(pool, "SELECT 1")
+  end
+
+  test "runs parameterized queries", %{pool: pool} do
+    query = Query.new("SELECT {n:UInt64} AS n") |> Query.bind(:n, 7)
+
+    assert {:ok, %{n: [7]}} = Pool.select_cols(pool, query)
+  end
+
+  test "inserts columns", %{pool: pool} do
+    table = "pool_test_#{System.unique_integer([:positive])}"
+    :ok = Pool.execute(pool, "CREATE TABLE #{table} (id UInt64) ENGINE = Memory")
+
+    assert :ok = Pool.insert_cols(pool, table, %{id: [1, 2, 3]}, id: :uint64)
+    assert {:ok, %{c: [3]}} = Pool.select_cols(pool, "SELECT count() AS c FROM #{table}")
+
+    :ok = Pool.execute(pool, "DROP TABLE #{table}")
+  end
+
+  test "builds results that span many blocks in order", %{pool: pool} do
+    sql = "SELECT number AS n FROM numbers(50000) ORDER BY n SETTINGS max_block_size = 1000"
+
+    assert {:ok, %{n: values}} = Pool.select_cols(pool, sql)
+    assert values == Enum.to_list(0..49_999)
+
+    assert {:ok, rows} = Pool.select_rows(pool, sql)
+    assert length(rows) == 50_000
+    assert hd(rows) == %{n: 0} and List.last(rows) == %{n: 49_999}
+  end
+
+  test "server errors are returned and leave the pool usable", %{pool: pool} do
+    assert {:error, %{type: "server"}} = Pool.select_cols(pool, "SELECT * FROM nonexistent")
+    assert {:ok, %{x: [1]}} = Pool.select_cols(pool, "SELECT 1 AS x")
+  end
+
+  test "runs queries from many processes concurrently", %{pool: pool} do
+    results =
+      1..20
+      |> Task.async_stream(fn i -> Pool.select_cols(pool, "SELECT #{i} AS i") end)
+      |> Enum.map(fn {:ok, result} -> result end)
+
+    assert results == Enum.map(1..20, &{:ok, %{i: [&1]}})
+  end
+
+  test "times out when every client is busy" do
+    {:ok, pool} = Pool.start_link(host: "localhost", port: 9000, size: 1, checkout_timeout: 50)
+
+    Pool.checkout(pool, fn _client ->
+      assert {:error, :checkout_timeout} = Pool.select_cols(pool, "SELECT 1")
+    end)
+
+    assert {:ok, _} = Pool.select_cols(pool, "SELECT 1")
+    Pool.stop(pool)
+  end
+
+  test "queued callers get a client when it is checked in" do
+    {:ok, pool} = Pool.start_link(host: "localhost", port: 9000, size: 1)
+    parent = self()
+
+    holder =
+      Task.async(fn ->
+        Pool.checkout(pool, fn _client ->
+          send(parent, :checked_out)
+          Process.sleep(200)
+        end)
+      end)
+
+    assert_receive :checked_out
+    waiters = for i <- 1..5, do: Task.async(fn -> Pool.select_cols(pool, "SELECT #{i} AS i") end)
+
+    Task.await(holder)
+    assert Task.await_many(waiters) == Enum.map(1..5, &{:ok, %{i: [&1]}})
+    Pool.stop(pool)
+  end
+
+  test "stops queries at the deadline and keeps the client", %{pool: pool} do
+    sql = "SELECT sum(number) AS s FROM numbers(100000000000)"
+
+    assert {:error, :timeout} = Pool.select_cols(pool, sql, timeout: 300)
+    assert {:ok, %{x: [1]}} = Pool.select_cols(pool, "SELECT 1 AS x")
+    assert_raise ArgumentError, fn -> Pool.select_cols(pool, "SELECT 1", timeout: 0) end
+  end
+
+  test "emits query telemetry", %{pool: pool} do
+    ref = make_ref()
+    parent = self()
+
+    :telemetry.attach(
+      "pool-test-#{inspect(ref)}",
+      [:natch, :query, :stop],
+      fn _event, measurements, metadata, _ -> send(parent, {ref, measurements, metadata}) end,
+      nil
+    )
+
+    assert {:ok, %{x: [1]}} = Pool.select_cols(pool, "SELECT 1 AS x")
+    assert_receive {^ref, %{rows: 1}, %{kind: :select_cols, query: "SELECT 1 AS x"}}
+    :telemetry.detach("pool-test-#{inspect(ref)}")
+  end
+
+  test "health check reclaims clients of dead processes", %{pool: pool} do
+    for _ <- 1..2 do
+      pid = spawn(fn -> Pool.checkout(pool, fn _ -> Process.sleep(:infinity) end) end)
+      Process.sleep(50)
+      Process.exit(pid, :kill)
+    end
+
+    send(pool, :health_check)
+    # Synchronize with the pool process
+    :sys.get_state(pool)
+
+    assert {:ok, %{x: [1]}} = Pool.select_cols(pool, "SELECT 1 AS x")
+  end
+
+  test "health check cancels the query of a dead caller" do
+    {:ok, pool} = Pool.start_link(host: "localhost", port: 9000, size: 1)
+    sql = "SELECT sum(number) AS s FROM numbers(100000000000)"
+
+    pid = spawn(fn -> Pool.select_cols(pool, sql) end)
+    Process.sleep(200)
+    Process.exit(pid, :kill)
+
+    send(pool, :health_check)
+    :sys.get_state(pool)
+
+    {micros, result} = :timer.tc(fn -> Pool.select_cols(pool, "SELECT 1 AS x") end)
+    assert {:ok, %{x: [1]}} = result
+    assert micros < 5_000_000
+    Pool.stop(pool)
+  end
+end
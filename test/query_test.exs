@@ -290,6 +290,32 @@ defmodule Natch.QueryTest do
       assert Enum.any?(result, fn r -> r.id == 10_000 && r.value == 20_000 end)
     end
 
+    test "decodes 8-bit columns of large blocks", %{conn: conn} do
+      sql = """
+      SELECT toUInt8(number % 256) AS u, toInt8(number % 256 - 128) AS i,
+             if(number % 7 = 0, NULL, toUInt8(number % 200)) AS nu
+      FROM numbers(2000) ORDER BY number
+      """
+
+      assert {:ok, cols} = Natch.select_cols(conn, sql)
+      assert cols.u == Enum.map(0..1999, &rem(&1, 256))
+      assert cols.i == Enum.map(0..1999, &(rem(&1, 256) - 128))
+      assert cols.nu == Enum.map(0..1999, &if(rem(&1, 7) == 0, do: nil, else: rem(&1, 200)))
+    end
+
+    test "formats UUIDs", %{conn: conn} do
+      sql = """
+      SELECT toUUID('550e8400-e29b-41d4-a716-446655440000') AS a,
+             toUUID('ffffffff-0000-0001-abcd-0123456789ef') AS b,
+             toUUID('00000000-0000-0000-0000-000000000000') AS c
+      """
+
+      assert {:ok, [row]} = Natch.select_rows(conn, sql)
+      assert row.a == "550e8400-e29b-41d4-a716-446655440000"
+      assert row.b == "ffffffff-0000-0001-abcd-0123456789ef"
+      assert row.c == "00000000-0000-0000-0000-000000000000"
+    end
+
     test "returns error for invalid query", %{conn: conn, table: _table} do
       result = Natch.select_rows(conn, "SELECT * FROM nonexistent_table")
       assert {:error, _reason} = result
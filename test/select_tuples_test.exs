@@ -0,0 +1,61 @@
+defmodule Natch.SelectTuplesTest do
+  use ExUnit.Case, async: true
+
+  alias Natch.Query
+
+  setup do
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+
+    on_exit(fn ->
+      if Process.alive?(conn), do: Process.exit(conn, :normal)
+    end)
+
+    {:ok, conn: conn}
+  end
+
+  test "returns the column names once and a tuple per row", %{conn: conn} do
+    sql = "SELECT number AS n, toString(number) AS s FROM numbers(3)"
+    assert {:ok, {[:n, :s], rows}} = Natch.select_tuples(conn, sql)
+
+    assert rows == [{0, "0"}, {1, "1"}, {2, "2"}]
+  end
+
+  test "matches select_rows across blocks", %{conn: conn} do
+    sql = """
+    SELECT number AS n, number % 3 = 0 ? NULL : number AS m, [number, 1] AS a
+    FROM numbers(25000)
+    SETTINGS max_block_size = 10000
+    """
+
+    {:ok, maps} = Natch.select_rows(conn, sql)
+    assert {:ok, {columns, tuples}} = Natch.select_tuples(conn, sql)
+
+    assert columns == [:n, :m, :a]
+    assert Enum.map(maps, &{&1.n, &1.m, &1.a}) == tuples
+  end
+
+  test "takes a parameterized query", %{conn: conn} do
+    query =
+      Query.new("SELECT number AS n FROM numbers(10) WHERE number < {max:UInt64}")
+      |> Query.bind(:max, 2)
+
+    assert {:ok, {[:n], [{0}, {1}]}} = Natch.select_tuples(conn, query)
+  end
+
+  test "returns no columns for an empty result", %{conn: conn} do
+    assert {:ok, {[], []}} = Natch.select_tuples(conn, "SELECT number FROM numbers(0)")
+  end
+
+  test "uses less heap than row maps", %{conn: conn} do
+    sql = "SELECT number AS a, number AS b, number AS c, number AS d FROM numbers(10000)"
+
+    {:ok, maps} = Natch.select_rows(conn, sql)
+    {:ok, {_columns, tuples}} = Natch.select_tuples(conn, sql)
+
+    assert :erts_debug.flat_size(tuples) < :erts_debug.flat_size(maps) * 0.6
+  end
+
+  test "returns errors", %{conn: conn} do
+    assert {:error, _} = Natch.select_tuples(conn, "SELECT * FROM no_such_table_xyz")
+  end
+end
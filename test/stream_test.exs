@@ -0,0 +1,129 @@
+defmodule Natch.StreamTest do
+  use ExUnit.Case, async: true
+
+  alias Natch.Query
+
+  setup do
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+
+    on_exit(fn ->
+      if Process.alive?(conn), do: Process.exit(conn, :normal)
+    end)
+
+    {:ok, conn: conn}
+  end
+
+  @multi_block_sql """
+  SELECT number AS n, toString(number) AS s
+  FROM system.numbers
+  LIMIT 100000
+  SETTINGS max_block_size = 10000
+  """
+
+  describe "stream_cols/3" do
+    test "delivers one column map per block", %{conn: conn} do
+      blocks = conn |> Natch.stream_cols(@multi_block_sql) |> Enum.to_list()
+
+      assert length(blocks) > 1
+      assert Enum.all?(blocks, &(Map.keys(&1) |> Enum.sort() == [:n, :s]))
+      assert Enum.all?(blocks, &(length(&1.n) <= 10_000))
+    end
+
+    test "concatenated blocks equal the full result", %{conn: conn} do
+      {:ok, full} = Natch.select_cols(conn, @multi_block_sql)
+
+      streamed =
+        conn
+        |> Natch.stream_cols(@multi_block_sql, window: 1)
+        |> Enum.reduce(%{n: [], s: []}, fn block, acc ->
+          %{n: acc.n ++ block.n, s: acc.s ++ block.s}
+        end)
+
+      assert streamed == full
+    end
+
+    test "halting early cancels the query and keeps the connection usable", %{conn: conn} do
+      [first] = conn |> Natch.stream_cols(@multi_block_sql) |> Enum.take(1)
+
+      assert hd(first.n) == 0
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "leaves no stream messages in the mailbox", %{conn: conn} do
+      _ = conn |> Natch.stream_cols(@multi_block_sql) |> Enum.take(2)
+
+      refute_received _
+    end
+
+    test "streams a parameterized query", %{conn: conn} do
+      query =
+        Query.new("SELECT number AS n FROM system.numbers WHERE number < {limit:UInt64} LIMIT 10")
+        |> Query.bind(:limit, 5)
+
+      values = conn |> Natch.stream_cols(query) |> Enum.flat_map(& &1.n)
+
+      assert values == [0, 1, 2, 3, 4]
+    end
+
+    test "empty result yields no blocks", %{conn: conn} do
+      assert [] == conn |> Natch.stream_cols("SELECT 1 AS x WHERE 0") |> Enum.to_list()
+    end
+
+    test "raises on query error", %{conn: conn} do
+      assert_raise RuntimeError, ~r/Query failed/, fn ->
+        conn |> Natch.stream_cols("SELECT * FROM nonexistent_table") |> Enum.to_list()
+      end
+
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "delivers the same blocks with and without prefetch", %{conn: conn} do
+      prefetched = conn |> Natch.stream_cols(@multi_block_sql, prefetch: 4) |> Enum.to_list()
+      inline = conn |> Natch.stream_cols(@multi_block_sql, prefetch: 0) |> Enum.to_list()
+
+      assert prefetched == inline
+    end
+
+    test "halting early with prefetch keeps the connection usable", %{conn: conn} do
+      [first] = conn |> Natch.stream_cols(@multi_block_sql, prefetch: 4) |> Enum.take(1)
+
+      assert hd(first.n) == 0
+      refute_received _
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "raises a decode error from the prefetch thread", %{conn: conn} do
+      assert_raise RuntimeError, ~r/Query failed/, fn ->
+        conn |> Natch.stream_cols("SELECT toInt128(1) AS x", prefetch: 1) |> Enum.to_list()
+      end
+
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "raises once the stream runs past its :timeout", %{conn: conn} do
+      assert_raise RuntimeError, ~r/Query failed/, fn ->
+        conn
+        |> Natch.stream_cols(@multi_block_sql, window: 1, timeout: 200)
+        |> Stream.each(fn _ -> Process.sleep(300) end)
+        |> Stream.run()
+      end
+
+      refute_received _
+      assert {:ok, %{x: [1]}} = Natch.select_cols(conn, "SELECT 1 AS x")
+    end
+
+    test "leaves the connection process responsive while streaming", %{conn: conn} do
+      [_first] =
+        conn
+        |> Natch.stream_cols(@multi_block_sql, window: 1)
+        |> Stream.each(fn _ -> assert {:ok, _client} = Natch.Connection.get_client(conn) end)
+        |> Enum.take(1)
+    end
+
+    test "rejects a zero window", %{conn: conn} do
+      assert_raise ArgumentError, fn ->
+        conn |> Natch.stream_cols("SELECT 1", window: 0) |> Enum.to_list()
+      end
+    end
+  end
+end
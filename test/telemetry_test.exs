@@ -0,0 +1,107 @@
+defmodule Natch.TelemetryTest do
+  use ExUnit.Case, async: true
+
+  alias Natch.Query
+
+  setup context do
+    {:ok, conn} = Natch.start_link(host: "localhost", port: 9000)
+    handler = "natch-telemetry-#{inspect(context.test)}"
+    events = [[:natch, :query, :stop], [:natch, :query, :exception]]
+    test_pid = self()
+
+    :telemetry.attach_many(
+      handler,
+      events,
+      fn event, measurements, metadata, _config ->
+        if sql(metadata.query) == context.test_query,
+          do: send(test_pid, {:telemetry, event, measurements, metadata})
+      end,
+      nil
+    )
+
+    on_exit(fn ->
+      :telemetry.detach(handler)
+      if Process.alive?(conn), do: Process.exit(conn, :normal)
+    end)
+
+    {:ok, conn: conn}
+  end
+
+  # Tests run concurrently, so each handler only forwards its own test's query
+  defp sql(%Query{sql: sql}), do: sql
+  defp sql(sql), do: sql
+
+  @tag test_query: "SELECT number AS n, toString(number) AS s FROM numbers(3000)"
+  test "emits counters for SELECT results", %{conn: conn, test_query: sql} do
+    assert {:ok, %{n: n}} = Natch.select_cols(conn, sql)
+    assert length(n) == 3000
+
+    assert_receive {:telemetry, [:natch, :query, :stop], measurements, metadata}
+
+    assert measurements.rows == 3000
+    assert measurements.blocks >= 1
+    assert measurements.result_bytes > 0
+    assert measurements.term_bytes > 0
+    assert measurements.duration > 0
+    assert measurements.receive_ns > 0
+    assert measurements.decode_ns > 0
+
+    assert metadata.kind == :select_cols
+    assert %{"UInt64" => _, "String" => _} = metadata.decode_ns_by_type
+  end
+
+  @tag test_query: "SELECT toFloat64(number) AS f FROM numbers(10)"
+  test "emits events for every result format", %{conn: conn, test_query: sql} do
+    assert {:ok, _} = Natch.select_rows(conn, sql)
+    assert_receive {:telemetry, [:natch, :query, :stop], %{rows: 10}, %{kind: :select_rows}}
+
+    assert {:ok, _} = Natch.select_packed(conn, sql)
+    assert_receive {:telemetry, [:natch, :query, :stop], %{rows: 10}, %{kind: :select_packed}}
+
+    assert {:ok, _} = Natch.select_arrow(conn, sql)
+    assert_receive {:telemetry, [:natch, :query, :stop], %{rows: 10}, %{kind: :select_arrow}}
+  end
+
+  @tag test_query: "SELECT number AS n, toString(number) AS s FROM numbers(5000)"
+  test "counts decoding for streamed blocks", %{conn: conn, test_query: sql} do
+    assert conn |> Natch.stream_cols(sql) |> Enum.map(&length(&1.n)) |> Enum.sum() == 5000
+
+    assert_receive {:telemetry, [:natch, :query, :stop], measurements, metadata}
+    assert metadata.kind == :stream_cols
+    assert measurements.term_bytes > 0
+    assert measurements.decode_ns > 0
+    assert %{"UInt64" => _, "String" => _} = metadata.decode_ns_by_type
+  end
+
+  @tag test_query: "SELECT count() FROM numbers(1000)"
+  test "emits events for execute", %{conn: conn, test_query: sql} do
+    assert :ok = Natch.execute(conn, sql)
+
+    assert_receive {:telemetry, [:natch, :query, :stop], measurements, %{kind: :execute}}
+    assert measurements.read_rows == 1000
+  end
+
+  @tag test_query: "SELECT * FROM natch_telemetry_missing_table"
+  test "emits exceptions for failed queries", %{conn: conn, test_query: sql} do
+    assert {:error, _} = Natch.select_cols(conn, sql)
+
+    assert_receive {:telemetry, [:natch, :query, :exception], %{duration: _}, metadata}
+    assert %{type: "server"} = metadata.reason
+  end
+
+  @tag test_query: "SELECT 'compressed' AS c"
+  test "labels events with the result codec", %{conn: conn, test_query: sql} do
+    assert {:ok, _} = Natch.select_rows(conn, sql)
+
+    assert_receive {:telemetry, [:natch, :query, :stop], _measurements, metadata}
+    assert %{compression: :lz4, compression_level: 0} = metadata
+  end
+
+  @tag test_query: "SELECT {n:UInt32} AS n"
+  test "labels parameterized queries with the query", %{conn: conn, test_query: sql} do
+    query = Query.new(sql) |> Query.bind(:n, 7)
+
+    assert {:ok, %{n: [7]}} = Natch.select_cols(conn, query)
+    assert_receive {:telemetry, [:natch, :query, :stop], %{rows: 1}, %{query: ^query}}
+  end
+end